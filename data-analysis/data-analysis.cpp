@@ -5,96 +5,26 @@
 #define LOGGING 0
 #include "utils/logger.hpp"
 #include "data-analysis/dataparser.hpp"
+#include "topology/ft_paths.hpp"
 
 
 /**
  * Get the route for a given packet in fat-tree topology.
+ * Same paths as the source-routed pkts of the simulator (see topology/ft_paths.hpp).
  *
  * @param source        Host ID of the source 
  * @param destination   Host ID of the destination
- * @param fatTreeTopoK  k value for the fat-tree topology
+ * @param pathCache     Paths of the fat-tree topology
  *
  * @return route        List of switch IDs in the route as a vector
  */
-std::vector<switch_id_t> getRoute (host_id_t source, host_id_t destination, ft_scale_t fatTreeTopoK) {
-    std::vector<switch_id_t> route;
-
-    const uint64_t k = fatTreeTopoK;
-    const uint64_t kBy2 = fatTreeTopoK / 2;
-    const uint64_t kBy2WholeSquare = kBy2 * kBy2;
-
-    host_id_t sourcePod = source / kBy2WholeSquare;
-    host_id_t destinationPod = destination / kBy2WholeSquare;
-
-#ifdef DEBUG
-    debug_print("Source Pod: {}", sourcePod);
-    debug_print("Destination Pod: {}", destinationPod);
-#endif
-
-    // get ToR switch ID for first hop
-    host_id_t podLocalSourceHostID = source % kBy2WholeSquare;  // between 0 to (kBy2WholeSquare - 1)
-    switch_id_t podLocalSourceToRSwitchID = podLocalSourceHostID / kBy2;    // between 0 to (k/2 - 1)
-    switch_id_t sourceToRSwitchID = (sourcePod * k) + podLocalSourceToRSwitchID; 
-    host_id_t podLocalDestinationHostID = destination % kBy2WholeSquare;  // between 0 to (kBy2WholeSquare - 1)
-    switch_id_t podLocalDestinationToRSwitchID = podLocalDestinationHostID / kBy2;    // between 0 to (k/2 - 1)
-    switch_id_t destinationToRSwitchID = (destinationPod * k) + podLocalDestinationToRSwitchID; 
-
-    route.push_back(sourceToRSwitchID);
+std::vector<switch_id_t> getRoute (host_id_t source, host_id_t destination, FtPathCache &pathCache) {
+    std::vector<switch_id_t> route = pathCache.getSwitches(source, destination);
 
 #ifdef DEBUG
-    debug_print("Pod Local Source ID: {}", podLocalSourceHostID);
-    debug_print("Pod Local Source ToR Switch ID: {}", podLocalSourceToRSwitchID);
-    debug_print("Source ToR Switch ID: s{}", sourceToRSwitchID);
-#endif
-
-    if (destinationToRSwitchID == sourceToRSwitchID) {
-        return route;
+    for (auto it = route.begin(); it != route.end(); it++) {
+        debug_print("s{}", *it);
     }
-
-    host_id_t rackLocalDestinationHostID = destination % kBy2;
-    switch_id_t podLocalSourceAggregationSwitchID = (sourceToRSwitchID + rackLocalDestinationHostID) % kBy2;   // between 0 to (k/2 - 1)
-    switch_id_t sourceAggregationSwitchID = (sourcePod * k) + kBy2 + podLocalSourceAggregationSwitchID;
-
-    route.push_back(sourceAggregationSwitchID);
-
-#ifdef DEBUG
-    debug_print("Pod Local Source Aggregation Switch ID: {}", podLocalSourceAggregationSwitchID);
-    debug_print("Source Aggregation Switch ID: s{}", sourceAggregationSwitchID);
-#endif
-
-    if (destinationPod == sourcePod) {
-
-#ifdef DEBUG
-        debug_print("Pod Local Destination ID: {}", podLocalDestinationHostID);
-        debug_print("Pod Local Destination ToR Switch ID: {}", podLocalDestinationToRSwitchID);
-        debug_print("Destination ToR Switch ID: s{}", destinationToRSwitchID);
-#endif
-        route.push_back(destinationToRSwitchID);
-        return route;
-    }
-
-    switch_id_t localCoreSwitchID = (podLocalSourceAggregationSwitchID + rackLocalDestinationHostID) % kBy2;
-    switch_id_t coreSwitchID = (k*k) + (podLocalSourceAggregationSwitchID * kBy2) + localCoreSwitchID;
-
-    route.push_back(coreSwitchID);
-
-#ifdef DEBUG
-    debug_print("Local Core Switch ID: {}", localCoreSwitchID);
-    debug_print("Core Switch ID: s{}", coreSwitchID);
-#endif
-
-    switch_id_t podLocalDestinationAggergationSwitchID = podLocalSourceAggregationSwitchID;
-    switch_id_t destinationAggregationSwitchID = (destinationPod * k) + kBy2 + podLocalDestinationAggergationSwitchID;
-
-    route.push_back(destinationAggregationSwitchID);
-    route.push_back(destinationToRSwitchID);
-
-#ifdef DEBUG
-    debug_print("Pod Local Destination Aggregation Switch ID: {}", podLocalDestinationAggergationSwitchID);
-    debug_print("Destination Aggregation Switch ID: s{}", destinationAggregationSwitchID);
-    debug_print("Pod Local Destination ID: {}", podLocalDestinationHostID);
-    debug_print("Pod Local Destination ToR Switch ID: {}", podLocalDestinationToRSwitchID);
-    debug_print("Destination ToR Switch ID: s{}", destinationToRSwitchID);
 #endif
 
     return route;
@@ -184,14 +114,15 @@ int main(int argc, char *argv[]) {
 
     ndebug_print_yellow("Welcome to data analysis!");
 
-    int startTriggerID = 0, endTriggerID = 2;
+    trigger_id_t startTriggerID = 0, endTriggerID = 2;
     if (argc > 1) {
-        startTriggerID = std::stoi(argv[1]);
-        endTriggerID = std::stoi(argv[2]);
+        startTriggerID = std::stoul(argv[1]);
+        endTriggerID = std::stoul(argv[2]);
     }
     ndebug_print("Processing triggers from {} to {}.", startTriggerID, endTriggerID);
 
     Config syndbConfig;
+    FtPathCache pathCache(syndbConfig.fatTreeTopoK);
     DataParser dataparser(PREFIX_FILE_PATH, PREFIX_STRING_FOR_DATA_FILES, syndbConfig.numSwitches);
     dataparser.getTriggerInfo(syndbConfig.numSwitches);
 
@@ -271,7 +202,7 @@ int main(int argc, char *argv[]) {
 
                     auto route = getRoute(iteratorForpRecordWindowForTriggerSwitch->second.srcHost,
                                         iteratorForpRecordWindowForTriggerSwitch->second.dstHost,
-                                        syndbConfig.fatTreeTopoK);
+                                        pathCache);
 
                     int indexOfTriggerSwitch = -1, indexOfCurrentSwitch = -1;
                     for (int routeIteratorIndex = 0; routeIteratorIndex < route.size(); routeIteratorIndex++) {
@@ -20,7 +20,7 @@ struct PacketInfo {
 };
 
 struct TriggerInfo {
-    int triggerId;
+    trigger_id_t triggerId;
 
     switch_id_t originSwitch;
     sim_time_t triggerTime;
@@ -6,7 +6,7 @@
 
 void showFatTreeTopoRoutingTables(){
     
-    std::shared_ptr<FattreeTopology> fattreetopo = std::dynamic_pointer_cast<FattreeTopology>(syndbSim.topo); 
+    std::shared_ptr<FattreeTopology> fattreetopo = std::dynamic_pointer_cast<FattreeTopology>(syndbSim->topo); 
 
     debug_print_yellow("\n-------------  Routing Tables [Core Switches]  -------------");
     auto it = fattreetopo->coreSwitches.begin();
@@ -49,13 +49,151 @@ void showFatTreeTopoRoutingTables(){
 }
 
 
+void testFatTreeRouting(){
+
+    std::shared_ptr<FattreeTopology> fattreetopo = std::dynamic_pointer_cast<FattreeTopology>(syndbSim->topo);
+    uint64_t numChecked = 0;
+
+    auto check = [&numChecked](Switch* sw, host_id_t dstHost, Switch* arithmeticNextHop, Switch* tableNextHop){
+        if(arithmeticNextHop != tableNextHop){
+            std::string msg = fmt::format("Switch {} routes pkts to host {} to switch {}, but its routing table says {}", sw->id, dstHost, arithmeticNextHop->id, tableNextHop->id);
+            throw std::logic_error(msg);
+        }
+        numChecked++;
+    };
+
+    for(host_id_t dstHost = 0; dstHost < fattreetopo->nextHostId; dstHost++){
+        switch_id_t dstTorId = fattreetopo->getTorId(dstHost);
+
+        for(auto podIt = fattreetopo->pods.begin(); podIt != fattreetopo->pods.end(); podIt++){
+            for(auto it = (*podIt)->torSwitches.begin(); it != (*podIt)->torSwitches.end(); it++){
+                std::shared_ptr<SwitchFtTor> torSwitch = std::dynamic_pointer_cast<SwitchFtTor>(*it);
+
+                if(torSwitch->id == dstTorId){
+                    if(ftGetRackId(dstHost, fattreetopo->k) != torSwitch->rackId || torSwitch->hostPorts[ftModHalfK(dstHost, fattreetopo->k)] != torSwitch->neighborHostTable.at(dstHost)){
+                        std::string msg = fmt::format("ToR switch {} has no port to its host {}", torSwitch->id, dstHost);
+                        throw std::logic_error(msg);
+                    }
+                    continue;
+                }
+                check(torSwitch.get(), dstHost, torSwitch->ports[torSwitch->getUplinkPort(dstHost)].nextSwitch, torSwitch->getNextHop(dstHost));
+            }
+
+            for(auto it = (*podIt)->aggrSwitches.begin(); it != (*podIt)->aggrSwitches.end(); it++){
+                std::shared_ptr<SwitchFtAggr> aggrSwitch = std::dynamic_pointer_cast<SwitchFtAggr>(*it);
+
+                // Same as the table-driven SwitchFtAggr::routeScheduleNormalPkt() was: down if the dst ToR is a neighbor
+                Switch* tableNextHop;
+                if(aggrSwitch->neighborSwitchTable.count(dstTorId) > 0)
+                    tableNextHop = fattreetopo->getSwitchById(dstTorId);
+                else
+                    tableNextHop = aggrSwitch->getNextHop(dstHost);
+
+                check(aggrSwitch.get(), dstHost, aggrSwitch->ports[aggrSwitch->getNextHopPort(dstHost)].nextSwitch, tableNextHop);
+            }
+        }
+
+        for(auto it = fattreetopo->coreSwitches.begin(); it != fattreetopo->coreSwitches.end(); it++){
+            std::shared_ptr<SwitchFtCore> coreSwitch = std::dynamic_pointer_cast<SwitchFtCore>(*it);
+            check(coreSwitch.get(), dstHost, coreSwitch->ports[coreSwitch->getNextHopPort(dstHost)].nextSwitch, coreSwitch->getNextHop(dstHost));
+        }
+    }
+
+    debug_print("Closed-form FatTree routing matches the routing tables: {} (switch, dst host) pairs", numChecked);
+}
+
+void testFatTreePaths(){
+
+    std::shared_ptr<FattreeTopology> fattreetopo = std::dynamic_pointer_cast<FattreeTopology>(syndbSim->topo);
+    FtPathCache pathCache(fattreetopo->k);
+    host_id_t hostsPerRack = fattreetopo->k / 2;
+    uint64_t numChecked = 0;
+
+    // One src host per rack is enough: the paths only depend on the src rack
+    for(host_id_t srcHost = 0; srcHost < fattreetopo->nextHostId; srcHost += hostsPerRack){
+        for(host_id_t dstHost = 0; dstHost < fattreetopo->nextHostId; dstHost++){
+            ft_path_t path = pathCache.getPath(srcHost / hostsPerRack, dstHost);
+            std::vector<switch_id_t> switches = pathCache.getSwitches(srcHost, dstHost);
+
+            // Follow the ports of the path on the switches, like routeScheduleNormalPktOnPath() does
+            Switch* sw = fattreetopo->getSwitchById(fattreetopo->getTorId(srcHost));
+            unsigned int hop = 0;
+            for(; hop < switches.size(); hop++){
+                if(sw == NULL || sw->id != switches[hop]){
+                    std::string msg = fmt::format("Path {} --> {}: hop {} is not on switch {}, which FtPathCache::getSwitches() says", srcHost, dstHost, hop, switches[hop]);
+                    throw std::logic_error(msg);
+                }
+
+                ft_port_t port = FtPathCache::getHopPort(path, hop);
+                if(sw->type == SwitchType::FtTor && port < hostsPerRack){
+                    if(static_cast<SwitchFtTor*>(sw)->hostPorts[port] != sw->neighborHostTable.at(dstHost)){
+                        std::string msg = fmt::format("Path {} --> {} ends on port {} of ToR switch {}, not at the dst host", srcHost, dstHost, port, sw->id);
+                        throw std::logic_error(msg);
+                    }
+                    sw = NULL;
+                    continue;
+                }
+
+                if(sw->type == SwitchType::FtCore)
+                    sw = static_cast<SwitchFtCore*>(sw)->ports[port].nextSwitch;
+                else
+                    sw = static_cast<SwitchFtTorAggr*>(sw)->ports[port].nextSwitch;
+            }
+
+            if(sw != NULL){
+                std::string msg = fmt::format("Path {} --> {} does not reach the dst host in {} hops", srcHost, dstHost, hop);
+                throw std::logic_error(msg);
+            }
+            numChecked++;
+        }
+    }
+
+    debug_print("FatTree source routes reach their dst hosts: {} (src rack, dst host) paths", numChecked);
+}
+
+void testFileTopoRouting(){
+
+    std::shared_ptr<FileTopology> fileTopo = std::dynamic_pointer_cast<FileTopology>(syndbSim->topo);
+    const NextHopTable &nextHops = fileTopo->nextHops;
+    uint64_t numChecked = 0, numHops = 0;
+
+    for(switch_id_t src = 0; src < nextHops.numSwitches; src++){
+        for(switch_id_t dst = 0; dst < nextHops.numSwitches; dst++){
+            switch_id_t dstTorIdx = nextHops.torIdx[dst];
+            if(src == dst || dstTorIdx == noTorIdx || nextHops.torIdx[src] == noTorIdx)
+                continue;
+
+            // Follow the next hop ports, like SwitchGeneric::routeScheduleNormalPkt() does. Shortest paths are loop-free.
+            SwitchGeneric* sw = static_cast<SwitchGeneric*>(fileTopo->getSwitchById(src));
+            unsigned int hop = 0;
+            for(; sw->id != dst && hop < nextHops.numSwitches; hop++){
+                generic_port_t port = nextHops.getPort(sw->id, dstTorIdx);
+                if(port == noNextHopPort || port >= sw->ports.size()){
+                    std::string msg = fmt::format("Path ToR {} --> ToR {}: no next hop port on switch {}", src, dst, sw->id);
+                    throw std::logic_error(msg);
+                }
+                sw = static_cast<SwitchGeneric*>(sw->ports[port].nextSwitch);
+            }
+
+            if(sw->id != dst){
+                std::string msg = fmt::format("Path ToR {} --> ToR {} does not reach the dst ToR in {} hops", src, dst, hop);
+                throw std::logic_error(msg);
+            }
+            numChecked++;
+            numHops += hop;
+        }
+    }
+
+    debug_print("Next hop tables lead every ToR to every other ToR: {} paths, {:.2f} hops on average", numChecked, numChecked ? (double)numHops / numChecked : 0.0);
+}
+
 void showSimpleTopoRingBuffers(){
     #if RING_BUFFER
     switch_p s0, s1, s2;
     
-    s0 = syndbSim.topo->getSwitchById(0);
-    s1 = syndbSim.topo->getSwitchById(1);
-    s2 = syndbSim.topo->getSwitchById(2);
+    s0 = syndbSim->topo->getSwitchById(0);
+    s1 = syndbSim->topo->getSwitchById(1);
+    s2 = syndbSim->topo->getSwitchById(2);
 
     debug_print_yellow("\nRing buffer for s0:");
     s0->ringBuffer.printRingBuffer();
@@ -79,7 +217,7 @@ void showSimpleTopoRingBuffers(){
 
 void testRingBufferOps(){
     #if RING_BUFFER
-    switch_p s0 = syndbSim.topo->getSwitchById(0);
+    switch_p s0 = syndbSim->topo->getSwitchById(0);
 
     for(int i=1; i <= 8; i++){
         s0->ringBuffer.insertPrecord(i, i); 
@@ -89,15 +227,47 @@ void testRingBufferOps(){
     #endif
 }
 
+void testTimingWheelOps(){
+    const sim_time_t increment = syndbConfig.timeIncrementNs;
+    const sim_time_t maxTime = 100000000; // 100ms. Exercises the cascading of levels 1 and 2
+    
+    TimingWheel<pktevent_p<normalpkt_p>> wheel(increment);
+    std::vector<pktevent_p<normalpkt_p>> dueEvents;
+    std::default_random_engine randTime(1);
+    uint64_t numDue = 0;
+
+    for(int i=0; i < 10000; i++){
+        pktevent_p<normalpkt_p> event = pktevent_p<normalpkt_p>(new PktEvent<normalpkt_p>());
+        event->pktForwardTime = randTime() % maxTime;
+        wheel.insert(event->pktForwardTime, event);
+    }
+
+    for(sim_time_t now = 0; !wheel.empty(); now += increment){
+        dueEvents.clear();
+        wheel.advance(now, dueEvents);
+
+        for(auto it = dueEvents.begin(); it != dueEvents.end(); it++){
+            sim_time_t t = (*it)->pktForwardTime;
+            if(t > now || (now >= increment && t <= now - increment)){
+                std::string msg = fmt::format("TimingWheel returned event of time {}ns at time {}ns", t, now);
+                throw std::logic_error(msg);
+            }
+        }
+        numDue += dueEvents.size();
+    }
+
+    debug_print("TimingWheel returned all {} events on time", numDue);
+}
+
 void addTriggerPkts(){
 
     if(syndbConfig.topoType == TopologyType::Simple){    
         const sim_time_t increment = 3000;
         static sim_time_t nextSendTime = 0;
 
-        Switch* srcSwitch = syndbSim.topo->getSwitchById(0); 
+        Switch* srcSwitch = syndbSim->topo->getSwitchById(0); 
 
-        if(syndbSim.currTime >= nextSendTime){
+        if(syndbSim->currTime >= nextSendTime){
 
             srcSwitch->generateTrigger(); 
 
@@ -109,7 +279,7 @@ void addTriggerPkts(){
 
         if(generatedAlready == false){
             // Generate a single trigger on switchID 2
-            syndbSim.topo->getSwitchById(9)->generateTrigger();
+            syndbSim->topo->getSwitchById(9)->generateTrigger();
             generatedAlready = true;
         }
     }
@@ -118,33 +288,19 @@ void addTriggerPkts(){
 
 void checkRemainingQueuingAtLinks(){
     // Checking queueing on all the links
-    auto it1 = syndbSim.topo->torLinkVector.begin();
-    debug_print_yellow("nextPktSendTime on ToR links at time {}ns", syndbSim.currTime);
-    for (it1; it1 != syndbSim.topo->torLinkVector.end(); it1++){
-        debug_print("Link ID {}: towards host: {} | towards tor: {}", (*it1)->id, (*it1)->next_idle_time_to_host, (*it1)->next_idle_time_to_tor);
+    auto it1 = syndbSim->topo->torLinks.begin();
+    debug_print_yellow("nextPktSendTime on ToR links at time {}ns", syndbSim->currTime);
+    for (it1; it1 != syndbSim->topo->torLinks.end(); it1++){
+        debug_print("Link ID {}: towards host: {} | towards tor: {}", it1->id, it1->next_idle_time_to_host, it1->next_idle_time_to_tor);
     }
 
-    auto it2 = syndbSim.topo->networkLinkVector.begin();
-    debug_print_yellow("nextPktSendTime on Network links at time {}ns", syndbSim.currTime);
-    for (it2; it2 != syndbSim.topo->networkLinkVector.end(); it2++){
-        auto map = (*it2)->next_idle_time;
-
-        auto it3 = map.begin();
-        switch_id_t sw1 = it3->first;
-        sim_time_t dir1 = it3->second;
-        it3++;
-        switch_id_t sw2 = it3->first;
-        sim_time_t dir2 = it3->second;
-        ndebug_print("Link ID {} Normal: towards {}: {} | towards {}: {}", (*it2)->id, sw1, dir1, sw2, dir2);
-
-        auto mapPriority = (*it2)->next_idle_time_priority;
-        auto it4 = mapPriority.begin();
-        sw1 = it4->first;
-        dir1 = it4->second;
-        it4++;
-        sw2 = it4->first;
-        dir2 = it4->second;
-        ndebug_print("Link ID {} Priority: towards {}: {} | towards {}: {}", (*it2)->id, sw1, dir1, sw2, dir2);
+    auto it2 = syndbSim->topo->networkLinks.begin();
+    debug_print_yellow("nextPktSendTime on Network links at time {}ns", syndbSim->currTime);
+    for (it2; it2 != syndbSim->topo->networkLinks.end(); it2++){
+        const linkQueue &q1 = it2->queues[0];
+        const linkQueue &q2 = it2->queues[1];
+        ndebug_print("Link ID {} Normal: towards {}: {} | towards {}: {}", it2->id, q1.dstSwitchId, q1.nextIdleTime, q2.dstSwitchId, q2.nextIdleTime);
+        ndebug_print("Link ID {} Priority: towards {}: {} | towards {}: {}", it2->id, q1.dstSwitchId, q1.nextIdleTimePriority, q2.dstSwitchId, q2.nextIdleTimePriority);
     }
 }
 
@@ -163,14 +319,16 @@ void testSharedPtrDestruction(){
     newPktEvent1->pkt = p1;
     newPktEvent2->pkt = p2;
 
-    syndbSim.NormalPktEventList.push_back(newPktEvent1);
-    syndbSim.NormalPktEventList.push_back(newPktEvent2);    
+    std::list<pktevent_p<normalpkt_p>> eventList;
+
+    eventList.push_back(newPktEvent1);
+    eventList.push_back(newPktEvent2);    
 
     std::list<std::list<pktevent_p<normalpkt_p>>::iterator> toDelete;
 
-    auto it = syndbSim.NormalPktEventList.begin();
+    auto it = eventList.begin();
 
-    while(it != syndbSim.NormalPktEventList.end() ){
+    while(it != eventList.end() ){
         debug_print(fmt::format("Found pkt with id {} inside PktEvent", (*it)->pkt->id));
         toDelete.push_back(it);
 
@@ -181,7 +339,7 @@ void testSharedPtrDestruction(){
     auto it2 = toDelete.begin();
 
     while (it2 != toDelete.end()){
-        syndbSim.NormalPktEventList.erase(*it2);
+        eventList.erase(*it2);
         it2++;
     }
 }
@@ -3,6 +3,7 @@
 
 #include "utils/types.hpp"
 #include "topology/fattree_topology.hpp"
+#include "topology/file_topology.hpp"
 
 /* 
 Iterates over all links (ToR and Network).
@@ -30,6 +31,12 @@ Test basic operations of the ring buffer in Isolation of the main simulation
  */
 void testRingBufferOps();
 
+/* 
+Test the hierarchical TimingWheel in isolation of the main simulation.
+Every item must come out exactly at the first tick >= its time.
+ */
+void testTimingWheelOps();
+
 /* 
 Show the ring buffer states of the 3 switches in SimpleTopo
  */
@@ -40,4 +47,22 @@ Prints routing tables of all switches of a FatTree topo
 */
 void showFatTreeTopoRoutingTables();
 
+/* 
+Checks the closed-form routing of all FatTree switches (egress ports)
+against their routing tables, for every dst host
+*/
+void testFatTreeRouting();
+
+/* 
+Follows the source-routed paths of FtPathCache on the switch ports,
+from every rack to every dst host
+*/
+void testFatTreePaths();
+
+/* 
+Follows the next hop tables of a topology file on the switch ports,
+from every ToR to every other ToR
+*/
+void testFileTopoRouting();
+
 #endif
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <limits>
+#include <stdexcept>
+#include <fmt/core.h>
+#include "simulation/simulation.hpp"
+#include "simulation/config.hpp"
+#include "utils/logger.hpp"
+
+/*
+    What-if branching: the warm-up up to triggerInitialDelay is simulated once, then numWhatIfBranches children
+    are fork()ed from that state (copy-on-write). Only the trigger and incast schedules differ after it.
+*/
+void Simulation::scheduleBranching(){
+    this->branchTime = std::numeric_limits<sim_time_t>::max();
+
+    if(syndbConfig.numWhatIfBranches == 0)
+        return;
+
+    // A restored run may be a branch already, or past the warm-up
+    if(this->branchId != 0 || this->currTime > syndbConfig.triggerInitialDelay){
+        ndebug_print("Run is past the branching point: no what-if branches are forked");
+        return;
+    }
+
+    this->branchTime = syndbConfig.triggerInitialDelay;
+}
+
+/*
+    Called by the main loops at a consistent state, like checkpointAt(). resumeTime is where all the processes continue.
+    The main run (branchId 0) keeps its schedules. Every branch draws new trigger and incast schedules from seeds of its own
+    and dumps to the files of its own prefix, which start as copies of the main run's files.
+    Only the calling thread survives fork(): the logging, step and traffic gen threads are stopped before and started again
+    in every process. PARALLEL_ENGINE: the caller does the same with its PartitionWorkers.
+*/
+void Simulation::forkBranches(sim_time_t resumeTime){
+    this->branchTime = std::numeric_limits<sim_time_t>::max();
+
+    ndebug_print_yellow("Forking {} what-if branches at {}ns", syndbConfig.numWhatIfBranches, resumeTime);
+
+    #if LOGGING
+    std::string prefix = this->pktDumper->prefixStringForFileName;
+    this->pktDumper->closeFiles();
+    #endif
+    #if INTRA_STEP_PARALLEL
+    size_t numStepWorkers = this->stepPool->getNumWorkers();
+    this->stepPool->stop();
+    #endif
+    #if PIPELINED_TRAFFIC_GEN
+    this->trafficPipeline->stop();
+    #endif
+    fflush(stdout); // else every child prints the buffered output again
+
+    for(unsigned int branch = 1; branch <= syndbConfig.numWhatIfBranches; branch++){
+        pid_t pid = fork();
+
+        if(pid < 0){
+            std::string msg = fmt::format("fork() of what-if branch {} failed", branch);
+            throw std::logic_error(msg);
+        }
+
+        if(pid == 0){
+            this->branchId = branch;
+            this->branchPids.clear();
+            break;
+        }
+
+        this->branchPids.push_back(pid);
+    }
+
+    #if LOGGING
+    if(this->branchId == 0)
+        this->pktDumper->reopenFiles(prefix);
+    else
+        this->pktDumper->reopenFiles(fmt::format("{}branch{}_", prefix, this->branchId));
+    #endif
+    #if INTRA_STEP_PARALLEL
+    this->stepPool->start(numStepWorkers);
+    #endif
+    #if PIPELINED_TRAFFIC_GEN
+    this->trafficPipeline->restart();
+    #endif
+
+    if(this->branchId == 0)
+        return;
+
+    ndebug_print_yellow("What-if branch {} (pid {}) continues at {}ns", this->branchId, getpid(), resumeTime);
+
+    // No trigger is before triggerInitialDelay, so the whole trigger schedule is replaced
+    #if TRIGGERS_ENABLED
+    this->initTriggerGen();
+    this->triggerGen->printTriggerSchedule();
+    #endif
+    #if INCASTS_ENABLED
+    this->initIncastGen();
+    this->incastGen->skipIncastsBefore(resumeTime);
+    this->incastGen->printIncastSchedule();
+    #endif
+}
+
+/* Main run: waits for all the forked branches. Returns false if any of them failed. */
+bool Simulation::waitForBranches(){
+    bool ok = true;
+
+    for(size_t i = 0; i < this->branchPids.size(); i++){
+        int status;
+        if(waitpid(this->branchPids[i], &status, 0) < 0){
+            ndebug_print("Lost track of what-if branch {} (pid {})", i + 1, this->branchPids[i]);
+            ok = false;
+        }
+        else if(!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+            int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+            ndebug_print("What-if branch {} (pid {}) failed with exit code {}", i + 1, this->branchPids[i], exitCode);
+            ok = false;
+        }
+    }
+
+    if(!this->branchPids.empty())
+        ndebug_print("{} what-if branches finished", this->branchPids.size());
+    this->branchPids.clear();
+
+    return ok;
+}
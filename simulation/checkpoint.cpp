@@ -0,0 +1,671 @@
+#include <cstdio>
+#include <limits>
+#include <iterator>
+#include <algorithm>
+#include "simulation/checkpoint.hpp"
+#include "simulation/simulation.hpp"
+#include "utils/logger.hpp"
+
+static const char checkpointMagic[8] = {'S', 'Y', 'N', 'D', 'B', 'C', 'K', 'P'};
+static const uint32_t checkpointVersion = 5;
+static const switch_id_t noSwitch = std::numeric_limits<switch_id_t>::max();
+
+
+CheckpointWriter::CheckpointWriter(const std::string &path){
+    this->path = path;
+    this->file.open(path, std::ios::binary | std::ios::trunc);
+    if(!this->file.is_open()){
+        std::string msg = fmt::format("Cannot open checkpoint {} for writing", path);
+        throw std::logic_error(msg);
+    }
+}
+
+void CheckpointWriter::writeString(const std::string &str){
+    this->write<uint64_t>(str.size());
+    this->file.write(str.data(), str.size());
+}
+
+void CheckpointWriter::close(){
+    this->file.close();
+    if(this->file.fail()){
+        std::string msg = fmt::format("Failed to write checkpoint {}", this->path);
+        throw std::logic_error(msg);
+    }
+}
+
+CheckpointReader::CheckpointReader(const std::string &path){
+    this->path = path;
+    this->file.open(path, std::ios::binary);
+    if(!this->file.is_open()){
+        std::string msg = fmt::format("Cannot open checkpoint {}", path);
+        throw std::logic_error(msg);
+    }
+}
+
+void CheckpointReader::readString(std::string &str){
+    uint64_t size = this->read<uint64_t>();
+    str.resize(size);
+    this->file.read(&str[0], size);
+    this->check();
+}
+
+void CheckpointReader::check(){
+    if(!this->file){
+        std::string msg = fmt::format("Checkpoint {} is truncated or unreadable", this->path);
+        throw std::logic_error(msg);
+    }
+}
+
+
+/* The compile-time flags that change the saved state or the way it is simulated */
+static uint32_t getEngineFlags(){
+    return (LOGGING << 0) | (HOP_DELAY_NOISE << 1) | (RING_BUFFER << 2) | (TRIGGERS_ENABLED << 3) | (INCASTS_ENABLED << 4)
+            | (EVENT_DRIVEN << 5) | (PARALLEL_ENGINE << 6) | (OPTIMISTIC_ENGINE << 7) | (INTRA_STEP_PARALLEL << 8)
+            | (ANALYTICAL_TRIGGER_FLOOD << 9) | (PACKET_TRAINS << 10) | (SOURCE_ROUTING << 11);
+}
+
+static void writeSwitch(CheckpointWriter &ckpt, const Switch* sw){
+    ckpt.write<switch_id_t>(sw != NULL ? sw->id : noSwitch);
+}
+
+static Switch* readSwitch(CheckpointReader &ckpt){
+    switch_id_t id = ckpt.read<switch_id_t>();
+    return id != noSwitch ? syndbSim->topo->getSwitchById(id) : NULL;
+}
+
+static void writeNormalPkt(CheckpointWriter &ckpt, const NormalPkt &pkt){
+    ckpt.write(pkt.size);
+    ckpt.write(pkt.id);
+    ckpt.write(pkt.orderKey);
+    ckpt.write(pkt.srcHost);
+    ckpt.write(pkt.dstHost);
+    #if SOURCE_ROUTING
+    ckpt.write(pkt.path);
+    #endif
+    ckpt.write(pkt.startTime);
+    ckpt.write(pkt.endTime);
+
+    ckpt.write<uint64_t>(pkt.switchINTInfoList.size());
+    for(auto it = pkt.switchINTInfoList.begin(); it != pkt.switchINTInfoList.end(); it++){
+        ckpt.write(*it);
+    }
+}
+
+static void readNormalPkt(CheckpointReader &ckpt, NormalPkt &pkt){
+    ckpt.read(pkt.size);
+    ckpt.read(pkt.id);
+    ckpt.read(pkt.orderKey);
+    ckpt.read(pkt.srcHost);
+    ckpt.read(pkt.dstHost);
+    #if SOURCE_ROUTING
+    ckpt.read(pkt.path);
+    #endif
+    ckpt.read(pkt.startTime);
+    ckpt.read(pkt.endTime);
+
+    pkt.switchINTInfoList.clear();
+    uint64_t numINTInfo = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < numINTInfo; i++){
+        pkt.switchINTInfoList.push_back(ckpt.read<switchINTInfo>());
+    }
+}
+
+static void writeNormalPktEvent(CheckpointWriter &ckpt, const PktEvent<normalpkt_p> &event){
+    writeNormalPkt(ckpt, *event.pkt);
+    ckpt.write(event.pktForwardTime);
+    writeSwitch(ckpt, event.currSwitch);
+    writeSwitch(ckpt, event.nextSwitch);
+}
+
+static pktevent_p<normalpkt_p> readNormalPktEvent(CheckpointReader &ckpt, SimPartition &partition){
+    pktevent_p<normalpkt_p> event = partition.getNewNormalPktEvent();
+    event->pkt = partition.getNewNormalPkt(0);
+    readNormalPkt(ckpt, *event->pkt);
+    ckpt.read(event->pktForwardTime);
+    event->currSwitch = readSwitch(ckpt);
+    event->nextSwitch = readSwitch(ckpt);
+    return event;
+}
+
+#if PACKET_TRAINS
+/* The pkts queued behind a train head */
+static void writeNormalPktTrain(CheckpointWriter &ckpt, const PktEvent<normalpkt_p> &head){
+    uint64_t length = 0;
+    for(PktEvent<normalpkt_p>* it = head.trainNext.get(); it != NULL; it = it->trainNext.get())
+        length++;
+
+    ckpt.write(length);
+    for(PktEvent<normalpkt_p>* it = head.trainNext.get(); it != NULL; it = it->trainNext.get())
+        writeNormalPktEvent(ckpt, *it);
+}
+
+static void readNormalPktTrain(CheckpointReader &ckpt, SimPartition &partition, pktevent_p<normalpkt_p> &head){
+    pktevent_p<normalpkt_p> tail = head;
+    uint64_t length = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < length; i++){
+        tail->trainNext = readNormalPktEvent(ckpt, partition);
+        tail = tail->trainNext;
+    }
+    tail->isTrainTail = true;
+}
+#endif
+
+static void writeTriggerPktEvent(CheckpointWriter &ckpt, const PktEvent<triggerpkt_p> &event){
+    const TriggerPkt &pkt = *event.pkt;
+    ckpt.write(pkt.size);
+    ckpt.write(pkt.triggerId);
+    ckpt.write(pkt.srcSwitchId);
+    ckpt.write(pkt.dstSwitchId);
+    ckpt.write(pkt.triggerOriginSwId);
+    ckpt.write(pkt.triggerTime);
+
+    ckpt.write(event.pktForwardTime);
+    writeSwitch(ckpt, event.currSwitch);
+    writeSwitch(ckpt, event.nextSwitch);
+}
+
+static void readTriggerPktEvent(CheckpointReader &ckpt, SimPartition &partition, PktEvent<triggerpkt_p> &event){
+    pkt_size_t size = ckpt.read<pkt_size_t>();
+    trigger_id_t triggerId = ckpt.read<trigger_id_t>();
+
+    event.pkt = partition.triggerPktPool.getNewTriggerPkt(triggerId, size);
+    ckpt.read(event.pkt->srcSwitchId);
+    ckpt.read(event.pkt->dstSwitchId);
+    ckpt.read(event.pkt->triggerOriginSwId);
+    ckpt.read(event.pkt->triggerTime);
+
+    ckpt.read(event.pktForwardTime);
+    event.currSwitch = readSwitch(ckpt);
+    event.nextSwitch = readSwitch(ckpt);
+}
+
+static void writeIncastInfo(CheckpointWriter &ckpt, const incastScheduleInfo &incast){
+    ckpt.write(incast.time);
+    ckpt.write(incast.targetHostId);
+    ckpt.write<uint64_t>(incast.sourceHosts.size());
+    for(auto it = incast.sourceHosts.begin(); it != incast.sourceHosts.end(); it++){
+        ckpt.write(*it);
+    }
+}
+
+static incastScheduleInfo_p readIncastInfo(CheckpointReader &ckpt){
+    incastScheduleInfo_p incast = incastScheduleInfo_p(new incastScheduleInfo());
+    ckpt.read(incast->time);
+    ckpt.read(incast->targetHostId);
+    uint64_t numSources = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < numSources; i++){
+        incast->sourceHosts.push_back(ckpt.read<host_id_t>()); // written sorted
+    }
+    return incast;
+}
+
+/* The wheel as it is, slot by slot: the order of the events within a tick stays the same */
+static void writeTimingWheel(CheckpointWriter &ckpt, const TimingWheel<pktevent_p<normalpkt_p>> &wheel){
+    typedef TimingWheel<pktevent_p<normalpkt_p>> wheel_t;
+
+    auto writeEntries = [&ckpt](const std::vector<wheel_t::entry_t> &entries){
+        ckpt.write<uint64_t>(entries.size());
+        for(auto it = entries.begin(); it != entries.end(); it++){
+            ckpt.write(it->first);
+            writeNormalPktEvent(ckpt, *it->second);
+        }
+    };
+
+    ckpt.write(wheel.currTick);
+    ckpt.write<uint64_t>(wheel.numItems);
+    for(uint32_t level = 0; level < wheel_t::numLevels; level++){
+        for(uint32_t slot = 0; slot < wheel_t::numSlots; slot++)
+            writeEntries(wheel.slots[level][slot]);
+    }
+    writeEntries(wheel.overdue);
+    writeEntries(wheel.overflow);
+}
+
+static void readTimingWheel(CheckpointReader &ckpt, SimPartition &partition){
+    typedef TimingWheel<pktevent_p<normalpkt_p>> wheel_t;
+    wheel_t &wheel = partition.NormalPktEventWheel;
+
+    auto readEntries = [&ckpt, &partition](std::vector<wheel_t::entry_t> &entries){
+        uint64_t numEntries = ckpt.read<uint64_t>();
+        for(uint64_t i = 0; i < numEntries; i++){
+            uint64_t tick = ckpt.read<uint64_t>();
+            entries.push_back(wheel_t::entry_t(tick, readNormalPktEvent(ckpt, partition)));
+        }
+    };
+
+    wheel.clear();
+    ckpt.read(wheel.currTick);
+    wheel.numItems = ckpt.read<uint64_t>();
+    for(uint32_t level = 0; level < wheel_t::numLevels; level++){
+        for(uint32_t slot = 0; slot < wheel_t::numSlots; slot++)
+            readEntries(wheel.slots[level][slot]);
+    }
+    readEntries(wheel.overdue);
+    readEntries(wheel.overflow);
+}
+
+/* In-flight events of a partition, in the order of their containers, so that their processing order is the same */
+static void writePartition(CheckpointWriter &ckpt, const SimPartition &partition){
+    ckpt.write(partition.totalPktsDelivered);
+
+    #if EVENT_DRIVEN
+    ckpt.write<uint64_t>(partition.eventQueue.heap.size());
+    for(auto it = partition.eventQueue.heap.begin(); it != partition.eventQueue.heap.end(); it++){
+        ckpt.write(it->time);
+        ckpt.write(it->key);
+        ckpt.write(it->type);
+        ckpt.write(it->uid);
+        if(it->type == SimEventType::TriggerPkt)
+            writeTriggerPktEvent(ckpt, it->triggerPktEvent);
+        else{
+            writeNormalPktEvent(ckpt, *it->normalPktEvent);
+            #if PACKET_TRAINS
+            writeNormalPktTrain(ckpt, *it->normalPktEvent);
+            #endif
+        }
+    }
+    #else
+    writeTimingWheel(ckpt, partition.NormalPktEventWheel);
+
+    ckpt.write(partition.TriggerPktEventQueue.nextSeq);
+    ckpt.write<uint64_t>(partition.TriggerPktEventQueue.heap.size());
+    for(auto it = partition.TriggerPktEventQueue.heap.begin(); it != partition.TriggerPktEventQueue.heap.end(); it++){
+        ckpt.write(it->seq);
+        writeTriggerPktEvent(ckpt, it->event);
+    }
+    #endif
+
+    #if OPTIMISTIC_ENGINE
+    ckpt.write(partition.nextEventUid);
+    #endif
+}
+
+static void readPartition(CheckpointReader &ckpt, SimPartition &partition){
+    ckpt.read(partition.totalPktsDelivered);
+
+    #if EVENT_DRIVEN
+    partition.eventQueue.heap.clear();
+    uint64_t numEvents = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < numEvents; i++){
+        SimEvent event;
+        ckpt.read(event.time);
+        ckpt.read(event.key);
+        ckpt.read(event.type);
+        ckpt.read(event.uid);
+        if(event.type == SimEventType::TriggerPkt)
+            readTriggerPktEvent(ckpt, partition, event.triggerPktEvent);
+        else{
+            event.normalPktEvent = readNormalPktEvent(ckpt, partition);
+            #if PACKET_TRAINS
+            readNormalPktTrain(ckpt, partition, event.normalPktEvent);
+            #endif
+        }
+        partition.eventQueue.heap.push_back(std::move(event)); // already in heap order
+    }
+    #else
+    readTimingWheel(ckpt, partition);
+
+    partition.TriggerPktEventQueue.heap.clear();
+    ckpt.read(partition.TriggerPktEventQueue.nextSeq);
+    uint64_t numEvents = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < numEvents; i++){
+        TriggerPktQueue::entry_t entry;
+        ckpt.read(entry.seq);
+        readTriggerPktEvent(ckpt, partition, entry.event);
+        partition.TriggerPktEventQueue.heap.push_back(entry); // already in heap order
+    }
+    #endif
+
+    #if OPTIMISTIC_ENGINE
+    ckpt.read(partition.nextEventUid);
+    #endif
+}
+
+
+static void readCheckpointHeader(CheckpointReader &ckpt, std::string &dumpPrefix){
+    char magic[sizeof(checkpointMagic)];
+    ckpt.read(magic);
+    if(!std::equal(magic, magic + sizeof(magic), checkpointMagic) || ckpt.read<uint32_t>() != checkpointVersion){
+        std::string msg = fmt::format("{} is not a checkpoint of this version of the simulator", ckpt.path);
+        throw std::logic_error(msg);
+    }
+    ckpt.readString(dumpPrefix);
+}
+
+/* The dump files of a restored run are the ones of the checkpointed run. They are opened before anything else is restored. */
+std::string readCheckpointDumpPrefix(const std::string &path){
+    CheckpointReader ckpt(path);
+    std::string prefix;
+    readCheckpointHeader(ckpt, prefix);
+    return prefix;
+}
+
+/*
+    Writes the complete simulation state to path. Only called between two ticks, or at a window barrier of the
+    event-driven engines, when no event is being processed. The run continues from resumeTime once restored.
+    The file is written next to path first, so a crash while writing keeps the previous checkpoint.
+*/
+void Simulation::saveCheckpoint(const std::string &path, sim_time_t resumeTime){
+
+    #if PIPELINED_TRAFFIC_GEN
+    std::string msg = "Checkpoints are not supported with PIPELINED_TRAFFIC_GEN: the RNG states run ahead on the producer threads";
+    throw std::logic_error(msg);
+    #endif
+
+    std::string tmpPath = path + ".tmp";
+    CheckpointWriter ckpt(tmpPath);
+
+    ckpt.write(checkpointMagic);
+    ckpt.write(checkpointVersion);
+    #if LOGGING
+    ckpt.writeString(this->pktDumper->prefixStringForFileName); // first, see readCheckpointDumpPrefix()
+    #else
+    ckpt.writeString("");
+    #endif
+    ckpt.write(getEngineFlags());
+    ckpt.write(this->topo->nextHostId);
+    ckpt.write(this->topo->nextSwitchId);
+    ckpt.write<uint64_t>(this->partitions.size());
+    ckpt.write(this->timeIncrement);
+
+    ckpt.write(resumeTime);
+    ckpt.write(this->branchId);
+    ckpt.write(this->nextPktId);
+    ckpt.write(this->nextTriggerPktId);
+
+    // Dump files: the lines written so far. Flushed, so that they are on the disk before the checkpoint is.
+    #if LOGGING
+    this->pktDumper->flushFiles();
+    ckpt.write(this->pktDumper->triggerFileLines);
+    ckpt.write(this->pktDumper->sourceDestinationFileLines);
+    ckpt.write(this->pktDumper->incastFileLines);
+    ckpt.write<uint64_t>(this->pktDumper->switchFileLines.size());
+    for(auto it = this->pktDumper->switchFileLines.begin(); it != this->pktDumper->switchFileLines.end(); it++){
+        ckpt.write(*it);
+    }
+    #endif
+
+    ckpt.write<uint64_t>(this->TriggerInfoMap.size());
+    for(auto it = this->TriggerInfoMap.begin(); it != this->TriggerInfoMap.end(); it++){
+        ckpt.write(it->first);
+        ckpt.write(it->second.triggerOrigTime);
+        ckpt.write(it->second.originSwitch);
+        ckpt.write<uint64_t>(it->second.rxSwitchTimes.size());
+        for(auto rxIt = it->second.rxSwitchTimes.begin(); rxIt != it->second.rxSwitchTimes.end(); rxIt++){
+            ckpt.write(rxIt->first);
+            ckpt.write(rxIt->second);
+        }
+    }
+
+    // The schedules themselves: with clock seeds, a new run would draw different ones
+    #if TRIGGERS_ENABLED
+    ckpt.write<uint64_t>(this->triggerGen->triggerSchedule.size());
+    for(auto it = this->triggerGen->triggerSchedule.begin(); it != this->triggerGen->triggerSchedule.end(); it++){
+        ckpt.write(*it);
+    }
+    ckpt.write<uint64_t>(std::distance(this->triggerGen->triggerSchedule.begin(), this->triggerGen->nextTrigger));
+    ckpt.write(this->triggerGen->nextTriggerTime);
+    ckpt.write(this->triggerGen->nextSwitchId);
+    #if ANALYTICAL_TRIGGER_FLOOD
+    this->triggerGen->flood.saveState(ckpt);
+    #endif
+    #endif
+
+    #if INCASTS_ENABLED
+    ckpt.write(this->incastGen->totalIncasts);
+    ckpt.write(this->incastGen->nextIncastTime);
+    ckpt.write<bool>(this->incastGen->nextIncast != nullptr);
+    if(this->incastGen->nextIncast != nullptr)
+        writeIncastInfo(ckpt, *this->incastGen->nextIncast);
+    ckpt.write<uint64_t>(this->incastGen->incastSchedule.size());
+    for(auto it = this->incastGen->incastSchedule.begin(); it != this->incastGen->incastSchedule.end(); it++){
+        writeIncastInfo(ckpt, **it);
+    }
+    ckpt.writeRandomEngine(this->incastGen->randSourceHosts); // the sources of the incasts not lined up yet
+    #endif
+
+    for(auto it = this->topo->torLinks.begin(); it != this->topo->torLinks.end(); it++){
+        ckpt.write(it->next_idle_time_to_tor);
+        ckpt.write(it->next_idle_time_to_host);
+        ckpt.write(it->byte_count_to_tor);
+        ckpt.write(it->byte_count_to_host);
+    }
+
+    for(auto it = this->topo->networkLinks.begin(); it != this->topo->networkLinks.end(); it++){
+        ckpt.write(it->queues);
+    }
+
+    for(switch_id_t switchId = 0; switchId < this->topo->nextSwitchId; switchId++){
+        Switch* sw = this->topo->getSwitchById(switchId);
+
+        ckpt.writeRandomEngine(sw->randHopDelay);
+        ckpt.write<uint64_t>(sw->triggerHistory.size());
+        for(auto it = sw->triggerHistory.begin(); it != sw->triggerHistory.end(); it++){
+            ckpt.write(*it);
+        }
+        #if RING_BUFFER
+        sw->ringBuffer.saveState(ckpt);
+        #endif
+    }
+
+    for(host_id_t hostId = 0; hostId < this->topo->nextHostId; hostId++){
+        Host* host = this->topo->getHostById(hostId);
+
+        ckpt.write(host->nextPktInfo);
+        ckpt.write(host->nextPktTime);
+        ckpt.write(host->prevPktTime);
+        ckpt.write<bool>(host->nextPkt != NULL);
+        if(host->nextPkt != NULL)
+            writeNormalPkt(ckpt, *host->nextPkt);
+
+        host->trafficGen->saveState(ckpt);
+        host->trafficPattern->saveState(ckpt);
+    }
+
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        writePartition(ckpt, **it);
+    }
+
+    ckpt.write(checkpointMagic); // a complete file ends like it starts
+    ckpt.close();
+
+    if(std::rename(tmpPath.c_str(), path.c_str()) != 0){
+        std::string msg = fmt::format("Failed to move checkpoint {} to {}", tmpPath, path);
+        throw std::logic_error(msg);
+    }
+
+    ndebug_print_yellow("Checkpoint of time {}ns written to {}", resumeTime, path);
+}
+
+/*
+    Replaces the state of the freshly initialized simulation (topology, partitions, generators and hosts)
+    with the one of the checkpoint. The config MUST be the one of the checkpointed run.
+*/
+void Simulation::restoreCheckpoint(const std::string &path){
+
+    #if PIPELINED_TRAFFIC_GEN
+    std::string msg = "Checkpoints are not supported with PIPELINED_TRAFFIC_GEN: the RNG states run ahead on the producer threads";
+    throw std::logic_error(msg);
+    #endif
+
+    CheckpointReader ckpt(path);
+    std::string prefix;
+    readCheckpointHeader(ckpt, prefix);
+
+    uint32_t engineFlags = ckpt.read<uint32_t>();
+    host_id_t numHosts = ckpt.read<host_id_t>();
+    switch_id_t numSwitches = ckpt.read<switch_id_t>();
+    uint64_t numPartitions = ckpt.read<uint64_t>();
+    sim_time_t timeIncrement = ckpt.read<sim_time_t>();
+    if(engineFlags != getEngineFlags() || numHosts != this->topo->nextHostId || numSwitches != this->topo->nextSwitchId
+        || numPartitions != this->partitions.size() || timeIncrement != this->timeIncrement){
+        std::string msg = fmt::format("Checkpoint {} was taken with another config (flags {:#x}, {} hosts, {} switches, {} partitions, {}ns ticks)", path, engineFlags, numHosts, numSwitches, numPartitions, timeIncrement);
+        throw std::logic_error(msg);
+    }
+
+    ckpt.read(this->currTime);
+    ckpt.read(this->branchId);
+    ckpt.read(this->nextPktId);
+    ckpt.read(this->nextTriggerPktId);
+
+    #if LOGGING
+    ckpt.read(this->pktDumper->triggerFileLines);
+    ckpt.read(this->pktDumper->sourceDestinationFileLines);
+    ckpt.read(this->pktDumper->incastFileLines);
+    this->pktDumper->switchFileLines.resize(ckpt.read<uint64_t>());
+    for(auto it = this->pktDumper->switchFileLines.begin(); it != this->pktDumper->switchFileLines.end(); it++){
+        ckpt.read(*it);
+    }
+    #endif
+
+    this->TriggerInfoMap.clear();
+    uint64_t numTriggers = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < numTriggers; i++){
+        triggerInfo &tinfo = this->TriggerInfoMap[ckpt.read<trigger_id_t>()];
+        ckpt.read(tinfo.triggerOrigTime);
+        ckpt.read(tinfo.originSwitch);
+        uint64_t numRx = ckpt.read<uint64_t>();
+        for(uint64_t j = 0; j < numRx; j++){
+            switch_id_t switchId = ckpt.read<switch_id_t>();
+            ckpt.read(tinfo.rxSwitchTimes[switchId]);
+        }
+    }
+
+    #if TRIGGERS_ENABLED
+    this->triggerGen->triggerSchedule.clear();
+    uint64_t numScheduled = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < numScheduled; i++){
+        this->triggerGen->triggerSchedule.push_back(ckpt.read<triggerScheduleInfo>());
+    }
+    this->triggerGen->nextTrigger = std::next(this->triggerGen->triggerSchedule.begin(), ckpt.read<uint64_t>());
+    ckpt.read(this->triggerGen->nextTriggerTime);
+    ckpt.read(this->triggerGen->nextSwitchId);
+    #if ANALYTICAL_TRIGGER_FLOOD
+    this->triggerGen->flood.loadState(ckpt);
+    #endif
+    #endif
+
+    #if INCASTS_ENABLED
+    ckpt.read(this->incastGen->totalIncasts);
+    ckpt.read(this->incastGen->nextIncastTime);
+    this->incastGen->nextIncast = ckpt.read<bool>() ? readIncastInfo(ckpt) : nullptr;
+    this->incastGen->incastSchedule.clear();
+    uint64_t numIncasts = ckpt.read<uint64_t>();
+    for(uint64_t i = 0; i < numIncasts; i++){
+        this->incastGen->incastSchedule.push_back(readIncastInfo(ckpt));
+    }
+    ckpt.readRandomEngine(this->incastGen->randSourceHosts);
+    #endif
+
+    for(auto it = this->topo->torLinks.begin(); it != this->topo->torLinks.end(); it++){
+        ckpt.read(it->next_idle_time_to_tor);
+        ckpt.read(it->next_idle_time_to_host);
+        ckpt.read(it->byte_count_to_tor);
+        ckpt.read(it->byte_count_to_host);
+    }
+
+    for(auto it = this->topo->networkLinks.begin(); it != this->topo->networkLinks.end(); it++){
+        ckpt.read(it->queues);
+    }
+
+    for(switch_id_t switchId = 0; switchId < this->topo->nextSwitchId; switchId++){
+        Switch* sw = this->topo->getSwitchById(switchId);
+
+        ckpt.readRandomEngine(sw->randHopDelay);
+        sw->triggerHistory.clear();
+        uint64_t numSeen = ckpt.read<uint64_t>();
+        for(uint64_t i = 0; i < numSeen; i++){
+            sw->triggerHistory.insert(ckpt.read<trigger_id_t>());
+        }
+        #if RING_BUFFER
+        sw->ringBuffer.loadState(ckpt);
+        #endif
+    }
+
+    for(host_id_t hostId = 0; hostId < this->topo->nextHostId; hostId++){
+        Host* host = this->topo->getHostById(hostId);
+
+        ckpt.read(host->nextPktInfo);
+        ckpt.read(host->nextPktTime);
+        ckpt.read(host->prevPktTime);
+        if(ckpt.read<bool>()){
+            if(host->nextPkt == NULL)
+                host->nextPkt = host->partition->getNewNormalPkt(0);
+            readNormalPkt(ckpt, *host->nextPkt);
+        }
+
+        host->trafficGen->loadState(ckpt);
+        host->trafficPattern->loadState(ckpt);
+    }
+
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        readPartition(ckpt, **it);
+        (*it)->hostScheduler.clear();
+    }
+
+    char magic[sizeof(checkpointMagic)];
+    ckpt.read(magic);
+    if(!std::equal(magic, magic + sizeof(magic), checkpointMagic)){
+        std::string msg = fmt::format("Checkpoint {} is corrupt", path);
+        throw std::logic_error(msg);
+    }
+
+    // The hosts' nextPktTime changed
+    for(host_id_t hostId = 0; hostId < this->topo->nextHostId; hostId++){
+        Host* host = this->topo->getHostById(hostId);
+        if(!host->trafficGenDisabled)
+            host->partition->hostScheduler.push(host);
+    }
+
+    #if LOGGING
+    this->pktDumper->truncateFiles();
+    #endif
+
+    this->scheduleNextCheckpoint(this->currTime);
+
+    ndebug_print_yellow("Restored checkpoint {}. Resuming at {}ns", path, this->currTime);
+}
+
+/* The first multiple of checkpointIntervalMSecs after time */
+void Simulation::scheduleNextCheckpoint(sim_time_t time){
+    sim_time_t interval = (sim_time_t)(syndbConfig.checkpointIntervalMSecs * (float)1000000);
+
+    if(interval == 0 || syndbConfig.checkpointFile.empty() || PIPELINED_TRAFFIC_GEN){
+        this->nextCheckpointTime = std::numeric_limits<sim_time_t>::max();
+        return;
+    }
+
+    this->nextCheckpointTime = (time / interval + 1) * interval;
+}
+
+/*
+    Called by the main loops whenever the state is consistent: between two ticks, or at a window barrier.
+    resumeTime is where the run would continue. Writes a checkpoint if one is due, or if the run is stopped by a signal.
+    Returns true if the run must stop.
+*/
+bool Simulation::checkpointAt(sim_time_t resumeTime){
+    bool stop = syndbStopSignal != 0;
+
+    if(resumeTime < this->nextCheckpointTime && !stop)
+        return false;
+
+    #if !PIPELINED_TRAFFIC_GEN
+    if(!syndbConfig.checkpointFile.empty() && resumeTime <= this->totalTime && !this->hybrid) // the fluid state isn't checkpointed
+        this->saveCheckpoint(this->getCheckpointFile(), resumeTime);
+    #endif
+
+    this->scheduleNextCheckpoint(resumeTime);
+    return stop;
+}
+
+/* Ensemble replicas and forked what-if branches write their own checkpoints */
+std::string Simulation::getCheckpointFile(){
+    std::string path = syndbConfig.checkpointFile;
+
+    if(this->replicaId != 0)
+        path += fmt::format(".replica{}", this->replicaId);
+    if(this->branchId != 0)
+        path += fmt::format(".branch{}", this->branchId);
+
+    return path;
+}
@@ -0,0 +1,80 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include <fmt/core.h>
+
+/*
+    Binary snapshot file of the simulation state (see Simulation::saveCheckpoint()).
+    Values are written in the byte order and sizes of the host: a checkpoint is only read back by the same build and config.
+    RNG engines are written in their standard text representation, which is all the state they have.
+*/
+struct CheckpointWriter
+{
+    std::string path;
+    std::ofstream file;
+
+    CheckpointWriter(const std::string &path);
+
+    /* Trivially copyable values only */
+    template<typename T>
+    inline void write(const T &value){
+        this->file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    };
+
+    void writeString(const std::string &str);
+
+    template<typename E>
+    inline void writeRandomEngine(const E &engine){
+        std::ostringstream state;
+        state << engine;
+        this->writeString(state.str());
+    };
+
+    void close(); // throws if anything failed to be written
+};
+
+struct CheckpointReader
+{
+    std::string path;
+    std::ifstream file;
+
+    CheckpointReader(const std::string &path);
+
+    template<typename T>
+    inline void read(T &value){
+        this->file.read(reinterpret_cast<char*>(&value), sizeof(T));
+        this->check();
+    };
+
+    template<typename T>
+    inline T read(){
+        T value;
+        this->read(value);
+        return value;
+    };
+
+    void readString(std::string &str);
+
+    template<typename E>
+    inline void readRandomEngine(E &engine){
+        std::string str;
+        this->readString(str);
+        std::istringstream state(str);
+        state >> engine;
+        if(state.fail()){
+            std::string msg = fmt::format("Corrupt random engine state in checkpoint {}", this->path);
+            throw std::logic_error(msg);
+        }
+    };
+
+    void check(); // throws if the file ended early
+};
+
+std::string readCheckpointDumpPrefix(const std::string &path);
+
+
+#endif
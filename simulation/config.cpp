@@ -1,4 +1,216 @@
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <fmt/core.h>
 #include "config.hpp"
 
 
 Config syndbConfig;
+
+/* The keys of a runtime config file: the params that every config has. timeIncrementNs stays compile-time. */
+#define CONFIG_KEYS(X) \
+    X(randomSeed) X(optimisticWindowNs) X(numStepThreads) X(numTrafficGenThreads) X(numBuildThreads) X(trafficGenRingSize) \
+    X(checkpointIntervalMSecs) X(checkpointFile) X(restoreCheckpointFile) X(numEnsembleReplicas) X(numWhatIfBranches) \
+    X(dumpPrefix) X(numSweepProcesses) X(hybridWarmInNs) X(hybridCoolDownNs) X(hybridMeasureNs) X(hybridCompareFull) \
+    X(numTimeWindows) X(timeWindowWarmUpNs) \
+    X(fatTreeTopoK) X(ftMixedPatternPercentIntraRack) X(targetBaseNetworkLoadPercent) X(totalTimeMSecs) X(topoType) X(topoFile) \
+    X(numHosts) X(numSwitches) X(numCoreSwitches) X(trafficPatternType) X(trafficGenType) X(triggerInitialDelay) \
+    X(numTriggersPerSwitchType) X(torLinkSpeedGbps) X(networkLinkSpeedGbps) \
+    X(percentIncastTime) X(incastFanInRatio) X(percentTargetIncastHosts) \
+    X(switchHopDelayNs) X(minSwitchHopDelayNs) X(maxSwitchHopDelayNs) X(ringBufferSize) X(triggerPktSize) \
+    X(packetSizeDistFile) X(flowArrivalDistFile) X(fixedPktSizeForSimpleTrafficGen)
+
+static void badValue(const std::string &key, const std::string &value){
+    std::string msg = fmt::format("Bad value \"{}\" for config key {}", value, key);
+    throw std::logic_error(msg);
+}
+
+template<typename T>
+static void parseNumber(const std::string &key, const std::string &value, T &member, std::true_type /* integral */){
+    size_t end = 0;
+    try{
+        if(std::is_signed<T>::value){
+            long long v = std::stoll(value, &end, 0);
+            if(v < (long long)std::numeric_limits<T>::min() || v > (long long)std::numeric_limits<T>::max())
+                badValue(key, value);
+            member = (T)v;
+        }
+        else{
+            unsigned long long v = std::stoull(value, &end, 0);
+            if(value[0] == '-' || v > (unsigned long long)std::numeric_limits<T>::max())
+                badValue(key, value);
+            member = (T)v;
+        }
+    }
+    catch(const std::invalid_argument &e){ badValue(key, value); }
+    catch(const std::out_of_range &e){ badValue(key, value); }
+
+    if(end != value.size())
+        badValue(key, value);
+}
+
+template<typename T>
+static void parseNumber(const std::string &key, const std::string &value, T &member, std::false_type /* floating point */){
+    size_t end = 0;
+    try{
+        member = (T)std::stod(value, &end);
+    }
+    catch(const std::invalid_argument &e){ badValue(key, value); }
+    catch(const std::out_of_range &e){ badValue(key, value); }
+
+    if(end != value.size())
+        badValue(key, value);
+}
+
+template<typename T>
+static void parseValue(const std::string &key, const std::string &value, T &member){
+    parseNumber(key, value, member, std::is_integral<T>());
+}
+
+static void parseValue(const std::string &key, const std::string &value, std::string &member){
+    member = value;
+}
+
+static void parseValue(const std::string &key, const std::string &value, TopologyType &member){
+    if(value == "Simple")
+        member = TopologyType::Simple;
+    else if(value == "FatTree")
+        member = TopologyType::FatTree;
+    else if(value == "Line")
+        member = TopologyType::Line;
+    else if(value == "File")
+        member = TopologyType::File;
+    else
+        badValue(key, value);
+}
+
+static void parseValue(const std::string &key, const std::string &value, TrafficPatternType &member){
+    if(value == "SimpleTopo")
+        member = TrafficPatternType::SimpleTopo;
+    else if(value == "AlltoAll")
+        member = TrafficPatternType::AlltoAll;
+    else if(value == "FtUniform")
+        member = TrafficPatternType::FtUniform;
+    else if(value == "FtMixed")
+        member = TrafficPatternType::FtMixed;
+    else
+        badValue(key, value);
+}
+
+static void parseValue(const std::string &key, const std::string &value, TrafficGenType &member){
+    if(value == "Continuous")
+        member = TrafficGenType::Continuous;
+    else if(value == "Distribution")
+        member = TrafficGenType::Distribution;
+    else
+        badValue(key, value);
+}
+
+void Config::set(const std::string &key, const std::string &value){
+    #define SET_CONFIG_KEY(name) \
+        if(key == #name){ \
+            parseValue(key, value, this->name); \
+            return; \
+        }
+    CONFIG_KEYS(SET_CONFIG_KEY)
+    #undef SET_CONFIG_KEY
+
+    std::string msg = fmt::format("Unknown config key {}", key);
+    throw std::logic_error(msg);
+}
+
+/* The derived params (numHosts, ...) follow the given ones, unless they are given themselves */
+void Config::apply(const config_params_t &params){
+    for(auto it = params.begin(); it != params.end(); it++)
+        this->set(it->first, it->second);
+
+    this->deriveParams();
+
+    for(auto it = params.begin(); it != params.end(); it++)
+        this->set(it->first, it->second);
+
+    if(this->topoType == TopologyType::FatTree){
+        uint64_t k = this->fatTreeTopoK;
+        if(k < 2 || k % 2 != 0 || (k * k * k) / 4 > std::numeric_limits<host_id_t>::max()){
+            std::string msg = fmt::format("Unsupported fatTreeTopoK {}", k);
+            throw std::logic_error(msg);
+        }
+    }
+
+    if(this->topoType == TopologyType::File && this->topoFile.empty()){
+        std::string msg = "topoType = File needs the topology file in topoFile";
+        throw std::logic_error(msg);
+    }
+
+    if(this->ringBufferSize == 0){
+        std::string msg = "ringBufferSize must not be 0";
+        throw std::logic_error(msg);
+    }
+}
+
+static std::string trim(const std::string &str){
+    size_t begin = str.find_first_not_of(" \t\r");
+    if(begin == std::string::npos)
+        return "";
+    size_t end = str.find_last_not_of(" \t\r");
+    return str.substr(begin, end - begin + 1);
+}
+
+/*
+    One "key = value" per line, '#' starts a comment. Keys are the names of the Config members.
+    "key = a, b, c" gives the key several values: the run becomes a parameter sweep (see runSweep()).
+    Every value is checked here, so that a sweep fails before any point was run.
+*/
+std::vector<configParam> readConfigFile(const std::string &path){
+    std::ifstream file(path);
+    if(!file.is_open()){
+        std::string msg = fmt::format("Could not open config file {}", path);
+        throw std::logic_error(msg);
+    }
+
+    std::vector<configParam> params;
+    Config check;
+    std::string line;
+    unsigned int lineNum = 0;
+
+    while(std::getline(file, line)){
+        lineNum++;
+        line = trim(line.substr(0, line.find('#')));
+        if(line.empty())
+            continue;
+
+        size_t eq = line.find('=');
+        if(eq == std::string::npos){
+            std::string msg = fmt::format("{}:{}: expected key = value", path, lineNum);
+            throw std::logic_error(msg);
+        }
+
+        configParam param;
+        param.key = trim(line.substr(0, eq));
+        std::string values = line.substr(eq + 1);
+
+        for(auto it = params.begin(); it != params.end(); it++){
+            if(it->key == param.key){
+                std::string msg = fmt::format("{}:{}: config key {} is given twice", path, lineNum, param.key);
+                throw std::logic_error(msg);
+            }
+        }
+
+        size_t begin = 0;
+        while(true){
+            size_t comma = values.find(',', begin);
+            std::string value = trim(values.substr(begin, comma == std::string::npos ? std::string::npos : comma - begin));
+            check.set(param.key, value);
+            param.values.push_back(value);
+
+            if(comma == std::string::npos)
+                break;
+            begin = comma + 1;
+        }
+
+        params.push_back(param);
+    }
+
+    return params;
+}
@@ -23,4 +23,36 @@
     #include "simulation/config_test.hpp"
 #endif
 
+/* <key, value> pairs of a runtime config, applied by Config::apply() */
+typedef std::vector<std::pair<std::string, std::string>> config_params_t;
+
+/* A key of a runtime config file with its value(s). A key with several values is a sweep parameter. */
+struct configParam
+{
+    std::string key;
+    std::vector<std::string> values;
+};
+
+std::vector<configParam> readConfigFile(const std::string &path);
+
+#if PARALLEL_ENGINE && !EVENT_DRIVEN
+#error "PARALLEL_ENGINE runs each partition with the event-driven engine. Set EVENT_DRIVEN to 1."
+#endif
+
+#if OPTIMISTIC_ENGINE && !PARALLEL_ENGINE
+#error "OPTIMISTIC_ENGINE runs the partitions of the parallel engine. Set PARALLEL_ENGINE to 1."
+#endif
+
+#if INTRA_STEP_PARALLEL && EVENT_DRIVEN
+#error "INTRA_STEP_PARALLEL splits the ticks of the tick-based loop. Set EVENT_DRIVEN to 0."
+#endif
+
+#if PACKET_TRAINS && (!EVENT_DRIVEN || OPTIMISTIC_ENGINE)
+#error "PACKET_TRAINS needs the event-driven engine without rollbacks. Set EVENT_DRIVEN to 1 and OPTIMISTIC_ENGINE to 0."
+#endif
+
+#if PARALLEL_ENGINE && RING_BUFFER
+#error "RING_BUFFER is not supported with PARALLEL_ENGINE: pkt IDs are only assigned at the window barriers."
+#endif
+
 #endif
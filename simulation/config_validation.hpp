@@ -1,4 +1,6 @@
 #include <string>
+#include <vector>
+#include <utility>
 #include <cassert>
 #include "utils/types.hpp"
 
@@ -9,50 +11,87 @@
 #define RING_BUFFER 0
 #define TRIGGERS_ENABLED 1
 #define INCASTS_ENABLED 0
+#define EVENT_DRIVEN 0
+#define PARALLEL_ENGINE 0
+#define OPTIMISTIC_ENGINE 0
+#define INTRA_STEP_PARALLEL 0
+#define PIPELINED_TRAFFIC_GEN 0
+#define ANALYTICAL_TRIGGER_FLOOD 0
+#define PACKET_TRAINS 0
+#define SPECIALIZED_FATTREE 0
+#define SOURCE_ROUTING 0
 
 typedef struct Config 
 {
     static const sim_time_t timeIncrementNs = 100;
+    uint64_t randomSeed = 0; // 0: seeded from the clock. Set it for repeatable runs (needed to compare engines)
+    sim_time_t optimisticWindowNs = 10000; // OPTIMISTIC_ENGINE: how far ahead of the last barrier the partitions may run
+    unsigned int numStepThreads = 0; // INTRA_STEP_PARALLEL: threads (incl. the main thread) for the normal pkt events of a tick. 0: one per core
+    unsigned int numTrafficGenThreads = 1; // PIPELINED_TRAFFIC_GEN: producer threads running the hosts' traffic generators. 0: one per core, minus the simulation thread
+    unsigned int numBuildThreads = 0; // threads building the topology: the FatTree pods, the next hop tables of topology files. 0: one per core
+    size_t trafficGenRingSize = 1024; // PIPELINED_TRAFFIC_GEN: pkt descriptors generated ahead per host. Power of 2.
+    float checkpointIntervalMSecs = 0; // automatic checkpoints every that many simulated ms. 0: none
+    std::string checkpointFile = "./data/checkpoint.bin"; // written by the automatic checkpoints and on SIGINT/SIGTERM. "": never
+    std::string restoreCheckpointFile = ""; // resume the run of this checkpoint instead of starting at time 0
+    unsigned int numEnsembleReplicas = 0; // run that many replicas (seeds randomSeed, randomSeed+1, ...) on threads of their own in this process. 0: a single run
+    unsigned int numWhatIfBranches = 0; // fork() that many children at triggerInitialDelay, each with its own trigger/incast schedules and dump prefix. 0: no branching
+    std::string dumpPrefix = ""; // dump file names start with it. "": dump_<date>_<time>_
+    unsigned int numSweepProcesses = 0; // parameter sweeps (several values for a key of the config file): points run at the same time. 0: one per core
+    sim_time_t hybridWarmInNs = 0; // hybrid fluid/pkt mode: pkt-level simulation only from that long before each trigger, fluid rates in between. 0: pkt-level all the time
+    sim_time_t hybridCoolDownNs = 100000; // hybrid mode: pkt-level until that long after each trigger
+    sim_time_t hybridMeasureNs = 100000; // hybrid mode: the pkts delivered in that long before a trigger make its fidelity stats
+    bool hybridCompareFull = false; // hybrid mode: run the full pkt-level simulation alongside and report the fidelity loss at the triggers
+    unsigned int numTimeWindows = 0; // time-parallel mode: > 1 splits the run into that many windows of time, simulated on threads of their own and stitched together
+    sim_time_t timeWindowWarmUpNs = 500000; // time-parallel mode: pkt-level warm-up before each window, after a fluid pre-pass up to there
 
     // IMPORTANT: update numHosts and numSwitches as per the topology
     
     /* LineTopo 10ms Expt Params */
-    const pkt_size_t fixedPktSizeForSimpleTrafficGen = 101; //1500;
-    const float totalTimeMSecs = 10;
-    const TopologyType topoType = TopologyType::Line;
-    static const switch_id_t numSwitches = 5;
-    static const uint numHosts = 2;
-    const TrafficPatternType trafficPatternType = TrafficPatternType::SimpleTopo;
-    const sim_time_t triggerInitialDelay = 1500000; // 1.5ms for Line topo 10ms run with 10k ring buffer
-    static const uint numTriggersPerSwitchType = 100;
-    const link_speed_gbps_t torLinkSpeedGbps = 10;
-    const link_speed_gbps_t networkLinkSpeedGbps = 10;
-    const TrafficGenType trafficGenType = TrafficGenType::Continuous;
+    pkt_size_t fixedPktSizeForSimpleTrafficGen = 101; //1500;
+    float totalTimeMSecs = 10;
+    TopologyType topoType = TopologyType::Line;
+    std::string topoFile = ""; // topoType = File: the topology file, see topology/file_topology.hpp. Set numHosts and numSwitches to match it
+    switch_id_t numSwitches = 5;
+    uint numHosts = 2;
+    TrafficPatternType trafficPatternType = TrafficPatternType::SimpleTopo;
+    sim_time_t triggerInitialDelay = 1500000; // 1.5ms for Line topo 10ms run with 10k ring buffer
+    uint numTriggersPerSwitchType = 100;
+    link_speed_gbps_t torLinkSpeedGbps = 10;
+    link_speed_gbps_t networkLinkSpeedGbps = 10;
+    TrafficGenType trafficGenType = TrafficGenType::Continuous;
     
     /* Incast Related Params */
-    const uint8_t percentIncastTime = 10;
-    const host_id_t incastFanInRatio = numHosts / 4; // 25% of the total hosts
-    const host_id_t percentTargetIncastHosts = 30;
+    uint8_t percentIncastTime = 10;
+    host_id_t incastFanInRatio = numHosts / 4; // 25% of the total hosts
+    host_id_t percentTargetIncastHosts = 30;
 
     // const load_t hostTrafficGenLoadPercent = 100;
 
-    const sim_time_t switchHopDelayNs = 500;
-    const sim_time_t minSwitchHopDelayNs = 450;
-    const sim_time_t maxSwitchHopDelayNs = 550;
+    sim_time_t switchHopDelayNs = 500;
+    sim_time_t minSwitchHopDelayNs = 450;
+    sim_time_t maxSwitchHopDelayNs = 550;
 
     // SyNDB specific config options
-    static const pkt_id_t ringBufferSize = 10000; // 10K
-    static const pkt_size_t triggerPktSize = 60;
+    pkt_id_t ringBufferSize = 10000; // 10K
+    pkt_size_t triggerPktSize = 60;
 
-    const std::string packetSizeDistFile = "traffic-dist/fb_webserver_packetsizedist_cdf.csv";
-    const std::string flowArrivalDistFile = "traffic-dist/fb_webserver_flowinterarrival_ns_cdf.csv";
+    std::string packetSizeDistFile = "traffic-dist/fb_webserver_packetsizedist_cdf.csv";
+    std::string flowArrivalDistFile = "traffic-dist/fb_webserver_flowinterarrival_ns_cdf.csv";
 
     /* Other params NOT used, but needed for compilation. */
     // FatTree Topo 100ms Expt Params
-    static const ft_scale_t fatTreeTopoK = 24; // Fat Tree scale k
-    const uint8_t ftMixedPatternPercentIntraRack = 75;
-    const uint8_t targetBaseNetworkLoadPercent = 40;  /* 30 -> 25%, 40 -> 31%, 50 -> 36% */
-    static const int numCoreSwitches = (fatTreeTopoK/2) * (fatTreeTopoK/2);
+    ft_scale_t fatTreeTopoK = 24; // Fat Tree scale k
+    uint8_t ftMixedPatternPercentIntraRack = 75;
+    uint8_t targetBaseNetworkLoadPercent = 40;  /* 30 -> 25%, 40 -> 31%, 50 -> 36% */
+    int numCoreSwitches = (fatTreeTopoK/2) * (fatTreeTopoK/2);
+
+    /* Runtime config (see config.cpp). deriveParams() recomputes the params that follow from others. numHosts is fixed by the topology. */
+    void set(const std::string &key, const std::string &value);
+    void apply(const std::vector<std::pair<std::string, std::string>> &params);
+    inline void deriveParams(){
+        numCoreSwitches = (fatTreeTopoK/2) * (fatTreeTopoK/2);
+        incastFanInRatio = numHosts / 4;
+    };
 
 } Config;
 
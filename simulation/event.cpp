@@ -7,6 +7,9 @@
 template<typename T>
 PktEvent<T>::PktEvent(){
     // debug_print(fmt::format("New empty PktEvent constructed!"));
+    #if PACKET_TRAINS
+    this->isTrainTail = false;
+    #endif
 }
 
 template<>
@@ -23,11 +26,6 @@ PktEvent<triggerpkt_p>::~PktEvent(){
 }
 
 
-HostPktEvent::HostPktEvent(Host* host, normalpkt_p &pkt){
-    this->host = host;
-    this->pkt = pkt;
-}
-
 /* 
     To avoid linking error for the template's methods,
     instantiating the template class with the two possible types
@@ -4,6 +4,7 @@
 #include "traffic/packet.hpp"
 #include "topology/host.hpp"
 #include "topology/switch.hpp"
+#include "simulation/config.hpp"
 
 template<typename T>
 struct PktEvent
@@ -12,6 +13,15 @@ struct PktEvent
     sim_time_t pktForwardTime;
     Switch* currSwitch;
     Switch* nextSwitch; // NULL if next hop is dstHost
+
+    #if PACKET_TRAINS
+    /*
+        Normal pkts only. Pkt events that follow each other on the same hop ride one train: only the head is queued,
+        the others hang off it, each later than the one before. See SimPartition::processNormalPktTrain().
+    */
+    std::shared_ptr<PktEvent<T>> trainNext;
+    bool isTrainTail; // queued (as head or behind one) with no pkt behind it yet
+    #endif
     
     PktEvent();
     ~PktEvent();
@@ -23,16 +33,6 @@ struct PktEvent
 template<typename T>
 using pktevent_p = std::shared_ptr<PktEvent<T>>;
 
-struct HostPktEvent
-{
-    Host* host;
-    normalpkt_p pkt;
-
-    HostPktEvent(Host* host, normalpkt_p &pkt);
-};
-
-typedef std::shared_ptr<HostPktEvent> hostpktevent_p;
-
 
 
 
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include "simulation/eventqueue.hpp"
+
+/* Comparator for std::push_heap/pop_heap. Returns true if a should be processed AFTER b */
+static inline bool laterEvent(const SimEvent &a, const SimEvent &b){
+    return isEarlierEvent(b, a);
+}
+
+void EventQueue::push(SimEvent &event){
+    this->heap.push_back(std::move(event));
+    std::push_heap(this->heap.begin(), this->heap.end(), laterEvent);
+}
+
+void EventQueue::pop(SimEvent &event){
+    std::pop_heap(this->heap.begin(), this->heap.end(), laterEvent);
+    event = std::move(this->heap.back());
+    this->heap.pop_back();
+}
+
+void EventQueue::pushNormalPktEvent(pktevent_p<normalpkt_p> &pktEvent, uint64_t uid){
+    SimEvent event;
+    event.time = pktEvent->pktForwardTime;
+    event.type = SimEventType::NormalPkt;
+    event.key = pktEvent->pkt->orderKey;
+    event.uid = uid;
+    event.normalPktEvent = pktEvent;
+
+    this->push(event);
+}
+
+void EventQueue::pushTriggerPktEvent(const PktEvent<triggerpkt_p> &pktEvent, uint64_t uid){
+    SimEvent event;
+    event.time = pktEvent.pktForwardTime;
+    event.type = SimEventType::TriggerPkt;
+    event.key = getTriggerPktEventKey(*pktEvent.pkt);
+    event.uid = uid;
+    event.triggerPktEvent = pktEvent;
+
+    this->push(event);
+}
+
+
+static inline bool laterTriggerPktEvent(const TriggerPktQueue::entry_t &a, const TriggerPktQueue::entry_t &b){
+    if(a.event.pktForwardTime != b.event.pktForwardTime)
+        return a.event.pktForwardTime > b.event.pktForwardTime;
+    return a.seq > b.seq;
+}
+
+void TriggerPktQueue::push(const PktEvent<triggerpkt_p> &event){
+    entry_t entry;
+    entry.seq = this->nextSeq++;
+    entry.event = event;
+
+    this->heap.push_back(entry);
+    std::push_heap(this->heap.begin(), this->heap.end(), laterTriggerPktEvent);
+}
+
+/* Enqueues all copies of a trigger pkt flood hop (one per neighbor) at once */
+void TriggerPktQueue::pushBatch(const std::vector<PktEvent<triggerpkt_p>> &batch){
+    for(auto it = batch.begin(); it != batch.end(); it++){
+        this->push(*it);
+    }
+}
+
+void TriggerPktQueue::pop(PktEvent<triggerpkt_p> &event){
+    std::pop_heap(this->heap.begin(), this->heap.end(), laterTriggerPktEvent);
+    event = this->heap.back().event;
+    this->heap.pop_back();
+}
@@ -0,0 +1,90 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <vector>
+#include "simulation/event.hpp"
+#include "utils/utils.hpp"
+
+/*
+    Event types of the event-driven engine (EVENT_DRIVEN=1).
+    The order of the enum is also the processing order for events due at the same time.
+    It mirrors the order of the steps in the tick-based main loop.
+    Only TriggerPkt and NormalPkt events are queued. Host pkts come from the HostScheduler of the partition
+    (OPTIMISTIC_ENGINE also queues the host pkt sends that were rolled back),
+    and the TriggerGen/IncastGen events are run by Simulation::runEventDriven() at window barriers.
+    The other types are still used to place the end of a window between events of the same time.
+*/
+enum class SimEventType {HostPkt, TriggerGen, TriggerPkt, NormalPkt, IncastGen};
+
+/* True if an event (time, type) is ordered before the end (endTime, endType) of a window */
+inline bool isBeforeWindowEnd(sim_time_t time, SimEventType type, sim_time_t endTime, SimEventType endType){
+    return time < endTime || (time == endTime && type < endType);
+}
+
+struct SimEvent
+{
+    sim_time_t time;
+    uint64_t key; // breaks ties between events of same time and type. Derived from the pkt, so the order doesn't depend on insertion order (PARALLEL_ENGINE)
+    SimEventType type;
+    uint64_t uid; // OPTIMISTIC_ENGINE only: identifies the event for cancellations. Partition id in the top 16 bits.
+
+    pktevent_p<normalpkt_p> normalPktEvent; // NormalPkt events only
+    PktEvent<triggerpkt_p> triggerPktEvent; // TriggerPkt events only. By value: no allocation per flood copy.
+};
+
+/* Processing order of the event-driven engines: (time, type, key) */
+inline bool isEarlierEvent(const SimEvent &a, const SimEvent &b){
+    if(a.time != b.time)
+        return a.time < b.time;
+    if(a.type != b.type)
+        return a.type < b.type;
+    return a.key < b.key;
+}
+
+/* A switch forwards a trigger at most once to each neighbor. The trigger ids fit in the rest (see TriggerGenerator) */
+inline uint64_t getTriggerPktEventKey(const TriggerPkt &pkt){
+    unsigned int switchBits = getIdKeyBits(syndbConfig.numSwitches);
+    return ((uint64_t)pkt.triggerId << (2 * switchBits)) | ((uint64_t)pkt.srcSwitchId << switchBits) | pkt.dstSwitchId;
+}
+
+/* Time-ordered event queue of a partition. Binary min-heap on (time, type, key) */
+struct EventQueue
+{
+    std::vector<SimEvent> heap; // public for flushing the remaining events in cleanUp()
+
+    inline bool empty() const { return this->heap.empty(); };
+    inline size_t size() const { return this->heap.size(); };
+    inline const SimEvent& top() const { return this->heap.front(); };
+
+    void push(SimEvent &event);
+    void pop(SimEvent &event); // moves the earliest event into event
+
+    void pushNormalPktEvent(pktevent_p<normalpkt_p> &event, uint64_t uid = 0);
+    void pushTriggerPktEvent(const PktEvent<triggerpkt_p> &event, uint64_t uid = 0);
+};
+
+/* 
+    Time-ordered queue of trigger pkt events for the tick-based loop.
+    Binary min-heap on (pktForwardTime, seq). Events are stored by value.
+*/
+struct TriggerPktQueue
+{
+    struct entry_t {
+        uint64_t seq; // insertion order. Keeps FIFO order among events of the same time
+        PktEvent<triggerpkt_p> event;
+    };
+
+    std::vector<entry_t> heap;
+    uint64_t nextSeq = 0;
+
+    inline bool empty() const { return this->heap.empty(); };
+    inline size_t size() const { return this->heap.size(); };
+    inline sim_time_t nextForwardTime() const { return this->heap.front().event.pktForwardTime; };
+
+    void push(const PktEvent<triggerpkt_p> &event);
+    void pushBatch(const std::vector<PktEvent<triggerpkt_p>> &batch);
+    void pop(PktEvent<triggerpkt_p> &event); // moves the earliest event into event
+};
+
+
+#endif
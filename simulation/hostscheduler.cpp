@@ -0,0 +1,65 @@
+#include <stdexcept>
+#include <fmt/core.h>
+#include "simulation/hostscheduler.hpp"
+
+void HostScheduler::push(Host* host){
+    if(host->schedulerIdx != Host::notScheduled){
+        std::string msg = fmt::format("Host {} is already in the HostScheduler", host->id);
+        throw std::logic_error(msg);
+    }
+
+    this->heap.push_back(host);
+    host->schedulerIdx = this->heap.size() - 1;
+    this->siftUp(host->schedulerIdx);
+}
+
+void HostScheduler::update(Host* host){
+    size_t idx = host->schedulerIdx;
+
+    if(idx == Host::notScheduled)
+        return; // e.g. host with trafficGenDisabled
+
+    // Only one of the two would actually move the host
+    this->siftUp(idx);
+    this->siftDown(host->schedulerIdx);
+}
+
+void HostScheduler::clear(){
+    for(auto it = this->heap.begin(); it != this->heap.end(); it++){
+        (*it)->schedulerIdx = Host::notScheduled;
+    }
+    this->heap.clear();
+}
+
+void HostScheduler::siftUp(size_t idx){
+    Host* host = this->heap[idx];
+
+    while(idx > 0){
+        size_t parent = (idx - 1) / 2;
+        if(!this->earlier(host, this->heap[parent]))
+            break;
+        this->place(this->heap[parent], idx);
+        idx = parent;
+    }
+
+    this->place(host, idx);
+}
+
+void HostScheduler::siftDown(size_t idx){
+    Host* host = this->heap[idx];
+    size_t size = this->heap.size();
+
+    while(true){
+        size_t child = 2 * idx + 1;
+        if(child >= size)
+            break;
+        if(child + 1 < size && this->earlier(this->heap[child + 1], this->heap[child]))
+            child++;
+        if(!this->earlier(this->heap[child], host))
+            break;
+        this->place(this->heap[child], idx);
+        idx = child;
+    }
+
+    this->place(host, idx);
+}
@@ -0,0 +1,39 @@
+#ifndef HOSTSCHEDULER_H
+#define HOSTSCHEDULER_H
+
+#include <vector>
+#include "topology/host.hpp"
+
+/*
+    Indexed binary min-heap of hosts keyed by Host::nextPktTime (ties broken by host id).
+    Each host stores its own heap position in Host::schedulerIdx, so that a host whose
+    nextPktTime changes (new pkt generated, incast) is re-positioned in O(log n).
+    Hosts with trafficGenDisabled are never added.
+*/
+struct HostScheduler
+{
+    std::vector<Host*> heap;
+
+    inline bool empty() const { return this->heap.empty(); };
+    inline size_t size() const { return this->heap.size(); };
+    inline Host* top() const { return this->heap.front(); };
+    inline sim_time_t nextPktTime() const { return this->heap.front()->nextPktTime; };
+
+    void push(Host* host);
+    void update(Host* host); // MUST be called after host->nextPktTime is changed
+    void clear();
+
+    private:
+    inline bool earlier(const Host* a, const Host* b) const {
+        return a->nextPktTime < b->nextPktTime || (a->nextPktTime == b->nextPktTime && a->id < b->id);
+    };
+    void siftUp(size_t idx);
+    void siftDown(size_t idx);
+    inline void place(Host* host, size_t idx){
+        this->heap[idx] = host;
+        host->schedulerIdx = idx;
+    };
+};
+
+
+#endif
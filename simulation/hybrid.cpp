@@ -0,0 +1,534 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <fmt/core.h>
+#include "simulation/hybrid.hpp"
+#include "simulation/config.hpp"
+#include "simulation/simulation.hpp"
+#include "traffic/incastGenerator.hpp"
+#include "utils/logger.hpp"
+
+
+HybridModel::HybridModel(bool reference){
+    this->reference = reference;
+    this->fluid = false;
+    this->fluidTime = 0;
+    this->nextAction = 0;
+    this->nextActionTime = std::numeric_limits<sim_time_t>::max();
+    this->numFluidPhases = 0;
+    this->fluidStartTime = 0;
+    this->totalFluidTime = 0;
+    this->fluidBytes = 0;
+}
+
+void HybridModel::init(){
+
+    if(syndbConfig.topoType != TopologyType::FatTree){
+        std::string msg = "The hybrid fluid/pkt mode only routes the fluid traffic on FatTree topologies";
+        throw std::logic_error(msg);
+    }
+
+    #if !TRIGGERS_ENABLED
+    std::string msg = "The hybrid fluid/pkt mode places its pkt-level windows around the triggers. Enable TRIGGERS_ENABLED.";
+    throw std::logic_error(msg);
+    #endif
+
+    if(syndbConfig.checkpointIntervalMSecs > 0 || !syndbConfig.restoreCheckpointFile.empty() || syndbConfig.numWhatIfBranches > 0){
+        std::string msg = "Hybrid fluid/pkt runs can neither checkpoint, be restored from a checkpoint nor fork what-if branches";
+        throw std::logic_error(msg);
+    }
+
+    if(syndbConfig.hybridMeasureNs > syndbConfig.hybridWarmInNs){
+        std::string msg = fmt::format("hybridMeasureNs of {}ns must not be longer than the hybridWarmInNs of {}ns", syndbConfig.hybridMeasureNs, syndbConfig.hybridWarmInNs);
+        throw std::logic_error(msg);
+    }
+
+    this->buildLinks();
+    if(!this->reference)
+        this->computeRates();
+    this->scheduleActions();
+    this->printSetup();
+
+    // The first pkt-level window may only start later
+    if(syndbSim->currTime >= this->nextActionTime)
+        this->runActions(syndbSim->currTime);
+}
+
+/*
+    Time-parallel mode: the coarse pre-pass of a window is a fluid phase from 0 to warmUpStart (incasts included),
+    which leaves the queues in the state the pkt-level warm-up starts from. The snapshots at the seams
+    (windowStart, and the end of the run unless lastWindow) are compared with the ones of the neighbor windows.
+*/
+void HybridModel::initTimeWindow(sim_time_t warmUpStart, sim_time_t windowStart, bool lastWindow){
+
+    if(syndbConfig.topoType != TopologyType::FatTree){
+        std::string msg = "The time-parallel mode routes the fluid traffic of its pre-pass on FatTree topologies only";
+        throw std::logic_error(msg);
+    }
+
+    this->buildLinks();
+    this->computeRates();
+
+    if(warmUpStart > 0){
+        this->addAction(0, HybridActionType::EnterFluid);
+        this->addAction(warmUpStart, HybridActionType::EnterPacket);
+    }
+    if(windowStart > 0){
+        this->addAction(windowStart - syndbConfig.hybridMeasureNs, HybridActionType::MeasureStart);
+        this->addAction(windowStart, HybridActionType::TriggerSnapshot);
+    }
+    if(!lastWindow){
+        this->addAction(syndbSim->totalTime - syndbConfig.hybridMeasureNs, HybridActionType::MeasureStart);
+        this->addAction(syndbSim->totalTime, HybridActionType::TriggerSnapshot);
+    }
+    this->sortActions();
+
+    if(syndbSim->currTime >= this->nextActionTime)
+        this->runActions(syndbSim->currTime);
+}
+
+/* Both directions of every link. In switch/host id order, so that the links of the hybrid and the full run match. */
+void HybridModel::buildLinks(){
+
+    Topology &topo = *syndbSim->topo;
+
+    auto addLink = [this](sim_time_t* nextIdleTime, byte_count_t* byteCount, link_speed_gbps_t speed){
+        fluidLink link;
+        link.nextIdleTime = nextIdleTime;
+        link.byteCount = byteCount;
+        link.capacity = speed / 8.0;
+        link.rate = 0;
+        link.backlog = 0;
+        link.servedBytes = 0;
+        this->links.push_back(link);
+        return this->links.size() - 1;
+    };
+
+    this->switchLinks.resize(topo.nextSwitchId);
+    for(switch_id_t swId = 0; swId < topo.nextSwitchId; swId++){
+        Switch* sw = topo.getSwitchById(swId);
+
+        std::vector<switch_id_t> neighbors;
+        for(auto it = sw->neighborSwitchTable.begin(); it != sw->neighborSwitchTable.end(); it++)
+            neighbors.push_back(it->first);
+        std::sort(neighbors.begin(), neighbors.end());
+
+        // A link's queue towards a switch is keyed by that switch (see Switch::scheduleToNextHopSwitch())
+        for(auto it = neighbors.begin(); it != neighbors.end(); it++){
+            NetworkLink* link = sw->neighborSwitchTable[*it];
+            linkQueue &queue = link->getQueueTowards(*it);
+            this->switchLinks[swId][*it] = addLink(&queue.nextIdleTime, &queue.byteCount, link->speed);
+        }
+    }
+
+    this->hostUpLinks.resize(topo.nextHostId);
+    this->hostDownLinks.resize(topo.nextHostId);
+    for(host_id_t hostId = 0; hostId < topo.nextHostId; hostId++){
+        HostTorLink* link = topo.getHostById(hostId)->torLink;
+        this->hostUpLinks[hostId] = addLink(&link->next_idle_time_to_tor, &link->byte_count_to_tor, link->speed);
+        this->hostDownLinks[hostId] = addLink(&link->next_idle_time_to_host, &link->byte_count_to_host, link->speed);
+    }
+}
+
+/* The links from a ToR to a host, as the switches route the pkts. Without the host's own link to its ToR. */
+void HybridModel::getRoute(switch_id_t torId, host_id_t dstHost, std::vector<size_t> &route){
+
+    Topology &topo = *syndbSim->topo;
+    Switch* sw = topo.getSwitchById(torId);
+    Switch* nextHop;
+
+    route.clear();
+    while(sw->neighborHostTable.count(dstHost) == 0){
+        switch(sw->type){
+            case SwitchType::FtTor:
+                nextHop = static_cast<SwitchFtTor*>(sw)->getNextHop(dstHost);
+                break;
+            case SwitchType::FtAggr: {
+                auto it = sw->neighborSwitchTable.find(topo.getTorId(dstHost));
+                if(it != sw->neighborSwitchTable.end())
+                    nextHop = topo.getSwitchById(it->first);
+                else
+                    nextHop = static_cast<SwitchFtAggr*>(sw)->getNextHop(dstHost);
+                break;
+            }
+            case SwitchType::FtCore:
+                nextHop = static_cast<SwitchFtCore*>(sw)->getNextHop(dstHost);
+                break;
+            default:
+                std::string msg = fmt::format("No fluid route from {} switch {}", switchTypeToString(sw->type), sw->id);
+                throw std::logic_error(msg);
+        }
+
+        route.push_back(this->switchLinks[sw->id].at(nextHop->id));
+        sw = nextHop;
+    }
+
+    route.push_back(this->hostDownLinks[dstHost]);
+}
+
+/* The mean rate of every host, split over its dsts by the traffic pattern. One rack at a time, to keep the dst rates small. */
+void HybridModel::computeRates(){
+
+    Topology &topo = *syndbSim->topo;
+    std::vector<double> dstRates(topo.nextHostId);
+    const std::set<switch_id_t> &tors = topo.switchTypeIDMap[SwitchType::FtTor];
+
+    for(auto torIt = tors.begin(); torIt != tors.end(); torIt++){
+        Switch* tor = topo.getSwitchById(*torIt);
+        std::fill(dstRates.begin(), dstRates.end(), 0);
+
+        for(auto it = tor->neighborHostTable.begin(); it != tor->neighborHostTable.end(); it++){
+            Host* host = topo.getHostById(it->first);
+            if(host->trafficGenDisabled)
+                continue;
+
+            double rate = host->trafficGen->getMeanRate(syndbConfig.torLinkSpeedGbps);
+            this->links[this->hostUpLinks[host->id]].rate += rate;
+            host->trafficPattern->addDstRates(rate, dstRates);
+        }
+
+        for(host_id_t dst = 0; dst < topo.nextHostId; dst++){
+            if(dstRates[dst] == 0)
+                continue;
+
+            this->getRoute(*torIt, dst, this->routeLinks);
+            for(auto it = this->routeLinks.begin(); it != this->routeLinks.end(); it++)
+                this->links[*it].rate += dstRates[dst];
+        }
+    }
+}
+
+/* The pkt-level windows around the triggers (merged where they overlap) and the snapshots before each trigger */
+void HybridModel::scheduleActions(){
+
+    TriggerGenerator &triggerGen = *syndbSim->triggerGen;
+    std::vector<sim_time_t> triggerTimes;
+
+    if(triggerGen.nextTriggerTime != std::numeric_limits<sim_time_t>::max())
+        triggerTimes.push_back(triggerGen.nextTriggerTime);
+    for(auto it = triggerGen.nextTrigger; it != triggerGen.triggerSchedule.end(); it++)
+        triggerTimes.push_back(it->time);
+    std::sort(triggerTimes.begin(), triggerTimes.end());
+
+    sim_time_t windowEnd = 0;
+    bool inWindow = false;
+
+    for(auto it = triggerTimes.begin(); it != triggerTimes.end(); it++){
+        sim_time_t triggerTime = *it;
+
+        if(!this->reference){
+            sim_time_t start = triggerTime > syndbConfig.hybridWarmInNs ? triggerTime - syndbConfig.hybridWarmInNs : 0;
+
+            if(!inWindow || start > windowEnd){
+                if(inWindow)
+                    this->addAction(windowEnd, HybridActionType::EnterFluid);
+                else if(start > 0)
+                    this->addAction(0, HybridActionType::EnterFluid);
+
+                if(start > 0)
+                    this->addAction(start, HybridActionType::EnterPacket);
+                inWindow = true;
+            }
+            windowEnd = std::max<sim_time_t>(windowEnd, triggerTime + syndbConfig.hybridCoolDownNs);
+        }
+
+        this->addAction(triggerTime > syndbConfig.hybridMeasureNs ? triggerTime - syndbConfig.hybridMeasureNs : 0, HybridActionType::MeasureStart);
+        this->addAction(triggerTime, HybridActionType::TriggerSnapshot);
+    }
+
+    if(!this->reference){
+        if(!inWindow)
+            this->addAction(0, HybridActionType::EnterFluid); // no trigger: fluid all the time
+        else if(windowEnd <= syndbSim->totalTime)
+            this->addAction(windowEnd, HybridActionType::EnterFluid);
+    }
+
+    this->sortActions();
+}
+
+void HybridModel::addAction(sim_time_t time, HybridActionType type){
+    hybridAction action;
+    action.time = time;
+    action.type = type;
+    this->actions.push_back(action);
+}
+
+void HybridModel::sortActions(){
+    std::stable_sort(this->actions.begin(), this->actions.end(), [](const hybridAction &a, const hybridAction &b){
+        return a.time < b.time || (a.time == b.time && a.type < b.type);
+    });
+
+    this->nextAction = 0;
+    this->nextActionTime = this->actions.empty() ? std::numeric_limits<sim_time_t>::max() : this->actions[0].time;
+}
+
+void HybridModel::printSetup(){
+    if(this->reference){
+        ndebug_print("Full pkt-level reference run of the hybrid mode: snapshots at {} triggers", this->actions.size() / 2);
+        return;
+    }
+
+    sim_time_t plannedFluidTime = 0, fluidStart = 0;
+    uint64_t numWindows = 0;
+    bool fluid = false;
+    for(auto it = this->actions.begin(); it != this->actions.end(); it++){
+        if(it->type == HybridActionType::EnterFluid){
+            fluidStart = it->time;
+            fluid = true;
+        }
+        else if(it->type == HybridActionType::EnterPacket){
+            plannedFluidTime += it->time - fluidStart;
+            fluid = false;
+            numWindows++;
+        }
+    }
+    if(fluid)
+        plannedFluidTime += syndbSim->totalTime - fluidStart;
+    if(!this->actions.empty() && this->actions[0].type != HybridActionType::EnterFluid)
+        numWindows++; // starts at pkt level
+
+    ndebug_print("Hybrid fluid/pkt mode: {} pkt-level windows from {}ns before to {}ns after the triggers. {:.1f}% of the time at fluid level over {} links",
+        numWindows, syndbConfig.hybridWarmInNs, syndbConfig.hybridCoolDownNs, 100.0 * plannedFluidTime / std::max<sim_time_t>(syndbSim->totalTime, 1), this->links.size());
+}
+
+void HybridModel::runActions(sim_time_t time){
+
+    while(this->nextAction < this->actions.size() && this->actions[this->nextAction].time <= time){
+        HybridActionType type = this->actions[this->nextAction].type;
+        this->nextAction++;
+
+        switch(type){
+            case HybridActionType::EnterFluid:
+                this->enterFluid(time);
+                break;
+            case HybridActionType::EnterPacket:
+                this->enterPacket(time);
+                break;
+            case HybridActionType::MeasureStart: {
+                pkt_id_t numDelivered;
+                sim_time_t latencySum;
+                this->getDeliveredStats(numDelivered, latencySum);
+                this->measureStarts.push_back(std::make_pair(numDelivered, latencySum));
+                break;
+            }
+            case HybridActionType::TriggerSnapshot:
+                this->takeSnapshot(time);
+                break;
+        }
+    }
+
+    if(this->nextAction < this->actions.size())
+        this->nextActionTime = this->actions[this->nextAction].time;
+    else
+        this->nextActionTime = std::numeric_limits<sim_time_t>::max();
+}
+
+/* The queues in closed form: constant arrival rate, served at link capacity */
+void HybridModel::advance(sim_time_t time){
+    if(time <= this->fluidTime)
+        return;
+
+    double dt = time - this->fluidTime;
+
+    for(auto it = this->links.begin(); it != this->links.end(); it++){
+        double offered = it->backlog + it->rate * dt;
+        double served = std::min(offered, it->capacity * dt);
+        it->backlog = offered - served;
+        this->fluidBytes += served;
+
+        it->servedBytes += served;
+        if(it->servedBytes >= 1){
+            byte_count_t wholeBytes = (byte_count_t)it->servedBytes;
+            *it->byteCount += wholeBytes;
+            it->servedBytes -= wholeBytes;
+        }
+    }
+
+    this->fluidTime = time;
+}
+
+/* The hosts stop. The pkts in flight are still delivered, the queue they left behind becomes the fluid backlog. */
+void HybridModel::enterFluid(sim_time_t time){
+
+    for(auto it = syndbSim->partitions.begin(); it != syndbSim->partitions.end(); it++)
+        (*it)->hostScheduler.clear();
+
+    for(auto it = this->links.begin(); it != this->links.end(); it++){
+        it->backlog = *it->nextIdleTime > time ? (*it->nextIdleTime - time) * it->capacity : 0;
+        it->servedBytes = -it->backlog; // the byte counts already have those bytes
+    }
+
+    this->fluid = true;
+    this->fluidTime = time;
+    this->fluidStartTime = time;
+    this->numFluidPhases++;
+}
+
+/* The fluid backlogs become the idle times of the queues again, and the hosts restart from there */
+void HybridModel::enterPacket(sim_time_t time){
+
+    this->advance(time);
+
+    for(auto it = this->links.begin(); it != this->links.end(); it++){
+        sim_time_t idleTime = time + (sim_time_t)(it->backlog / it->capacity);
+        *it->nextIdleTime = std::max<sim_time_t>(*it->nextIdleTime, idleTime);
+        it->backlog = 0;
+    }
+
+    // In host id order, like Simulation::initHosts()
+    Topology &topo = *syndbSim->topo;
+    for(host_id_t hostId = 0; hostId < topo.nextHostId; hostId++){
+        Host* host = topo.getHostById(hostId);
+        if(host->trafficGenDisabled)
+            continue;
+
+        // The pkt generated before the fluid phase was never sent
+        host->torLink->byte_count_to_tor -= host->nextPkt->size + 24;
+        host->partition->freeNormalPkts.push_back(host->nextPkt);
+        host->nextPkt = NULL;
+
+        host->nextPktTime = time;
+        host->generateNextPkt();
+        host->partition->hostScheduler.push(host);
+    }
+
+    #if PARALLEL_ENGINE
+    syndbSim->assignNewPktIds();
+    #endif
+
+    this->fluid = false;
+    this->totalFluidTime += time - this->fluidStartTime;
+}
+
+/* Fluid phase: the incast pkts (one of 1500B per source, see IncastGenerator::generateIncast()) join the queues on their paths at once */
+void HybridModel::addIncast(const incastScheduleInfo &incast, sim_time_t time){
+
+    this->advance(time);
+
+    Topology &topo = *syndbSim->topo;
+    for(auto it = incast.sourceHosts.begin(); it != incast.sourceHosts.end(); it++){
+        if(topo.getHostById(*it)->trafficGenDisabled)
+            continue;
+
+        this->links[this->hostUpLinks[*it]].backlog += 1500 + 24;
+
+        this->getRoute(topo.getTorId(*it), incast.targetHostId, this->routeLinks);
+        for(auto link = this->routeLinks.begin(); link != this->routeLinks.end(); link++)
+            this->links[*link].backlog += 1500 + 24;
+    }
+}
+
+void HybridModel::finish(sim_time_t time){
+    if(!this->fluid)
+        return;
+
+    this->advance(time);
+    this->totalFluidTime += time - this->fluidStartTime;
+    this->fluidStartTime = time;
+}
+
+void HybridModel::getDeliveredStats(pkt_id_t &numDelivered, sim_time_t &latencySum){
+    numDelivered = 0;
+    latencySum = 0;
+
+    for(auto it = syndbSim->partitions.begin(); it != syndbSim->partitions.end(); it++){
+        numDelivered += (*it)->totalPktsDelivered;
+        latencySum += (*it)->deliveredLatencySum;
+    }
+}
+
+void HybridModel::takeSnapshot(sim_time_t time){
+
+    triggerFidelity snapshot;
+    snapshot.time = time;
+
+    pkt_id_t numDelivered;
+    sim_time_t latencySum;
+    this->getDeliveredStats(numDelivered, latencySum);
+
+    snapshot.numDelivered = numDelivered - this->measureStarts.front().first;
+    latencySum -= this->measureStarts.front().second;
+    snapshot.meanLatency = snapshot.numDelivered > 0 ? (double)latencySum / snapshot.numDelivered : 0;
+    this->measureStarts.pop_front();
+
+    snapshot.backlogNs.reserve(this->links.size());
+    for(auto it = this->links.begin(); it != this->links.end(); it++){
+        snapshot.backlogNs.push_back(*it->nextIdleTime > time ? (float)(*it->nextIdleTime - time) : 0);
+    }
+
+    this->snapshots.push_back(std::move(snapshot));
+}
+
+static double relativeError(double value, double reference){
+    if(reference == 0)
+        return value == 0 ? 0 : 1;
+    return std::fabs(value - reference) / reference;
+}
+
+fidelityErrors compareSnapshots(const triggerFidelity &reference, const triggerFidelity &snapshot){
+
+    if(reference.backlogNs.size() != snapshot.backlogNs.size()){
+        std::string msg = fmt::format("Snapshots of {} and {} links at {}ns can't be compared", reference.backlogNs.size(), snapshot.backlogNs.size(), reference.time);
+        throw std::logic_error(msg);
+    }
+
+    double backlogDiff = 0, backlogRef = 0;
+    for(size_t link = 0; link < reference.backlogNs.size(); link++){
+        backlogDiff += std::fabs(snapshot.backlogNs[link] - reference.backlogNs[link]);
+        backlogRef += reference.backlogNs[link];
+    }
+
+    fidelityErrors errors;
+    errors.latency = relativeError(snapshot.meanLatency, reference.meanLatency);
+    errors.delivered = relativeError(snapshot.numDelivered, reference.numDelivered);
+    errors.backlog = backlogRef > 0 ? backlogDiff / backlogRef : (backlogDiff > 0 ? 1 : 0);
+    return errors;
+}
+
+void reportHybridFidelity(const std::vector<triggerFidelity> &full, const std::vector<triggerFidelity> &hybrid, const std::string &prefix){
+
+    size_t numTriggers = std::min(full.size(), hybrid.size()); // fewer if a run was stopped
+    double latencyErrSum = 0, deliveredErrSum = 0, backlogErrSum = 0;
+    double latencyErrMax = 0, deliveredErrMax = 0, backlogErrMax = 0;
+
+    std::ofstream file("./data/" + prefix + "fidelity.txt");
+    file << "time meanLatencyFull meanLatencyHybrid deliveredFull deliveredHybrid latencyErr deliveredErr backlogErr" << std::endl;
+
+    for(size_t i = 0; i < numTriggers; i++){
+        const triggerFidelity &f = full[i];
+        const triggerFidelity &h = hybrid[i];
+
+        if(f.time != h.time){
+            std::string msg = fmt::format("The hybrid and the full run differ in trigger {}: at {}ns vs. {}ns", i, h.time, f.time);
+            throw std::logic_error(msg);
+        }
+
+        fidelityErrors errors = compareSnapshots(f, h);
+        double latencyErr = errors.latency;
+        double deliveredErr = errors.delivered;
+        double backlogErr = errors.backlog;
+
+        latencyErrSum += latencyErr;
+        deliveredErrSum += deliveredErr;
+        backlogErrSum += backlogErr;
+        latencyErrMax = std::max(latencyErrMax, latencyErr);
+        deliveredErrMax = std::max(deliveredErrMax, deliveredErr);
+        backlogErrMax = std::max(backlogErrMax, backlogErr);
+
+        file << fmt::format("{} {:.1f} {:.1f} {} {} {:.4f} {:.4f} {:.4f}", f.time, f.meanLatency, h.meanLatency, f.numDelivered, h.numDelivered, latencyErr, deliveredErr, backlogErr) << std::endl;
+    }
+    file.close();
+
+    ndebug_print_yellow("#####  Hybrid mode fidelity vs. the full run  #####");
+    ndebug_print("Warm-in {}ns | Cool-down {}ns | Pkts delivered in the {}ns before each of {} triggers",
+        syndbConfig.hybridWarmInNs, syndbConfig.hybridCoolDownNs, syndbConfig.hybridMeasureNs, numTriggers);
+    if(numTriggers == 0)
+        return;
+
+    ndebug_print("Mean latency error: {:.2f}% mean | {:.2f}% max", 100.0 * latencyErrSum / numTriggers, 100.0 * latencyErrMax);
+    ndebug_print("Delivered pkts error: {:.2f}% mean | {:.2f}% max", 100.0 * deliveredErrSum / numTriggers, 100.0 * deliveredErrMax);
+    ndebug_print("Link backlog error: {:.2f}% mean | {:.2f}% max", 100.0 * backlogErrSum / numTriggers, 100.0 * backlogErrMax);
+    ndebug_print("Per trigger: ./data/{}fidelity.txt", prefix);
+}
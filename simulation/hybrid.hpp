@@ -0,0 +1,108 @@
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include "utils/types.hpp"
+
+struct incastScheduleInfo;
+
+/* One direction of a link, as seen by the fluid model */
+struct fluidLink
+{
+    sim_time_t* nextIdleTime; // the queue of the pkt-level model
+    byte_count_t* byteCount;
+    double capacity; // bytes/ns
+    double rate; // offered load of the background traffic. bytes/ns
+    double backlog; // bytes queued. Only kept up to date while fluid.
+    double servedBytes; // not yet added to byteCount (fractions of a byte)
+};
+
+enum class HybridActionType {EnterPacket, MeasureStart, TriggerSnapshot, EnterFluid}; // the order of actions at the same time
+
+struct hybridAction
+{
+    sim_time_t time;
+    HybridActionType type;
+};
+
+/* The pkt-level view of the network right before a trigger. Compared between the hybrid and the full run. */
+struct triggerFidelity
+{
+    sim_time_t time;
+    pkt_id_t numDelivered; // in the hybridMeasureNs before the trigger
+    double meanLatency; // of those pkts. ns
+    std::vector<float> backlogNs; // per fluidLink: the time until its queue is empty
+};
+
+/*
+    Hybrid fluid/pkt mode (hybridWarmInNs > 0). Only the time around the triggers is simulated at pkt level:
+    from hybridWarmInNs before each trigger to hybridCoolDownNs after it. In between, the hosts send nothing and the
+    background traffic is a constant fluid rate per link (the mean rate of the traffic gen, split by the traffic pattern
+    and routed like the pkts). The queues follow the fluid rates, and an incast adds its bytes to the queues on its paths.
+    At the start of a pkt-level window, the fluid backlog of every queue becomes its idle time again, and the hosts restart.
+    The pkts that are in flight when a fluid phase starts are still delivered.
+
+    The reference run of hybridCompareFull (reference == true) stays at pkt level and only takes the same snapshots.
+*/
+struct HybridModel
+{
+    bool reference;
+    bool fluid; // the hosts are stopped and the queues follow the fluid rates
+    sim_time_t fluidTime; // the links were advanced up to here
+    std::vector<fluidLink> links;
+    std::vector<std::unordered_map<switch_id_t, size_t>> switchLinks; // per switch id: the index in links of the direction to a neighbor switch
+    std::vector<size_t> hostUpLinks, hostDownLinks; // per host id
+
+    std::vector<hybridAction> actions; // in time order
+    size_t nextAction;
+    sim_time_t nextActionTime; // max if none is left
+
+    std::deque<std::pair<pkt_id_t, sim_time_t>> measureStarts; // delivered pkts and their latency sum at the pending MeasureStarts
+    std::vector<triggerFidelity> snapshots;
+
+    uint64_t numFluidPhases;
+    sim_time_t fluidStartTime;
+    sim_time_t totalFluidTime; // of the finished fluid phases
+    double fluidBytes; // carried by the links while fluid
+    std::vector<size_t> routeLinks; // scratch space for getRoute()
+
+    HybridModel(bool reference);
+    void init(); // after the hosts and the trigger/incast schedules are initialized
+    void initTimeWindow(sim_time_t warmUpStart, sim_time_t windowStart, bool lastWindow); // time-parallel mode, instead of init()
+    void runActions(sim_time_t time); // all actions due by time. Only between two ticks/windows.
+    void addIncast(const incastScheduleInfo &incast, sim_time_t time);
+    void finish(sim_time_t time); // end of the simulation: the links catch up with a last fluid phase
+
+    private:
+    void buildLinks();
+    void computeRates();
+    void getRoute(switch_id_t torId, host_id_t dstHost, std::vector<size_t> &route);
+    void scheduleActions();
+    void addAction(sim_time_t time, HybridActionType type);
+    void sortActions();
+    void printSetup();
+    void advance(sim_time_t time);
+    void enterFluid(sim_time_t time);
+    void enterPacket(sim_time_t time);
+    void getDeliveredStats(pkt_id_t &numDelivered, sim_time_t &latencySum);
+    void takeSnapshot(sim_time_t time);
+};
+
+/* Relative errors of a snapshot against the one of a reference run */
+struct fidelityErrors
+{
+    double latency;
+    double delivered;
+    double backlog; // the L1 distance of the per-link backlogs, relative to the total backlog of the reference
+};
+
+fidelityErrors compareSnapshots(const triggerFidelity &reference, const triggerFidelity &snapshot);
+
+/* hybridCompareFull: how far the hybrid run is off at each trigger. Also written to ./data/<prefix>fidelity.txt */
+void reportHybridFidelity(const std::vector<triggerFidelity> &full, const std::vector<triggerFidelity> &hybrid, const std::string &prefix);
+
+
+#endif
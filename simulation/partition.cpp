@@ -0,0 +1,1012 @@
+#include <algorithm>
+#include <iterator>
+#include <fmt/core.h>
+#include "simulation/partition.hpp"
+#include "simulation/config.hpp"
+#include "simulation/simulation.hpp"
+#include "utils/logger.hpp"
+#include "utils/utils.hpp"
+
+SimPartition::SimPartition(partition_id_t id) : NormalPktEventWheel(syndbConfig.timeIncrementNs){
+    this->id = id;
+    this->totalPktsDelivered = 0;
+    this->deliveredLatencySum = 0;
+    this->numTrainJoins = 0;
+    this->numTrainSplits = 0;
+    this->nextEventUid = 1;
+    this->numRollbacks = 0;
+    this->numRolledBackEvents = 0;
+}
+
+static inline void copyTriggerPkt(triggerpkt_p dst, const TriggerPkt &src){
+    dst->srcSwitchId = src.srcSwitchId;
+    dst->dstSwitchId = src.dstSwitchId;
+    dst->triggerOriginSwId = src.triggerOriginSwId;
+    dst->triggerTime = src.triggerTime;
+}
+
+
+pktevent_p<normalpkt_p> SimPartition::getNewNormalPktEvent(){
+
+    pktevent_p<normalpkt_p> newNormalPktEvent;
+
+    if(this->freeNormalPktEvents.size() > 0){
+        newNormalPktEvent = std::move(*this->freeNormalPktEvents.begin()); // retrieve
+        this->freeNormalPktEvents.pop_front(); // remove
+    }
+    else{
+        newNormalPktEvent = std::make_shared<PktEvent<normalpkt_p>>();
+    }
+
+    return std::move(newNormalPktEvent);
+}
+
+/* The new pkt gets its id from setPktId() */
+normalpkt_p SimPartition::getNewNormalPkt(pkt_size_t pktSize){
+    normalpkt_p newNormalPkt;
+
+    if(this->freeNormalPkts.size() > 0){
+        newNormalPkt = *this->freeNormalPkts.begin(); // retrieve
+        this->freeNormalPkts.pop_front(); // remove
+
+        newNormalPkt->size = pktSize;
+        newNormalPkt->switchINTInfoList.clear();
+    }
+    else{
+        newNormalPkt = new NormalPkt(0, pktSize);
+    }
+
+    return newNormalPkt;
+}
+
+/*
+    Ids follow the generation order, i.e. the orderKey (genTime, srcHost). pkt->srcHost MUST be set already.
+    With PARALLEL_ENGINE, pkts are generated concurrently by the partitions, so the ids are handed out
+    at the window barrier instead (Simulation::assignNewPktIds()). The ids are the same as with the sequential engine.
+*/
+void SimPartition::setPktId(normalpkt_p pkt, sim_time_t genTime){
+    pkt->orderKey = (genTime << getIdKeyBits(syndbConfig.numHosts)) | pkt->srcHost;
+
+    #if PARALLEL_ENGINE
+    pkt->id = SimPartition::pendingPktId;
+    this->newPkts.push_back(pkt);
+    #else
+    pkt->id = syndbSim->getNextPktId();
+    #endif
+}
+
+/* Queues a new normal pkt event for the main loop, as per the engine in use */
+void SimPartition::addNormalPktEvent(pktevent_p<normalpkt_p> &event){
+    #if OPTIMISTIC_ENGINE
+    this->sendNormalPktEvent(event);
+    return;
+    #elif PARALLEL_ENGINE
+    if(getEventPartition(*event) != this){
+        this->outgoingNormalPktEvents.push_back(event);
+        return;
+    }
+    #endif
+
+    #if EVENT_DRIVEN
+    this->eventQueue.pushNormalPktEvent(event);
+    #else
+    this->NormalPktEventWheel.insert(event->pktForwardTime, event);
+    #endif
+}
+
+/* Queues a batch of new trigger pkt events (one flood hop) for the main loop, as per the engine in use */
+void SimPartition::addTriggerPktEvents(const std::vector<PktEvent<triggerpkt_p>> &batch){
+    #if EVENT_DRIVEN
+    for(auto it = batch.begin(); it != batch.end(); it++){
+        this->addTriggerPktEvent(*it);
+    }
+    #else
+    this->TriggerPktEventQueue.pushBatch(batch);
+    #endif
+}
+
+void SimPartition::addTriggerPktEvent(const PktEvent<triggerpkt_p> &event){
+    #if OPTIMISTIC_ENGINE
+    this->sendTriggerPktEvent(event);
+    return;
+    #elif PARALLEL_ENGINE
+    if(getEventPartition(event) != this){
+        this->outgoingTriggerPktEvents.push_back(event);
+        return;
+    }
+    #endif
+
+    #if EVENT_DRIVEN
+    this->eventQueue.pushTriggerPktEvent(event);
+    #else
+    this->TriggerPktEventQueue.push(event);
+    #endif
+}
+
+/* Takes over a trigger pkt event from another partition. The pkt is copied into this partition's pool, so that each pool gets all its pkts back. */
+void SimPartition::adoptTriggerPktEvent(PktEvent<triggerpkt_p> event, SimPartition &from){
+    triggerpkt_p pkt = this->triggerPktPool.getNewTriggerPkt(event.pkt->triggerId, event.pkt->size);
+    copyTriggerPkt(pkt, *event.pkt);
+
+    from.triggerPktPool.freeTriggerPkt(event.pkt);
+    event.pkt = pkt;
+
+    this->addTriggerPktEvent(event);
+}
+
+/* Records the first reception of a trigger on a switch in the TriggerInfoMap. Deferred to the window barrier with PARALLEL_ENGINE. */
+void SimPartition::logTriggerRx(trigger_id_t triggerId, switch_id_t switchId, sim_time_t rxTime){
+    #if PARALLEL_ENGINE
+    triggerRxRecord record;
+    record.triggerId = triggerId;
+    record.switchId = switchId;
+    record.rxTime = rxTime;
+    this->triggerRxRecords.push_back(record);
+    #else
+    syndbSim->TriggerInfoMap[triggerId].rxSwitchTimes[switchId] = rxTime;
+    #endif
+}
+
+/* Sends out the already scheduled next pkt of the host and generates the pkt after it */
+void SimPartition::sendNextHostPkt(Host* host){
+
+    normalpkt_p nextPkt = host->nextPkt;
+    sim_time_t nextPktTime = host->nextPktTime;
+
+    // Generate next scheduled packet on the host. Updates host->nextPktTime.
+    host->generateNextPkt();
+    this->hostScheduler.update(host);
+
+    host->sendPkt(nextPkt, nextPktTime);
+}
+
+/*
+    Processes a due trigger pkt event: hands the pkt to the next switch and forwards it further if needed.
+    Returns true if the pkt has reached its dstSwitch and the event is done.
+*/
+bool SimPartition::processTriggerPktEvent(PktEvent<triggerpkt_p>* event){
+
+    routeScheduleInfo rsinfo;
+
+    // Pass the pkt to the next switch to handle
+    event->nextSwitch->receiveTriggerPkt(event->pkt, event->pktForwardTime); // can parallelize switch's processing?
+
+    // Handling the case that the next hop is the pkt's dstSwitch
+    if(event->nextSwitch->id == event->pkt->dstSwitchId){
+        return true;
+    }
+
+    // forward the event's packet
+    // Call routing on the next switch
+    syndb_status_t status = event->nextSwitch->routeScheduleTriggerPkt(event->pkt, event->pktForwardTime, rsinfo);
+
+    if(status != syndb_status_t::success){
+        std::string msg = fmt::format("Simulator failed to route trigger pkt of trigger event {}", event->pkt->triggerId);
+        throw std::logic_error(msg);
+    }
+
+    event->currSwitch = event->nextSwitch;
+    event->nextSwitch = rsinfo.nextSwitch;
+    event->pktForwardTime = rsinfo.pktNextForwardTime;
+
+    return false;
+}
+
+/*
+    Processes a due normal pkt event: either delivers the pkt to the dst host or passes it to the next switch.
+    Returns true if the pkt got delivered and the event is done.
+*/
+bool SimPartition::processNormalPktEvent(PktEvent<normalpkt_p>* event){
+
+    routeScheduleInfo rsinfo;
+
+    // Handling the case that the next hop is the dst Host
+    if(event->nextSwitch == NULL){
+
+        // Add end time INT data to the packet
+        event->pkt->endTime = event->pktForwardTime;
+
+        // Dump the pkt with INT data to the disk. See recycleNormalPktEvent() for PARALLEL_ENGINE.
+        #if LOGGING && !PARALLEL_ENGINE
+        if(syndbSim->isInTimeWindow(event->pkt->endTime)) // time-parallel mode: only the ones of this window
+            syndbSim->pktDumper->dumpPacket(event->pkt);
+        #endif
+        this->totalPktsDelivered += 1;
+        this->deliveredLatencySum += event->pkt->endTime - event->pkt->startTime;
+
+        #ifdef DEBUG
+        /* debug_print_yellow("\nPkt ID {} dump:", event->pkt->id);
+        debug_print("h{} --> h{}: {} ns (Start: {} ns | End: {} ns)", event->pkt->srcHost, event->pkt->dstHost, event->pkt->endTime - event->pkt->startTime, event->pkt->startTime, event->pkt->endTime);
+        auto it1 = event->pkt->switchINTInfoList.begin();
+        for(it1; it1 != event->pkt->switchINTInfoList.end(); it1++){
+            debug_print("Rx on s{} at {} ns", it1->swId, it1->rxTime);
+        } */
+        #endif
+
+        return true;
+    }
+
+    // Handling the case that the next hop is a switch (intermediate or dstTor)
+
+    // Pass the pkt to the next switch to handle
+    event->nextSwitch->receiveNormalPkt(event->pkt, event->pktForwardTime); // thread-safe
+
+    // Call routing on the next switch
+    syndb_status_t status = routeScheduleNormalPktOn(event->nextSwitch, event->pkt, event->pktForwardTime, rsinfo);
+
+
+    /* Update the event */
+    event->currSwitch = event->nextSwitch;
+    event->nextSwitch = rsinfo.nextSwitch; // will be NULL if next hop is a host
+    event->pktForwardTime = rsinfo.pktNextForwardTime;
+
+    return false;
+}
+
+/* Returns the delivered pkt and its (now empty) event to the free lists */
+void SimPartition::recycleNormalPktEvent(pktevent_p<normalpkt_p> &event){
+    #if LOGGING && PARALLEL_ENGINE
+    // Dumped (in the sequential engine's order) and recycled at the window barrier
+    this->deliveredPkts.push_back(event->pkt);
+    #else
+    this->freeNormalPkts.push_back(event->pkt);
+    #endif
+    //TODO: other members of the PktEvent?
+    this->freeNormalPktEvents.push_back(std::move(event));
+}
+
+/*
+    Event-driven engine: processes the host pkts and events of this partition that are ordered before (endTime, endType),
+    in exact time order. The window MUST be short enough that no event from another partition can fall into it.
+*/
+void SimPartition::processWindow(sim_time_t endTime, SimEventType endType){
+
+    SimEvent event;
+
+    while(true){
+
+        // Host pkts go first among events of the same time (like step 1 of the tick-based loop)
+        bool hostPktIsNext = !this->hostScheduler.empty() && (this->eventQueue.empty() || this->hostScheduler.nextPktTime() <= this->eventQueue.top().time);
+
+        if(hostPktIsNext){
+            if(!isBeforeWindowEnd(this->hostScheduler.nextPktTime(), SimEventType::HostPkt, endTime, endType))
+                break;
+
+            this->sendNextHostPkt(this->hostScheduler.top());
+            continue;
+        }
+
+        if(this->eventQueue.empty() || !isBeforeWindowEnd(this->eventQueue.top().time, this->eventQueue.top().type, endTime, endType))
+            break;
+
+        this->eventQueue.pop(event);
+
+        switch(event.type){
+            case SimEventType::TriggerPkt:
+                if(this->processTriggerPktEvent(&event.triggerPktEvent))
+                    this->triggerPktPool.freeTriggerPkt(event.triggerPktEvent.pkt);
+                else
+                    this->addTriggerPktEvent(event.triggerPktEvent);
+                break;
+
+            case SimEventType::NormalPkt:
+                #if PACKET_TRAINS
+                this->processNormalPktTrain(std::move(event.normalPktEvent), endTime, endType);
+                #else
+                if(this->processNormalPktEvent(event.normalPktEvent.get()))
+                    this->recycleNormalPktEvent(event.normalPktEvent);
+                else
+                    this->addNormalPktEvent(event.normalPktEvent);
+                #endif
+                break;
+
+            default:
+                std::string msg = fmt::format("Partition {} found an event of type {} in its event queue", this->id, event.type);
+                throw std::logic_error(msg);
+        }
+
+    } // end of event loop
+}
+
+#if PACKET_TRAINS
+/*
+    Queues the event behind tail, if tail is still the last pkt of a train on the same hop and the event comes after it.
+    Otherwise the event heads a new train. Either way, it becomes the tail.
+    Pkts scheduled one after the other on the same egress queue leave it in that order, so a burst of a host
+    (or what is left of a train after a switch) keeps riding together.
+*/
+void SimPartition::addNormalPktEventToTrain(pktevent_p<normalpkt_p> &event, PktEvent<normalpkt_p>* &tail){
+
+    bool joins = tail != NULL && tail->isTrainTail && tail != event.get()
+        && tail->currSwitch == event->currSwitch && tail->nextSwitch == event->nextSwitch;
+
+    // Same order as the eventQueue: (pktForwardTime, orderKey)
+    joins = joins && (event->pktForwardTime > tail->pktForwardTime
+        || (event->pktForwardTime == tail->pktForwardTime && event->pkt->orderKey > tail->pkt->orderKey));
+
+    if(joins){
+        tail->trainNext = event;
+        tail->isTrainTail = false;
+        event->isTrainTail = true;
+        this->numTrainJoins++;
+    }
+    else{
+        this->addNormalPktEvent(event);
+        #if PARALLEL_ENGINE
+        event->isTrainTail = getEventPartition(*event) == this; // the ones sent to other partitions travel alone
+        #else
+        event->isTrainTail = true;
+        #endif
+    }
+
+    tail = event.get();
+}
+
+/* True if no host pkt or queued event comes before the event, and it is before the window end */
+bool SimPartition::isNextNormalPktEvent(const PktEvent<normalpkt_p> &event, sim_time_t endTime, SimEventType endType){
+
+    if(!isBeforeWindowEnd(event.pktForwardTime, SimEventType::NormalPkt, endTime, endType))
+        return false;
+
+    if(!this->hostScheduler.empty() && this->hostScheduler.nextPktTime() <= event.pktForwardTime)
+        return false;
+
+    if(this->eventQueue.empty())
+        return true;
+
+    // isEarlierEvent() without building a SimEvent
+    const SimEvent &top = this->eventQueue.top();
+    if(event.pktForwardTime != top.time)
+        return event.pktForwardTime < top.time;
+    if(top.type != SimEventType::NormalPkt)
+        return SimEventType::NormalPkt < top.type;
+    return event.pkt->orderKey < top.key;
+}
+
+/*
+    Processes the train that the popped event heads. Each pkt still goes through receiveNormalPkt() and
+    routeScheduleNormalPkt() of its switch on its own, at its own time: the pkts after the head are only taken
+    while they are the next event of the partition. The processing order and so the INT timestamps are the same
+    as without trains. The train splits as soon as something else comes between two of its pkts (a pkt of
+    another flow on the egress queue, a host pkt, ...). Its rest goes back into the eventQueue.
+    The pkts that leave on the same next hop form the train of that hop.
+*/
+void SimPartition::processNormalPktTrain(pktevent_p<normalpkt_p> event, sim_time_t endTime, SimEventType endType){
+
+    PktEvent<normalpkt_p>* outTail = NULL;
+
+    while(true){
+        pktevent_p<normalpkt_p> next = std::move(event->trainNext);
+        event->isTrainTail = false;
+
+        if(this->processNormalPktEvent(event.get()))
+            this->recycleNormalPktEvent(event);
+        else
+            this->addNormalPktEventToTrain(event, outTail);
+
+        if(next == NULL)
+            return;
+
+        if(!this->isNextNormalPktEvent(*next, endTime, endType)){
+            this->addNormalPktEvent(next); // keeps its pkts behind it
+            this->numTrainSplits++;
+            return;
+        }
+
+        event = std::move(next);
+    }
+}
+#endif
+
+/* Collects the in-flight normal pkt events from the event structure of the engine in use */
+void SimPartition::getRemainingNormalPktEvents(std::vector<pktevent_p<normalpkt_p>> &events){
+    #if EVENT_DRIVEN
+    for(auto it = this->eventQueue.heap.begin(); it != this->eventQueue.heap.end(); it++){
+        if(it->type == SimEventType::NormalPkt && this->cancelledEvents.count(it->uid) == 0){
+            events.push_back(it->normalPktEvent);
+            #if PACKET_TRAINS
+            for(pktevent_p<normalpkt_p> next = it->normalPktEvent->trainNext; next != NULL; next = next->trainNext)
+                events.push_back(next);
+            #endif
+        }
+    }
+    #else
+    this->NormalPktEventWheel.collectAll(events);
+    #endif
+}
+
+
+/****************************************/
+/*   OPTIMISTIC_ENGINE (Time Warp)      */
+/****************************************/
+
+/* Incremental state saving: called by Switch::schedulePkt() before it modifies the queue */
+void SimPartition::saveQueueState(Switch* sw, sim_time_t &qNextIdleTime, byte_count_t &byteCount){
+    savedQueueState state;
+    state.sw = sw;
+    state.randHopDelay = sw->randHopDelay;
+    state.qNextIdleTime = &qNextIdleTime;
+    state.nextIdleTime = qNextIdleTime;
+    state.byteCount = &byteCount;
+    state.byteCountValue = byteCount;
+
+    this->savedQueueStates.push_back(state);
+}
+
+/* Queues the event locally or sends a copy of it (and of its pkt) to the partition of its next switch */
+void SimPartition::sendNormalPktEvent(pktevent_p<normalpkt_p> &event){
+    SimPartition* dst = getEventPartition(*event);
+
+    sentEventRecord sent;
+    sent.time = event->pktForwardTime;
+    sent.type = SimEventType::NormalPkt;
+    sent.key = event->pkt->orderKey;
+    sent.uid = this->getNewEventUid();
+    sent.dst = NULL;
+
+    if(dst == this){
+        this->eventQueue.pushNormalPktEvent(event, sent.uid);
+    }
+    else{
+        // The original stays here, in case this partition has to roll back and process the event again
+        pktevent_p<normalpkt_p> copy = this->getNewNormalPktEvent();
+        *copy = *event;
+        copy->pkt = this->getNewNormalPkt(event->pkt->size);
+        *copy->pkt = *event->pkt;
+
+        timeWarpMsg msg;
+        msg.anti = false;
+        msg.event.time = sent.time;
+        msg.event.type = sent.type;
+        msg.event.key = sent.key;
+        msg.event.uid = sent.uid;
+        msg.event.normalPktEvent = copy;
+        this->outbox[dst->id].push_back(std::move(msg));
+
+        sent.dst = dst;
+        sent.normalPktEvent = event;
+    }
+
+    this->sentEvents.push_back(std::move(sent));
+}
+
+/* Queues the event locally or sends it to the partition of its next switch. A sent pkt goes back to the pool right away. */
+void SimPartition::sendTriggerPktEvent(const PktEvent<triggerpkt_p> &event){
+    SimPartition* dst = getEventPartition(event);
+
+    sentEventRecord sent;
+    sent.time = event.pktForwardTime;
+    sent.type = SimEventType::TriggerPkt;
+    sent.key = getTriggerPktEventKey(*event.pkt);
+    sent.uid = this->getNewEventUid();
+    sent.dst = NULL;
+
+    if(dst == this){
+        this->eventQueue.pushTriggerPktEvent(event, sent.uid);
+    }
+    else{
+        timeWarpMsg msg;
+        msg.anti = false;
+        msg.event.time = sent.time;
+        msg.event.type = sent.type;
+        msg.event.key = sent.key;
+        msg.event.uid = sent.uid;
+        msg.event.triggerPktEvent = event;
+        msg.event.triggerPktEvent.pkt = NULL;
+        msg.triggerPkt = *event.pkt;
+        this->outbox[dst->id].push_back(std::move(msg));
+
+        this->triggerPktPool.freeTriggerPkt(event.pkt);
+        sent.dst = dst;
+    }
+
+    this->sentEvents.push_back(std::move(sent));
+}
+
+/*
+    Time Warp version of processWindow(). Processes the events before (endTime, endType) without waiting for the
+    other partitions, and looks at the inbox after every batch of events. A msg that belongs before already processed
+    events (a straggler) or that cancels one of them rolls the partition back first.
+    Returns once the window is done for all partitions.
+*/
+void SimPartition::processWindowOptimistic(sim_time_t endTime, SimEventType endType, TimeWarpSync &sync){
+
+    while(true){
+
+        sync.receive(this->id, this->inboxMsgs);
+        for(auto it = this->inboxMsgs.begin(); it != this->inboxMsgs.end(); it++){
+            this->receiveMsg(*it);
+        }
+        size_t numMsgs = this->inboxMsgs.size();
+        this->inboxMsgs.clear();
+
+        size_t numProcessed = 0;
+        while(numProcessed < SimPartition::optimisticBatchSize && this->processNextEventOptimistic(endTime, endType)){
+            numProcessed++;
+        }
+
+        // The msgs caused by the received ones are sent before these stop counting as in transit
+        this->sendOutbox(sync);
+        if(numMsgs > 0)
+            sync.ackReceived(numMsgs);
+
+        if(numProcessed < SimPartition::optimisticBatchSize && sync.waitIdle(this->id))
+            return;
+    }
+}
+
+/* Processes the next host pkt or queued event, if it is before the window end. Returns false if there is none. */
+bool SimPartition::processNextEventOptimistic(sim_time_t endTime, SimEventType endType){
+
+    SimEvent event;
+
+    // Drop the cancelled events on top of the queue
+    while(!this->cancelledEvents.empty() && !this->eventQueue.empty()){
+        auto cancelled = this->cancelledEvents.find(this->eventQueue.top().uid);
+        if(cancelled == this->cancelledEvents.end())
+            break;
+
+        this->cancelledEvents.erase(cancelled);
+        this->eventQueue.pop(event);
+        this->discardCancelledEvent(event);
+    }
+
+    // Same order as processWindow(). The hosts' own pkts are HostPkt events keyed by the host id.
+    bool hostPktIsNext = false;
+    if(!this->hostScheduler.empty()){
+        Host* host = this->hostScheduler.top();
+        if(this->eventQueue.empty()){
+            hostPktIsNext = true;
+        }
+        else{
+            const SimEvent &top = this->eventQueue.top();
+            hostPktIsNext = host->nextPktTime < top.time || (host->nextPktTime == top.time && (top.type != SimEventType::HostPkt || host->id < top.key));
+        }
+    }
+
+    if(hostPktIsNext){
+        Host* host = this->hostScheduler.top();
+        if(!isBeforeWindowEnd(host->nextPktTime, SimEventType::HostPkt, endTime, endType))
+            return false;
+
+        // The pkt generation doesn't depend on the network, so only the send is ever rolled back
+        event.time = host->nextPktTime;
+        event.type = SimEventType::HostPkt;
+        event.key = host->id;
+        event.uid = this->getNewEventUid();
+        event.normalPktEvent = this->getNewNormalPktEvent();
+        event.normalPktEvent->pkt = host->nextPkt;
+        event.normalPktEvent->pktForwardTime = host->nextPktTime;
+        event.normalPktEvent->currSwitch = NULL;
+        event.normalPktEvent->nextSwitch = host->torSwitch;
+
+        host->generateNextPkt();
+        this->hostScheduler.update(host);
+    }
+    else{
+        if(this->eventQueue.empty() || !isBeforeWindowEnd(this->eventQueue.top().time, this->eventQueue.top().type, endTime, endType))
+            return false;
+
+        this->eventQueue.pop(event);
+    }
+
+    this->processEventOptimistic(event);
+    return true;
+}
+
+/* Processes the event like processWindow() does, and records what is needed to undo it */
+void SimPartition::processEventOptimistic(SimEvent &event){
+
+    processedEventRecord record;
+    record.savedQueueStatesBegin = this->savedQueueStates.size();
+    record.sentEventsBegin = this->sentEvents.size();
+    record.delivered = false;
+    record.firstTriggerRx = false;
+
+    switch(event.type){
+        case SimEventType::HostPkt: {
+            normalpkt_p pkt = event.normalPktEvent->pkt;
+            record.numINTInfo = pkt->switchINTInfoList.size();
+
+            Host* host = syndbSim->topo->getHostById(pkt->srcHost);
+            host->sendPkt(pkt, event.time);
+            break;
+        }
+
+        case SimEventType::NormalPkt: {
+            PktEvent<normalpkt_p>* pktEvent = event.normalPktEvent.get();
+            record.currSwitch = pktEvent->currSwitch;
+            record.nextSwitch = pktEvent->nextSwitch;
+            record.numINTInfo = pktEvent->pkt->switchINTInfoList.size();
+
+            if(this->processNormalPktEvent(pktEvent)){
+                // Recycled by fossilCollect(), once it can't be rolled back anymore
+                record.delivered = true;
+                #if LOGGING
+                this->deliveredPkts.push_back(pktEvent->pkt);
+                #endif
+            }
+            else{
+                this->addNormalPktEvent(event.normalPktEvent);
+            }
+            break;
+        }
+
+        case SimEventType::TriggerPkt: {
+            // The record keeps the event as it was
+            PktEvent<triggerpkt_p> triggerPktEvent = event.triggerPktEvent;
+            Switch* rxSwitch = triggerPktEvent.nextSwitch;
+            record.firstTriggerRx = rxSwitch->triggerHistory.find(triggerPktEvent.pkt->triggerId) == rxSwitch->triggerHistory.end();
+
+            if(!this->processTriggerPktEvent(&triggerPktEvent)){
+                std::string msg = fmt::format("Trigger pkt of trigger event {} is not single-hop", triggerPktEvent.pkt->triggerId);
+                throw std::logic_error(msg);
+            }
+            break;
+        }
+
+        default:
+            std::string msg = fmt::format("Partition {} found an event of type {} in its event queue", this->id, event.type);
+            throw std::logic_error(msg);
+    }
+
+    record.event = std::move(event);
+    this->processedEvents.push_back(std::move(record));
+}
+
+/* Handles a msg from another partition. Rolls back first if the msg is for the past of this partition. */
+void SimPartition::receiveMsg(timeWarpMsg &msg){
+
+    SimEvent &event = msg.event;
+
+    this->rollback(event);
+
+    if(msg.anti){
+        // Undo the cancelled event itself if it was processed. It is dropped when it comes out of the queue.
+        if(!this->processedEvents.empty() && this->processedEvents.back().event.uid == event.uid)
+            this->undoLastEvent();
+
+        this->cancelledEvents.insert(event.uid);
+        return;
+    }
+
+    if(event.type == SimEventType::TriggerPkt){
+        triggerpkt_p pkt = this->triggerPktPool.getNewTriggerPkt(msg.triggerPkt.triggerId, msg.triggerPkt.size);
+        copyTriggerPkt(pkt, msg.triggerPkt);
+        event.triggerPktEvent.pkt = pkt;
+    }
+    else{
+        this->receivedPkts.push_back(event.normalPktEvent->pkt);
+    }
+
+    this->eventQueue.push(event);
+}
+
+/* Undoes all the processed events that come after the straggler event */
+void SimPartition::rollback(const SimEvent &straggler){
+
+    if(this->processedEvents.empty() || !isEarlierEvent(straggler, this->processedEvents.back().event))
+        return;
+
+    this->numRollbacks++;
+
+    while(!this->processedEvents.empty() && isEarlierEvent(straggler, this->processedEvents.back().event)){
+        this->undoLastEvent();
+    }
+}
+
+/* Restores the state from before the last processed event, cancels the events it created and queues it again */
+void SimPartition::undoLastEvent(){
+
+    processedEventRecord &record = this->processedEvents.back();
+
+    // Queue states (and hop delay RNGs), latest first
+    while(this->savedQueueStates.size() > record.savedQueueStatesBegin){
+        savedQueueState &state = this->savedQueueStates.back();
+        *state.qNextIdleTime = state.nextIdleTime;
+        *state.byteCount = state.byteCountValue;
+        state.sw->randHopDelay = state.randHopDelay;
+        this->savedQueueStates.pop_back();
+    }
+
+    // Local events are dropped lazily. Remote ones get an anti-message.
+    while(this->sentEvents.size() > record.sentEventsBegin){
+        sentEventRecord &sent = this->sentEvents.back();
+
+        if(sent.dst == NULL){
+            this->cancelledEvents.insert(sent.uid);
+        }
+        else{
+            timeWarpMsg msg;
+            msg.anti = true;
+            msg.event.time = sent.time;
+            msg.event.type = sent.type;
+            msg.event.key = sent.key;
+            msg.event.uid = sent.uid;
+            this->outbox[sent.dst->id].push_back(std::move(msg));
+        }
+        this->sentEvents.pop_back();
+    }
+
+    switch(record.event.type){
+        case SimEventType::HostPkt:
+        case SimEventType::NormalPkt: {
+            PktEvent<normalpkt_p>* pktEvent = record.event.normalPktEvent.get();
+
+            while(pktEvent->pkt->switchINTInfoList.size() > record.numINTInfo){
+                pktEvent->pkt->switchINTInfoList.pop_back();
+            }
+
+            if(record.event.type == SimEventType::HostPkt)
+                break;
+
+            if(record.delivered){
+                this->totalPktsDelivered--;
+                this->deliveredLatencySum -= pktEvent->pkt->endTime - pktEvent->pkt->startTime;
+                #if LOGGING
+                this->deliveredPkts.pop_back();
+                #endif
+            }
+
+            pktEvent->currSwitch = record.currSwitch;
+            pktEvent->nextSwitch = record.nextSwitch;
+            pktEvent->pktForwardTime = record.event.time;
+            break;
+        }
+
+        case SimEventType::TriggerPkt:
+            if(record.firstTriggerRx){
+                record.event.triggerPktEvent.nextSwitch->triggerHistory.erase(record.event.triggerPktEvent.pkt->triggerId);
+                this->triggerRxRecords.pop_back();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    this->eventQueue.push(record.event);
+    this->processedEvents.pop_back();
+    this->numRolledBackEvents++;
+}
+
+/* Frees what only the cancelled event held. A local NormalPkt event object lives on (queued again under a new uid). */
+void SimPartition::discardCancelledEvent(SimEvent &event){
+    bool receivedCopy = (event.uid >> 48) != this->id;
+
+    switch(event.type){
+        case SimEventType::TriggerPkt:
+            this->triggerPktPool.freeTriggerPkt(event.triggerPktEvent.pkt);
+            break;
+
+        case SimEventType::NormalPkt:
+            if(receivedCopy){
+                this->freeNormalPkts.push_back(event.normalPktEvent->pkt);
+                this->freeNormalPktEvents.push_back(std::move(event.normalPktEvent));
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void SimPartition::sendOutbox(TimeWarpSync &sync){
+    for(partition_id_t dst = 0; dst < this->outbox.size(); dst++){
+        if(!this->outbox[dst].empty())
+            sync.send(dst, this->outbox[dst]);
+    }
+}
+
+/*
+    Called at the window barrier. GVT is then the window end: nothing before it can be rolled back anymore.
+    Recycles what the processed events still held and drops the rollback state.
+*/
+void SimPartition::fossilCollect(){
+
+    for(auto it = this->processedEvents.begin(); it != this->processedEvents.end(); it++){
+        switch(it->event.type){
+            case SimEventType::HostPkt:
+                // Only the wrapper event. The pkt went on in the event created by Host::sendPkt().
+                this->freeNormalPktEvents.push_back(std::move(it->event.normalPktEvent));
+                break;
+
+            case SimEventType::NormalPkt:
+                if(it->delivered){
+                    // With LOGGING, the pkt is recycled after its dump (Simulation::dumpDeliveredPkts())
+                    #if !LOGGING
+                    this->freeNormalPkts.push_back(it->event.normalPktEvent->pkt);
+                    #endif
+                    this->freeNormalPktEvents.push_back(std::move(it->event.normalPktEvent));
+                }
+                break;
+
+            case SimEventType::TriggerPkt:
+                this->triggerPktPool.freeTriggerPkt(it->event.triggerPktEvent.pkt);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // The originals of the NormalPkt events that went to other partitions
+    for(auto it = this->sentEvents.begin(); it != this->sentEvents.end(); it++){
+        if(it->normalPktEvent){
+            this->freeNormalPkts.push_back(it->normalPktEvent->pkt);
+            this->freeNormalPktEvents.push_back(std::move(it->normalPktEvent));
+        }
+    }
+
+    this->processedEvents.clear();
+    this->savedQueueStates.clear();
+    this->sentEvents.clear();
+}
+
+
+void PartitionWorkers::start(std::vector<std::unique_ptr<SimPartition>> &partitions){
+    #if OPTIMISTIC_ENGINE
+    this->timeWarp.init(partitions.size());
+    #endif
+
+    for(auto it = partitions.begin(); it != partitions.end(); it++){
+        this->threads.push_back(std::thread(&PartitionWorkers::workerLoop, this, it->get(), syndbSim));
+    }
+}
+
+void PartitionWorkers::runWindow(sim_time_t endTime, SimEventType endType){
+    std::unique_lock<std::mutex> lock(this->mtx);
+
+    this->endTime = endTime;
+    this->endType = endType;
+    this->numDone = 0;
+    #if OPTIMISTIC_ENGINE
+    this->timeWarp.startWindow();
+    #endif
+    this->windowNum++;
+    this->windowStartCv.notify_all();
+
+    this->windowDoneCv.wait(lock, [this]{ return this->numDone == this->threads.size(); });
+
+    if(this->error){
+        std::exception_ptr error = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void PartitionWorkers::workerLoop(SimPartition* partition, Simulation* sim){
+    syndbSim = sim;
+    uint64_t lastWindowNum = 0;
+    sim_time_t endTime;
+    SimEventType endType;
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->windowStartCv.wait(lock, [&]{ return this->stopping || this->windowNum != lastWindowNum; });
+            if(this->stopping)
+                return;
+
+            lastWindowNum = this->windowNum;
+            endTime = this->endTime;
+            endType = this->endType;
+        }
+
+        try{
+            #if OPTIMISTIC_ENGINE
+            partition->processWindowOptimistic(endTime, endType, this->timeWarp);
+            #else
+            partition->processWindow(endTime, endType);
+            #endif
+        }
+        catch(...){
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                if(!this->error)
+                    this->error = std::current_exception();
+            }
+            #if OPTIMISTIC_ENGINE
+            this->timeWarp.abortWindow(); // the others would wait for this partition forever
+            #endif
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->numDone++;
+            if(this->numDone == this->threads.size())
+                this->windowDoneCv.notify_one();
+        }
+    }
+}
+
+void PartitionWorkers::stop(){
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        this->stopping = true;
+    }
+    this->windowStartCv.notify_all();
+
+    for(auto it = this->threads.begin(); it != this->threads.end(); it++){
+        it->join();
+    }
+    this->threads.clear();
+
+    // Ready for another start()
+    this->stopping = false;
+    this->windowNum = 0;
+}
+
+PartitionWorkers::~PartitionWorkers(){
+    this->stop();
+}
+
+
+void TimeWarpSync::init(size_t numPartitions){
+    this->inboxes.resize(numPartitions);
+    this->hasMail.assign(numPartitions, false);
+    this->mailCvs.clear();
+    for(size_t i = 0; i < numPartitions; i++){
+        this->mailCvs.emplace_back();
+    }
+}
+
+/* Called with all partitions stopped */
+void TimeWarpSync::startWindow(){
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->numIdle = 0;
+    this->windowDone = false;
+}
+
+void TimeWarpSync::send(partition_id_t dst, std::vector<timeWarpMsg> &msgs){
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    this->numInTransit += msgs.size();
+    std::move(msgs.begin(), msgs.end(), std::back_inserter(this->inboxes[dst]));
+    msgs.clear();
+
+    this->hasMail[dst] = true;
+    this->mailCvs[dst].notify_one();
+}
+
+void TimeWarpSync::receive(partition_id_t dst, std::vector<timeWarpMsg> &msgs){
+    std::lock_guard<std::mutex> lock(this->mtx);
+    msgs.swap(this->inboxes[dst]);
+    this->hasMail[dst] = false;
+}
+
+void TimeWarpSync::ackReceived(size_t numMsgs){
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->numInTransit -= numMsgs;
+}
+
+bool TimeWarpSync::waitIdle(partition_id_t id){
+    std::unique_lock<std::mutex> lock(this->mtx);
+
+    if(this->hasMail[id])
+        return false;
+
+    this->numIdle++;
+    if(this->numIdle == this->inboxes.size() && this->numInTransit == 0){
+        this->windowDone = true;
+        for(auto it = this->mailCvs.begin(); it != this->mailCvs.end(); it++){
+            it->notify_one();
+        }
+        return true;
+    }
+
+    this->mailCvs[id].wait(lock, [&]{ return this->windowDone || this->hasMail[id]; });
+    if(this->windowDone)
+        return true;
+
+    this->numIdle--;
+    return false;
+}
+
+void TimeWarpSync::abortWindow(){
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->windowDone = true;
+    for(auto it = this->mailCvs.begin(); it != this->mailCvs.end(); it++){
+        it->notify_one();
+    }
+}
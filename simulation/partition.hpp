@@ -0,0 +1,221 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <list>
+#include <deque>
+#include <vector>
+#include <unordered_set>
+#include <memory>
+#include <limits>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include "simulation/event.hpp"
+#include "simulation/eventqueue.hpp"
+#include "simulation/timingwheel.hpp"
+#include "simulation/hostscheduler.hpp"
+
+struct triggerRxRecord
+{
+    trigger_id_t triggerId;
+    switch_id_t switchId;
+    sim_time_t rxTime;
+};
+
+/* OPTIMISTIC_ENGINE: the egress queue state and hop delay RNG of a switch, as before one Switch::schedulePkt() call */
+struct savedQueueState
+{
+    Switch* sw;
+    std::default_random_engine randHopDelay;
+    sim_time_t* qNextIdleTime;
+    sim_time_t nextIdleTime;
+    byte_count_t* byteCount;
+    byte_count_t byteCountValue;
+};
+
+/* OPTIMISTIC_ENGINE: an event created while processing another one. Cancelled if its creator is rolled back. */
+struct sentEventRecord
+{
+    sim_time_t time;
+    SimEventType type;
+    uint64_t key;
+    uint64_t uid;
+    SimPartition* dst; // NULL if queued in the own partition
+    pktevent_p<normalpkt_p> normalPktEvent; // NormalPkt sent to another partition: the original, which stays here (the dst gets a copy)
+};
+
+/* OPTIMISTIC_ENGINE: a processed event that can still be rolled back */
+struct processedEventRecord
+{
+    SimEvent event; // as it was popped. Re-queued when rolled back.
+    Switch* currSwitch; // NormalPkt: the PktEvent before processing
+    Switch* nextSwitch;
+    size_t numINTInfo; // HostPkt and NormalPkt: length of the pkt's switchINTInfoList before processing
+    bool delivered; // NormalPkt
+    bool firstTriggerRx; // TriggerPkt: the switch saw the trigger for the first time
+    size_t savedQueueStatesBegin; // the entries of this event in SimPartition::savedQueueStates
+    size_t sentEventsBegin; // and in SimPartition::sentEvents
+};
+
+/* OPTIMISTIC_ENGINE: a pkt event sent to another partition. An anti-message (same uid) cancels it. */
+struct timeWarpMsg
+{
+    bool anti;
+    SimEvent event;
+    TriggerPkt triggerPkt; // positive TriggerPkt msgs only. By value, since trigger pkt pools are per partition.
+};
+
+struct TimeWarpSync;
+struct Simulation;
+
+/*
+    A part of the network (hosts + switches) together with all the engine state needed to simulate it.
+    Every Host and Switch points to its partition. The sequential engines run a single partition.
+    With PARALLEL_ENGINE, a FatTree is split into one partition per pod and one per group of core switches,
+    each running on its own thread one window at a time (see Simulation::runEventDriven()).
+    A pkt event belongs to the partition of the switch that handles it next.
+    With OPTIMISTIC_ENGINE, the partitions don't wait for each other within a window (Time Warp): they process
+    their events speculatively and roll back when a msg from another partition arrives in their past.
+*/
+struct SimPartition
+{
+    partition_id_t id;
+
+    HostScheduler hostScheduler; // hosts ordered by nextPktTime
+    TimingWheel<pktevent_p<normalpkt_p>> NormalPktEventWheel; // tick-based engine: in-flight normal pkt events, bucketed by pktForwardTime
+    std::vector<pktevent_p<normalpkt_p>> dueNormalPktEvents; // scratch space for Simulation::processNormalPktEvents()
+    std::vector<size_t> dueForwardIdxs, dueGroupStarts; // INTRA_STEP_PARALLEL: scratch space. dueNormalPktEvents grouped by switch
+    std::vector<bool> dueIsForward;
+    TriggerPktQueue TriggerPktEventQueue; // tick-based engine: in-flight trigger pkt events, ordered by pktForwardTime
+    EventQueue eventQueue; // event-driven engine: all in-flight pkt events of the partition
+    std::vector<PktEvent<triggerpkt_p>> triggerPktBatch; // scratch space for the copies of one trigger flood hop
+    TriggerPktPool triggerPktPool;
+    std::list<pktevent_p<normalpkt_p>> freeNormalPktEvents; // to reuse shared_ptrs
+    std::list<normalpkt_p> freeNormalPkts;
+
+    /* PACKET_TRAINS only */
+    uint64_t numTrainJoins; // pkt events queued behind the tail of a train instead of in the eventQueue
+    uint64_t numTrainSplits; // trains put back into the eventQueue when another event came between two of their pkts
+
+    pkt_id_t totalPktsDelivered;
+    sim_time_t deliveredLatencySum; // of the delivered pkts. For the fidelity stats of the hybrid mode.
+
+    /* PARALLEL_ENGINE only. Filled during a window, emptied by Simulation::finishWindow() */
+    std::vector<pktevent_p<normalpkt_p>> outgoingNormalPktEvents; // events for switches of other partitions
+    std::vector<PktEvent<triggerpkt_p>> outgoingTriggerPktEvents;
+    std::vector<normalpkt_p> newPkts; // generated pkts waiting for their id
+    std::vector<normalpkt_p> deliveredPkts; // delivered pkts waiting to be dumped
+    std::vector<triggerRxRecord> triggerRxRecords; // waiting to be added to the TriggerInfoMap
+
+    /* OPTIMISTIC_ENGINE only. The rollback state of the current window, dropped by fossilCollect() at the barrier */
+    std::vector<processedEventRecord> processedEvents; // in processing order
+    std::vector<savedQueueState> savedQueueStates;
+    std::vector<sentEventRecord> sentEvents;
+    std::unordered_set<uint64_t> cancelledEvents; // still in the eventQueue. Dropped when they come out.
+    std::vector<std::vector<timeWarpMsg>> outbox; // per dst partition. Sent after every batch of events.
+    std::vector<timeWarpMsg> inboxMsgs; // scratch space
+    std::vector<normalpkt_p> receivedPkts; // pkt copies received in the window. Their id may still be pending.
+    uint64_t nextEventUid;
+    uint64_t numRollbacks, numRolledBackEvents;
+    static const size_t optimisticBatchSize = 64; // events processed between two looks at the inbox
+
+    static const pkt_id_t pendingPktId = std::numeric_limits<pkt_id_t>::max(); // PARALLEL_ENGINE: id not assigned yet
+
+    SimPartition(partition_id_t id);
+
+    pktevent_p<normalpkt_p> getNewNormalPktEvent();
+    normalpkt_p getNewNormalPkt(pkt_size_t pktSize);
+    void setPktId(normalpkt_p pkt, sim_time_t genTime);
+    void addNormalPktEvent(pktevent_p<normalpkt_p> &event);
+    void addTriggerPktEvents(const std::vector<PktEvent<triggerpkt_p>> &batch);
+    void addTriggerPktEvent(const PktEvent<triggerpkt_p> &event);
+    void adoptTriggerPktEvent(PktEvent<triggerpkt_p> event, SimPartition &from);
+    void logTriggerRx(trigger_id_t triggerId, switch_id_t switchId, sim_time_t rxTime);
+    void sendNextHostPkt(Host* host);
+    bool processTriggerPktEvent(PktEvent<triggerpkt_p>* event);
+    bool processNormalPktEvent(PktEvent<normalpkt_p>* event);
+    void recycleNormalPktEvent(pktevent_p<normalpkt_p> &event);
+    void processWindow(sim_time_t endTime, SimEventType endType);
+
+    /* PACKET_TRAINS */
+    void addNormalPktEventToTrain(pktevent_p<normalpkt_p> &event, PktEvent<normalpkt_p>* &tail);
+    void processNormalPktTrain(pktevent_p<normalpkt_p> event, sim_time_t endTime, SimEventType endType);
+    bool isNextNormalPktEvent(const PktEvent<normalpkt_p> &event, sim_time_t endTime, SimEventType endType);
+    void getRemainingNormalPktEvents(std::vector<pktevent_p<normalpkt_p>> &events);
+
+    /* OPTIMISTIC_ENGINE (Time Warp) */
+    inline uint64_t getNewEventUid() { return ((uint64_t)this->id << 48) | this->nextEventUid++; };
+    void saveQueueState(Switch* sw, sim_time_t &qNextIdleTime, byte_count_t &byteCount);
+    void sendNormalPktEvent(pktevent_p<normalpkt_p> &event);
+    void sendTriggerPktEvent(const PktEvent<triggerpkt_p> &event);
+    void processWindowOptimistic(sim_time_t endTime, SimEventType endType, TimeWarpSync &sync);
+    bool processNextEventOptimistic(sim_time_t endTime, SimEventType endType);
+    void processEventOptimistic(SimEvent &event);
+    void receiveMsg(timeWarpMsg &msg);
+    void rollback(const SimEvent &straggler);
+    void undoLastEvent();
+    void discardCancelledEvent(SimEvent &event);
+    void sendOutbox(TimeWarpSync &sync);
+    void fossilCollect();
+};
+
+/* The partition that has to process the event: the one of the next switch, or of the dst ToR when the next hop is the dst host */
+template<typename T>
+inline SimPartition* getEventPartition(const PktEvent<T> &event){
+    return event.nextSwitch != NULL ? event.nextSwitch->partition : event.currSwitch->partition;
+}
+
+/*
+    OPTIMISTIC_ENGINE: the inboxes of the partitions and the detection of the end of a window.
+    A window is done once all partitions are idle (no event left before the window end) and no msg is in transit.
+    A msg counts as in transit until its receiver has handled it and sent the msgs that it caused.
+*/
+struct TimeWarpSync
+{
+    std::mutex mtx;
+    std::vector<std::vector<timeWarpMsg>> inboxes;
+    std::vector<bool> hasMail;
+    std::deque<std::condition_variable> mailCvs; // one per partition (condition_variable is not movable)
+    size_t numIdle = 0;
+    int64_t numInTransit = 0;
+    bool windowDone = false;
+
+    void init(size_t numPartitions);
+    void startWindow();
+    void send(partition_id_t dst, std::vector<timeWarpMsg> &msgs); // empties msgs
+    void receive(partition_id_t dst, std::vector<timeWarpMsg> &msgs);
+    void ackReceived(size_t numMsgs);
+    bool waitIdle(partition_id_t id); // true once the window is done, false if new msgs arrived
+    void abortWindow(); // a partition failed. Releases the others.
+};
+
+/*
+    PARALLEL_ENGINE: one worker thread per partition. runWindow() lets all partitions process their window
+    and returns once every one of them is done. An exception on a worker is re-thrown by runWindow().
+*/
+struct PartitionWorkers
+{
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable windowStartCv, windowDoneCv;
+    uint64_t windowNum = 0;
+    size_t numDone = 0;
+    bool stopping = false;
+    sim_time_t endTime;
+    SimEventType endType;
+    std::exception_ptr error;
+    TimeWarpSync timeWarp; // OPTIMISTIC_ENGINE
+
+    void start(std::vector<std::unique_ptr<SimPartition>> &partitions);
+    void runWindow(sim_time_t endTime, SimEventType endType);
+    void stop(); // can be start()ed again after
+    ~PartitionWorkers();
+
+    private:
+    void workerLoop(SimPartition* partition, Simulation* sim);
+};
+
+
+#endif
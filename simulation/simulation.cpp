@@ -1,4 +1,8 @@
 #include <string>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <limits>
 #include <time.h>
 #include <fmt/core.h>
 #include "simulation/config.hpp"
@@ -7,17 +11,41 @@
 #include "utils/utils.hpp"
 #include "utils/pktdumper.hpp"
 #include "topology/fattree_topology.hpp"
+#include "topology/file_topology.hpp"
 
 
-Simulation syndbSim;
+thread_local Simulation* syndbSim = NULL;
+volatile std::sig_atomic_t syndbStopSignal = 0;
 
-Simulation::Simulation(){
+Simulation::Simulation(unsigned int replicaId){
 
     this->startTime = time(NULL); 
     this->currTime = 0;
     this->timeIncrement = syndbConfig.timeIncrementNs;
     this->totalTime = (sim_time_t)(syndbConfig.totalTimeMSecs * (float)1000000);
 
+    // NormalPkt::orderKey holds the generation time next to the src host id
+    unsigned int timeBits = 64 - getIdKeyBits(syndbConfig.numHosts);
+    if((this->totalTime >> timeBits) != 0){
+        std::string msg = fmt::format("Sim time of {}ms is too long for {} hosts: at most {}ns", syndbConfig.totalTimeMSecs, syndbConfig.numHosts, (1ULL << timeBits) - 1);
+        throw std::logic_error(msg);
+    }
+
+    #if SPECIALIZED_FATTREE
+    if(syndbConfig.topoType != TopologyType::FatTree || syndbConfig.trafficPatternType != TrafficPatternType::FtMixed || syndbConfig.trafficGenType != TrafficGenType::Distribution){
+        std::string msg = fmt::format("SPECIALIZED_FATTREE builds only run FatTree topologies with FtMixed traffic from the Distribution generator. Got {} | {} | {}",
+            syndbConfig.topoType, trafficPatternTypeToString(syndbConfig.trafficPatternType), trafficGenTypeToString(syndbConfig.trafficGenType));
+        throw std::logic_error(msg);
+    }
+    #endif
+
+    #if SOURCE_ROUTING
+    if(syndbConfig.topoType != TopologyType::FatTree || syndbConfig.fatTreeTopoK > ftPathMaxK){
+        std::string msg = fmt::format("SOURCE_ROUTING only runs FatTree topologies with k <= {}. Got {} (k={})", ftPathMaxK, syndbConfig.topoType, syndbConfig.fatTreeTopoK);
+        throw std::logic_error(msg);
+    }
+    #endif
+
     if(syndbConfig.topoType == TopologyType::Simple){
         this->topo = std::shared_ptr<Topology>(new SimpleTopology());
     }
@@ -27,10 +55,31 @@ Simulation::Simulation(){
     else if (syndbConfig.topoType == TopologyType::Line){
         this->topo = std::shared_ptr<Topology>(new LineTopology());
     }
+    else if (syndbConfig.topoType == TopologyType::File){
+        // FtMixed picks the hosts of a rack by FatTree host ids
+        if(syndbConfig.trafficPatternType == TrafficPatternType::FtMixed){
+            std::string msg = "Topology files run the AlltoAll or FtUniform traffic patterns, not FtMixed";
+            throw std::logic_error(msg);
+        }
+        this->topo = std::shared_ptr<Topology>(new FileTopology(syndbConfig.topoFile));
+    }
 
     this->nextPktId = 0;
     this->nextTriggerPktId = 0;
-    this->totalPktsDelivered = 0;
+    this->nextCheckpointTime = std::numeric_limits<sim_time_t>::max(); // see scheduleNextCheckpoint()
+    this->branchId = 0;
+    this->branchTime = std::numeric_limits<sim_time_t>::max(); // see scheduleBranching()
+
+    // Replica i of an ensemble runs with randomSeed + i - 1. Clock seeds (0) stay clock seeds.
+    this->replicaId = replicaId;
+    this->randomSeed = syndbConfig.randomSeed;
+    if(this->randomSeed != 0 && replicaId > 0)
+        this->randomSeed += replicaId - 1;
+
+    this->hybridReference = false;
+    this->timeWindowId = 0;
+    this->timeWindowStart = 0;
+    this->timeWindowEnd = std::numeric_limits<sim_time_t>::max();
 
     #if LOGGING
     this->pktDumper = std::unique_ptr<PktDumper>(new PktDumper());
@@ -38,43 +87,66 @@ Simulation::Simulation(){
     
 }
 
+/* 
+    Splits the built topology into partitions and points every host and switch to its partition.
+    With PARALLEL_ENGINE on a FatTree: one partition per pod (its ToR + Aggr switches and hosts) plus one per
+    group of core switches that connect to the same Aggr switch index in the pods. Otherwise there is a single partition.
+*/
+void Simulation::initPartitions(){
+
+    this->partitions.clear();
+    this->partitions.push_back(std::unique_ptr<SimPartition>(new SimPartition(0)));
+
+    for(auto it = this->topo->hosts.begin(); it != this->topo->hosts.end(); it++)
+        (*it)->partition = this->partitions[0].get();
+    for(auto it = this->topo->switches.begin(); it != this->topo->switches.end(); it++)
+        (*it)->partition = this->partitions[0].get();
+
+    #if PARALLEL_ENGINE
+    if(syndbConfig.topoType == TopologyType::FatTree){
+        std::shared_ptr<FattreeTopology> fatTreeTopo = std::dynamic_pointer_cast<FattreeTopology>(this->topo);
+        this->partitions.clear();
+
+        for(auto podIt = fatTreeTopo->pods.begin(); podIt != fatTreeTopo->pods.end(); podIt++){
+            this->partitions.push_back(std::unique_ptr<SimPartition>(new SimPartition(this->partitions.size())));
+            SimPartition* partition = this->partitions.back().get();
+
+            for(auto it = (*podIt)->aggrSwitches.begin(); it != (*podIt)->aggrSwitches.end(); it++)
+                (*it)->partition = partition;
+
+            for(auto it = (*podIt)->torSwitches.begin(); it != (*podIt)->torSwitches.end(); it++){
+                (*it)->partition = partition;
+                for(auto hostIt = (*it)->neighborHostTable.begin(); hostIt != (*it)->neighborHostTable.end(); hostIt++)
+                    this->topo->getHostById(hostIt->first)->partition = partition;
+            }
+        }
 
-pktevent_p<normalpkt_p> Simulation::getNewNormalPktEvent(){
-    
-    pktevent_p<normalpkt_p> newNormalPktEvent;
+        // Core switches of the same stride connect to the same Aggr switch index in all pods
+        uint coreSwitchesPerStride = fatTreeTopo->k / 2;
+        for(uint coreSwitchIdx = 0; coreSwitchIdx < fatTreeTopo->numCoreSwitches; coreSwitchIdx++){
+            if(coreSwitchIdx % coreSwitchesPerStride == 0)
+                this->partitions.push_back(std::unique_ptr<SimPartition>(new SimPartition(this->partitions.size())));
 
-    if(this->freeNormalPktEvents.size() > 0){
-        newNormalPktEvent = std::move(*this->freeNormalPktEvents.begin()); // retrieve
-        this->freeNormalPktEvents.pop_front(); // remove
+            fatTreeTopo->coreSwitches[coreSwitchIdx]->partition = this->partitions.back().get();
+        }
     }
     else{
-        newNormalPktEvent = std::make_shared<PktEvent<normalpkt_p>>();
+        ndebug_print("The parallel engine only partitions FatTree topologies. Running a single partition.");
     }
+    #endif
 
-    return std::move(newNormalPktEvent);
-}
-
-normalpkt_p Simulation::getNewNormalPkt(pkt_id_t pktId, pkt_size_t pktSize){
-    normalpkt_p newNormalPkt;
-
-    if(this->freeNormalPkts.size() > 0){
-        newNormalPkt = *this->freeNormalPkts.begin(); // retrieve
-        this->freeNormalPkts.pop_front(); // remove
-
-        newNormalPkt->id = pktId;
-        newNormalPkt->size = pktSize;
-        newNormalPkt->switchINTInfoList.clear();
-    }
-    else{
-        newNormalPkt = new NormalPkt(pktId, pktSize);
-    }
+    #if OPTIMISTIC_ENGINE
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++)
+        (*it)->outbox.resize(this->partitions.size());
+    #endif
 
-    return newNormalPkt;
+    ndebug_print("Initialized {} partitions", this->partitions.size());
 }
 
 void Simulation::initTriggerGen(){
     switch(syndbConfig.topoType){
         case TopologyType::Simple:
+        case TopologyType::File: // random switches, like on the Simple topology
             this->triggerGen = std::shared_ptr<TriggerGenerator>(new TriggerGeneratorSimpleTopo());
             break;
         case TopologyType::FatTree:
@@ -90,235 +162,537 @@ void Simulation::initIncastGen(){
     this->incastGen = std::shared_ptr<IncastGenerator>(new IncastGenerator());
 }
 
+/* Hybrid fluid/pkt mode, or the reference run it is compared against. After initHosts(). */
+void Simulation::initHybrid(){
+    if(this->timeWindowId > 0){
+        sim_time_t warmUpStart = this->timeWindowStart - std::min(this->timeWindowStart, syndbConfig.timeWindowWarmUpNs);
+        warmUpStart = (warmUpStart / this->timeIncrement) * this->timeIncrement;
+
+        this->hybrid = std::unique_ptr<HybridModel>(new HybridModel(false));
+        this->hybrid->initTimeWindow(warmUpStart, this->timeWindowStart, this->timeWindowId == syndbConfig.numTimeWindows);
+        return;
+    }
+
+    if(syndbConfig.hybridWarmInNs == 0 && !this->hybridReference)
+        return;
+
+    this->hybrid = std::unique_ptr<HybridModel>(new HybridModel(this->hybridReference));
+    this->hybrid->init();
+}
+
+/* Time-parallel mode: window windowId (1..numTimeWindows) of the run. Its seams are on the tick grid. */
+void Simulation::setTimeWindow(unsigned int windowId){
+    unsigned int numWindows = syndbConfig.numTimeWindows;
+    sim_time_t totalTime = this->totalTime;
+
+    this->timeWindowId = windowId;
+    this->timeWindowStart = (totalTime * (windowId - 1) / numWindows / this->timeIncrement) * this->timeIncrement;
+    if(windowId < numWindows){
+        this->totalTime = (totalTime * windowId / numWindows / this->timeIncrement) * this->timeIncrement;
+        this->timeWindowEnd = this->totalTime; // the next window starts there
+    }
+}
+
+void Simulation::initStepPool(){
+    unsigned int numThreads = syndbConfig.numStepThreads;
+    if(numThreads == 0)
+        numThreads = std::max<unsigned int>(1, std::thread::hardware_concurrency());
+
+    this->stepPool = std::unique_ptr<StepThreadPool>(new StepThreadPool());
+    this->stepPool->start(numThreads);
+
+    ndebug_print("Initialized {} threads for the normal pkt events of a tick", numThreads);
+}
+
+void Simulation::initTrafficPipeline(std::vector<Host*> &hosts){
+    unsigned int numThreads = syndbConfig.numTrafficGenThreads;
+    if(numThreads == 0)
+        numThreads = std::max<unsigned int>(2, std::thread::hardware_concurrency()) - 1;
+
+    this->trafficPipeline = std::unique_ptr<TrafficGenPipeline>(new TrafficGenPipeline());
+    this->trafficPipeline->start(hosts, numThreads, syndbConfig.trafficGenRingSize);
+
+    ndebug_print("Initialized {} traffic gen threads, {} pkts ahead per host", numThreads, syndbConfig.trafficGenRingSize);
+}
+
 void Simulation::initHosts(){
 
-    for (auto it = this->topo->hostIDMap.begin(); it != this->topo->hostIDMap.end(); it++)
+    std::vector<Host*> hosts;
+    for (host_id_t hostId = 0; hostId < this->topo->nextHostId; hostId++)
     {
-        Host* h = it->second.get();
+        Host* h = this->topo->getHostById(hostId);
 
         if(h->trafficGenDisabled)
             continue;
 
         if(syndbConfig.trafficPatternType == TrafficPatternType::FtMixed){
-            std::dynamic_pointer_cast<FtMixedTrafficPattern>(h->trafficPattern)->initTopoInfo();
+            std::static_pointer_cast<FtMixedTrafficPattern>(h->trafficPattern)->initTopoInfo();
         }
 
+        hosts.push_back(h);
+    }
+
+    // The producers take over the traffic generators, so only after initTopoInfo()
+    #if PIPELINED_TRAFFIC_GEN
+    this->initTrafficPipeline(hosts);
+    #endif
+
+    // In host id order, which is also the order of the ids of the first pkts
+    for(auto it = hosts.begin(); it != hosts.end(); it++){
+        Host* h = *it;
+
         h->generateNextPkt();
 
+        h->partition->hostScheduler.push(h);
+
     }
 
-    ndebug_print(fmt::format("Initialized {} hosts", this->topo->hostIDMap.size()));
+    #if PARALLEL_ENGINE
+    this->assignNewPktIds();
+    #endif
+
+    ndebug_print(fmt::format("Initialized {} hosts", this->topo->hosts.size()));
     
 }
 
-void Simulation::generateHostPktEvents(){
+/* 
+    MUST be called whenever host->nextPktTime is modified outside of the host's own pkt generation (e.g. incasts).
+    Re-positions the host in the hostScheduler of its partition. Used by all engines.
+*/
+void Simulation::rescheduleHost(Host* host){
+    host->partition->hostScheduler.update(host);
+}
+
+/* 
+    Tick-based engine: sends out all host pkts with nextPktTime <= currTime, in time order.
+    Only the hosts with a due pkt are touched, thanks to the hostScheduler.
+*/
+void Simulation::processHostPktEvents(){
+
+    SimPartition &partition = *this->partitions[0];
+
+    while(!partition.hostScheduler.empty() && partition.hostScheduler.nextPktTime() <= this->currTime){
+        partition.sendNextHostPkt(partition.hostScheduler.top());
+    }
+}
+
+
+void Simulation::processTriggerPktEvents(){
+
+    SimPartition &partition = *this->partitions[0];
+    PktEvent<triggerpkt_p> event;
+
+    // Only the due events are popped from the time-ordered queue
+    while(!partition.TriggerPktEventQueue.empty() && partition.TriggerPktEventQueue.nextForwardTime() <= this->currTime){
+
+        partition.TriggerPktEventQueue.pop(event);
+
+        if(partition.processTriggerPktEvent(&event)){
+            // The pkt requires no more network event processing
+            partition.triggerPktPool.freeTriggerPkt(event.pkt);
+        }
+        else{
+            partition.TriggerPktEventQueue.push(event);
+        }
+    }
     
-    // HostPktEventList MUST be empty
-    assert((this->HostPktEventList.size() == 0) && "HostPktEventList is NOT empty!");
+}
 
-    for(auto it = this->topo->hostIDMap.begin(); it != this->topo->hostIDMap.end(); it++){
-        Host* host = it->second.get();
 
-        // Just for debug case when trafficGen is disabled
-        if (host->trafficGenDisabled)
-            continue;
-        
-        while(host->nextPktTime <= syndbSim.currTime + syndbSim.timeIncrement){
-            // Use the next scheduled packet on the host to create hostPktEvent
-            // hostpktevent_p hostPktEvent = hostpktevent_p(new HostPktEvent(host, host->nextPkt));
+void Simulation::processNormalPktEvents(){
+
+    SimPartition &partition = *this->partitions[0];
+
+    // Only the events with pktForwardTime <= currTime come out of the timing wheel
+    partition.dueNormalPktEvents.clear(); // Making sure that the vector is empty
+    partition.NormalPktEventWheel.advance(this->currTime, partition.dueNormalPktEvents);
+
+    #if INTRA_STEP_PARALLEL
+    if(partition.dueNormalPktEvents.size() >= Simulation::minParallelStepEvents){
 
-            // Insert the hostPktEvent into the map (sorted list)
-            this->HostPktEventList.insert(std::pair<sim_time_t, HostPktEvent>(host->nextPktTime, HostPktEvent(host, host->nextPkt)));
+        this->forwardNormalPktEventsParallel(partition);
 
-            // Generate next scheduled packet on the host
-            host->generateNextPkt();
+        // Deterministic merge, in the order of the timing wheel: deliveries (and their dumps) and rescheduling
+        for(size_t idx = 0; idx < partition.dueNormalPktEvents.size(); idx++){
+            pktevent_p<normalpkt_p> &event = partition.dueNormalPktEvents[idx];
+
+            if(partition.dueIsForward[idx]){
+                partition.NormalPktEventWheel.insert(event->pktForwardTime, event);
+            }
+            else{
+                partition.processNormalPktEvent(event.get());
+                partition.recycleNormalPktEvent(event);
+            }
         }
 
+        partition.dueNormalPktEvents.clear();
+        return;
     }
+    #endif
 
-}
+    auto it = partition.dueNormalPktEvents.begin();
 
-void Simulation::processHostPktEvents(){
+    for(it; it != partition.dueNormalPktEvents.end(); it++){
 
-    normalpkt_p nextPkt;
-    sim_time_t nextPktTime;
-    Host* host;
+        if(partition.processNormalPktEvent(it->get())){
+            // Delivered. Recycle the event and its pkt
+            partition.recycleNormalPktEvent(*it);
+        }
+        else{
+            // Reschedule on the wheel as per the new pktForwardTime
+            partition.NormalPktEventWheel.insert((*it)->pktForwardTime, *it);
+        }
+    } 
 
-    auto it = this->HostPktEventList.begin();
+    partition.dueNormalPktEvents.clear();
 
-    while (it != this->HostPktEventList.end() )
-    {
-        nextPktTime = it->first;
-        host = it->second.host;
-        nextPkt = it->second.pkt;
+}
 
-        if(this->currTime < nextPktTime){
-            std::string msg = fmt::format("Currtime: {}ns. HostPktEventList has pkt with nextPktTime {}ns", this->currTime, nextPktTime);
-            throw std::logic_error(msg);
+/* 
+    INTRA_STEP_PARALLEL: passes the due events whose next hop is a switch on to that switch, using the stepPool.
+    The events are grouped by that switch. Its egress queues, hop delay RNG and ring buffer are only touched by its own group,
+    and each group keeps the order of the timing wheel. So the result is the same as processing the events one by one.
+    Deliveries to the dst host are left to the caller, which dumps them in order.
+*/
+void Simulation::forwardNormalPktEventsParallel(SimPartition &partition){
+
+    std::vector<pktevent_p<normalpkt_p>> &due = partition.dueNormalPktEvents;
+    std::vector<size_t> &idxs = partition.dueForwardIdxs;
+    std::vector<size_t> &groupStarts = partition.dueGroupStarts;
+
+    idxs.clear();
+    groupStarts.clear();
+    partition.dueIsForward.assign(due.size(), false);
+
+    for(size_t idx = 0; idx < due.size(); idx++){
+        if(due[idx]->nextSwitch != NULL){
+            idxs.push_back(idx);
+            partition.dueIsForward[idx] = true;
         }
+    }
 
-        host->sendPkt(nextPkt, nextPktTime);
+    std::stable_sort(idxs.begin(), idxs.end(), [&due](size_t a, size_t b){
+        return due[a]->nextSwitch->id < due[b]->nextSwitch->id;
+    });
 
-        it = this->HostPktEventList.erase(it); // erase and increment iterator
+    for(size_t i = 0; i < idxs.size(); i++){
+        if(i == 0 || due[idxs[i]]->nextSwitch != due[idxs[i - 1]]->nextSwitch)
+            groupStarts.push_back(i);
+    }
+    groupStarts.push_back(idxs.size());
+
+    std::function<void(size_t)> forwardGroup = [&](size_t group){
+        for(size_t i = groupStarts[group]; i < groupStarts[group + 1]; i++){
+            partition.processNormalPktEvent(due[idxs[i]].get());
+        }
+    };
 
+    this->stepPool->run(groupStarts.size() - 1, forwardGroup);
+}
+
+/* 
+    Smallest delay between a switch handling a pkt and the pkt reaching the next switch:
+    the hop delay plus the serialization of the smallest possible frame.
+    Pkts only cross partitions over switch-to-switch links, so this is the lookahead of the parallel engine.
+*/
+sim_time_t Simulation::getLookahead(){
+    #if HOP_DELAY_NOISE
+    sim_time_t minHopDelay = syndbConfig.minSwitchHopDelayNs;
+    #else
+    sim_time_t minHopDelay = syndbConfig.switchHopDelayNs;
+    #endif
+
+    sim_time_t lookahead = minHopDelay + getSerializationDelay(0, syndbConfig.networkLinkSpeedGbps);
+
+    if(lookahead == 0){
+        std::string msg = "Zero lookahead between switches. The parallel engine cannot make progress.";
+        throw std::logic_error(msg);
     }
+
+    return lookahead;
 }
 
+/* 
+    Event-driven main loop (EVENT_DRIVEN=1). Instead of stepping currTime by timeIncrement,
+    each partition jumps straight from one event to the next, in exact time order.
+    Time is split into windows. A window ends before the next trigger/incast generation, which runs at the barrier
+    between two windows. With PARALLEL_ENGINE, the partitions run a window concurrently. A window is then never longer
+    than the lookahead, so an event sent to another partition always falls into a later window.
+    With OPTIMISTIC_ENGINE, windows are optimisticWindowNs long instead, and the partitions roll back
+    whenever an event from another partition arrives in their past (see SimPartition::processWindowOptimistic()).
+    The results are the same as with a single partition (with a fixed syndbConfig.randomSeed).
+*/
+void Simulation::runEventDriven(){
+
+    sim_time_t windowLength, windowEndTime;
+    SimEventType windowEndType;
+    sim_time_t nextProgressTime = (this->currTime / 100000) * 100000; // not 0: the run may be restored from a checkpoint
+
+    #if OPTIMISTIC_ENGINE
+    windowLength = syndbConfig.optimisticWindowNs;
+    if(windowLength == 0){
+        std::string msg = "optimisticWindowNs must be > 0";
+        throw std::logic_error(msg);
+    }
+    #endif
 
+    #if PARALLEL_ENGINE
+    #if !OPTIMISTIC_ENGINE
+    windowLength = this->getLookahead();
+    #endif
+    PartitionWorkers workers;
+    workers.start(this->partitions);
+    ndebug_print("Running {} partitions in windows of {}ns", this->partitions.size(), windowLength);
+    #else
+    windowLength = this->totalTime + 1;
+    #endif
 
-void Simulation::processTriggerPktEvents(){
-    
-    routeScheduleInfo rsinfo;
+    while(true){
 
-    // List of iterators that we would delete in the end
-    std::list<std::list<pktevent_p<triggerpkt_p>>::iterator> toDelete;
+        while(this->currTime >= nextProgressTime){
+            ndebug_print_yellow("########  Simulation Time: {}  ########", nextProgressTime);
+            nextProgressTime += 100000;
+        }
 
-    toDelete.clear(); // Making sure that the list is empty
+        // The window ends before the earliest of: lookahead, progress print, end of simulation, branching, hybrid mode action, trigger/incast generation
+        windowEndTime = std::min<sim_time_t>(this->currTime + windowLength, nextProgressTime);
+        windowEndTime = std::min<sim_time_t>(windowEndTime, this->totalTime + 1);
+        windowEndTime = std::min<sim_time_t>(windowEndTime, this->branchTime);
+        if(this->hybrid)
+            windowEndTime = std::min<sim_time_t>(windowEndTime, this->hybrid->nextActionTime);
+        windowEndType = SimEventType::HostPkt;
+
+        #if TRIGGERS_ENABLED
+        if(isBeforeWindowEnd(this->triggerGen->nextTriggerTime, SimEventType::TriggerGen, windowEndTime, windowEndType)){
+            windowEndTime = this->triggerGen->nextTriggerTime;
+            windowEndType = SimEventType::TriggerGen;
+        }
+        #endif
 
-    auto it = this->TriggerPktEventList.begin();
+        #if INCASTS_ENABLED
+        if(isBeforeWindowEnd(this->incastGen->nextIncastTime, SimEventType::IncastGen, windowEndTime, windowEndType)){
+            windowEndTime = this->incastGen->nextIncastTime;
+            windowEndType = SimEventType::IncastGen;
+        }
+        #endif
 
-    while (it != this->TriggerPktEventList.end())
-    {
-        pktevent_p<triggerpkt_p> event = *it;
+        #if PARALLEL_ENGINE
+        workers.runWindow(windowEndTime, windowEndType);
+        #else
+        this->partitions[0]->processWindow(windowEndTime, windowEndType);
+        #endif
+
+        // Window barrier: no partition is running
+        this->currTime = windowEndTime;
 
-        if(this->currTime >= event->pktForwardTime){
+        #if TRIGGERS_ENABLED
+        if(windowEndType == SimEventType::TriggerGen)
+            this->triggerGen->generateTrigger();
+        #endif
 
-            // Pass the pkt to the next switch to handle
-            event->nextSwitch->receiveTriggerPkt(event->pkt, event->pktForwardTime); // can parallelize switch's processing? 
+        #if INCASTS_ENABLED
+        if(windowEndType == SimEventType::IncastGen)
+            this->incastGen->generateIncast();
+        #endif
 
-            // Handling the case that the next hop is the pkt's dstSwitch
-            if(event->nextSwitch->id == event->pkt->dstSwitchId){
-                // The pkt requires no more network event processing
-                // Add the event's iterator to the toDelete list
-                toDelete.push_front(it); 
-            }
-            else // forward the event's packet
-            {
-                // Call routing on the next switch
-                syndb_status_t status = event->nextSwitch->routeScheduleTriggerPkt(event->pkt, event->pktForwardTime, rsinfo);
-
-                if(status != syndb_status_t::success){
-                    std::string msg = fmt::format("Simulator failed to route trigger pkt of trigger event {}", event->pkt->triggerId);
-                    throw std::logic_error(msg);
-                }
-
-                // event->doForwarding(rinfo);
-
-                event->currSwitch = event->nextSwitch;
-                event->nextSwitch = rsinfo.nextSwitch;
-                event->pktForwardTime = rsinfo.pktNextForwardTime;
-                
-            }                
+        #if PARALLEL_ENGINE
+        this->finishWindow();
+        #endif
+
+        if(this->hybrid && this->currTime >= this->hybrid->nextActionTime)
+            this->hybrid->runActions(this->currTime);
+
+        if(windowEndTime > this->totalTime)
+            break; // all events up to totalTime are done
+
+        if(this->checkpointAt(this->currTime))
+            break; // stopped by a signal
+
+        if(this->isBranchingDue(this->currTime)){
+            #if PARALLEL_ENGINE
+            workers.stop(); // only the forking thread survives fork()
+            this->forkBranches(this->currTime);
+            workers.start(this->partitions);
+            #else
+            this->forkBranches(this->currTime);
+            #endif
         }
 
-        it++;  // iterating over TriggerPktEventList
+    } // end of window loop
+
+    #if PARALLEL_ENGINE
+    workers.stop();
+    #endif
+
+    this->currTime = this->totalTime;
+}
+
+/* 
+    PARALLEL_ENGINE: the work of the window barrier that needs all partitions stopped.
+    Everything is done in an order that doesn't depend on the thread timings.
+*/
+void Simulation::finishWindow(){
+    this->assignNewPktIds();
+    #if OPTIMISTIC_ENGINE
+    this->resolveReceivedPktIds();
+    #endif
+    #if LOGGING
+    this->dumpDeliveredPkts();
+    #endif
+    this->collectTriggerRxRecords();
+    #if OPTIMISTIC_ENGINE
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        (*it)->fossilCollect();
     }
+    #endif
+    this->exchangePktEvents();
+}
 
-    // Now delete the enlisted TriggerPktEvents
+/* Gives the pkts generated in the window their ids. Sorting by orderKey gives the generation order of the sequential engine. */
+void Simulation::assignNewPktIds(){
 
-    // debug_print(fmt::format("Deleting {} TriggerPktEvents...", toDelete.size()));
-    auto it2 = toDelete.begin();
+    this->windowPkts.clear();
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        this->windowPkts.insert(this->windowPkts.end(), (*it)->newPkts.begin(), (*it)->newPkts.end());
+        (*it)->newPkts.clear();
+    }
 
-    while (it2 != toDelete.end()){
-        TriggerPktEventList.erase(*it2);
+    std::sort(this->windowPkts.begin(), this->windowPkts.end(), [](const normalpkt_p a, const normalpkt_p b){
+        return a->orderKey < b->orderKey;
+    });
 
-        it2++;
+    for(auto it = this->windowPkts.begin(); it != this->windowPkts.end(); it++){
+        (*it)->id = this->getNextPktId();
     }
+}
 
-    
+/* 
+    OPTIMISTIC_ENGINE: pkts are copied between partitions during the window, before their ids are known.
+    Copies of pkts generated in the window get the id of their original. MUST run right after assignNewPktIds().
+*/
+void Simulation::resolveReceivedPktIds(){
+
+    auto byOrderKey = [](const normalpkt_p a, uint64_t orderKey){ return a->orderKey < orderKey; };
+
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        for(auto pkt = (*it)->receivedPkts.begin(); pkt != (*it)->receivedPkts.end(); pkt++){
+            if((*pkt)->id != SimPartition::pendingPktId)
+                continue;
+
+            auto original = std::lower_bound(this->windowPkts.begin(), this->windowPkts.end(), (*pkt)->orderKey, byOrderKey);
+            if(original == this->windowPkts.end() || (*original)->orderKey != (*pkt)->orderKey){
+                std::string msg = fmt::format("No pkt generated in the window has the orderKey {} of a received pkt", (*pkt)->orderKey);
+                throw std::logic_error(msg);
+            }
+
+            (*pkt)->id = (*original)->id;
+        }
+        (*it)->receivedPkts.clear();
+    }
 }
 
+/* Dumps the pkts delivered in the window in the delivery order of the sequential engine, then recycles them */
+void Simulation::dumpDeliveredPkts(){
 
-void Simulation::processNormalPktEvents(){
+    this->windowPkts.clear();
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        this->windowPkts.insert(this->windowPkts.end(), (*it)->deliveredPkts.begin(), (*it)->deliveredPkts.end());
+    }
 
-    routeScheduleInfo rsinfo;
+    std::sort(this->windowPkts.begin(), this->windowPkts.end(), [](const normalpkt_p a, const normalpkt_p b){
+        return a->endTime < b->endTime || (a->endTime == b->endTime && a->orderKey < b->orderKey);
+    });
 
-    // List of iterators that we would delete in the end
-    std::list<std::list<pktevent_p<normalpkt_p>>::iterator> toDelete;
+    for(auto it = this->windowPkts.begin(); it != this->windowPkts.end(); it++){
+        if(this->isInTimeWindow((*it)->endTime))
+            this->pktDumper->dumpPacket(*it);
+    }
 
-    toDelete.clear(); // Making sure that the list is empty
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        (*it)->freeNormalPkts.insert((*it)->freeNormalPkts.end(), (*it)->deliveredPkts.begin(), (*it)->deliveredPkts.end());
+        (*it)->deliveredPkts.clear();
+    }
+}
 
-    auto it = this->NormalPktEventList.begin();
+void Simulation::collectTriggerRxRecords(){
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        for(auto rec = (*it)->triggerRxRecords.begin(); rec != (*it)->triggerRxRecords.end(); rec++){
+            this->TriggerInfoMap[rec->triggerId].rxSwitchTimes[rec->switchId] = rec->rxTime;
+        }
+        (*it)->triggerRxRecords.clear();
+    }
+}
 
-    while (it != this->NormalPktEventList.end())
-    {
-        PktEvent<normalpkt_p>* event = (*it).get();
-
-        if(this->currTime >= event->pktForwardTime){
-
-            
-            // Handling the case that the next hop is the dst Host
-            if(event->nextSwitch == NULL){
-                // Mark the event for deletion
-                toDelete.push_back(it);
-                
-                // Add end time INT data to the packet
-                event->pkt->endTime = event->pktForwardTime;
-
-                // Dump the pkt with INT data to the disk
-                #if LOGGING
-                syndbSim.pktDumper->dumpPacket(event->pkt);
-                #endif
-                this->totalPktsDelivered += 1;
-
-                #ifdef DEBUG
-                /* debug_print_yellow("\nPkt ID {} dump:", event->pkt->id);
-                debug_print("h{} --> h{}: {} ns (Start: {} ns | End: {} ns)", event->pkt->srcHost, event->pkt->dstHost, event->pkt->endTime - event->pkt->startTime, event->pkt->startTime, event->pkt->endTime);
-                auto it1 = event->pkt->switchINTInfoList.begin();
-                for(it1; it1 != event->pkt->switchINTInfoList.end(); it1++){
-                    debug_print("Rx on s{} at {} ns", it1->swId, it1->rxTime);
-                } */
-                #endif
-            }
-            // Handling the case that the next hop is a switch (intermediate or dstTor)
-            else{
-                
-                // Pass the pkt to the next switch to handle
-                event->nextSwitch->receiveNormalPkt(event->pkt, event->pktForwardTime); // thread-safe
-
-                // Call routing on the next switch
-                syndb_status_t status = event->nextSwitch->routeScheduleNormalPkt(event->pkt, event->pktForwardTime, rsinfo);
-                
-                
-                /* Update the event */
-                event->currSwitch = event->nextSwitch;
-                event->nextSwitch = rsinfo.nextSwitch; // will be NULL if next hop is a host
-                event->pktForwardTime = rsinfo.pktNextForwardTime;               
+/* Hands over the events that partitions sent to each other during the window (and at the barrier) */
+void Simulation::exchangePktEvents(){
 
+    #if OPTIMISTIC_ENGINE
+    // Only the msgs sent at the barrier are left. They can't cause a rollback: all partitions are at the window end.
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        for(partition_id_t dst = 0; dst < (*it)->outbox.size(); dst++){
+            std::vector<timeWarpMsg> &msgs = (*it)->outbox[dst];
+            for(auto msg = msgs.begin(); msg != msgs.end(); msg++){
+                this->partitions[dst]->receiveMsg(*msg);
             }
+            msgs.clear();
+        }
+    }
+    #endif
 
-        } // end of the if(this->currTime >= event->pktForwardTime)
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        SimPartition &from = **it;
 
-        it++;  // iterating over NormalPktEventList
-    } 
+        for(auto ev = from.outgoingNormalPktEvents.begin(); ev != from.outgoingNormalPktEvents.end(); ev++){
+            getEventPartition(**ev)->addNormalPktEvent(*ev);
+        }
+        from.outgoingNormalPktEvents.clear();
 
-    // Now delete the enlisted NormalPktEvents
+        for(auto ev = from.outgoingTriggerPktEvents.begin(); ev != from.outgoingTriggerPktEvents.end(); ev++){
+            getEventPartition(*ev)->adoptTriggerPktEvent(*ev, from);
+        }
+        from.outgoingTriggerPktEvents.clear();
+    }
+}
 
-    // debug_print(fmt::format("Deleting {} NormalPktEvents...", toDelete.size()));
-    auto it2 = toDelete.begin();
+pkt_id_t Simulation::getTotalPktsDelivered(){
+    pkt_id_t totalPktsDelivered = 0;
 
-    while (it2 != toDelete.end()){
-        this->freeNormalPkts.push_back((**it2)->pkt); // this makes pkt inside the event as NULL
-        //TODO: other members of the PktEvent?
-        this->freeNormalPktEvents.push_back(std::move(**it2));
-        NormalPktEventList.erase(*it2);
-        it2++;
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        totalPktsDelivered += (*it)->totalPktsDelivered;
     }
 
-
+    return totalPktsDelivered;
 }
 
 
+/* Collects the in-flight normal pkt events of all partitions, in pkt order (independent of the partitioning) */
+void Simulation::getRemainingNormalPktEvents(std::vector<pktevent_p<normalpkt_p>> &events){
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        (*it)->getRemainingNormalPktEvents(events);
+    }
+
+    std::sort(events.begin(), events.end(), [](const pktevent_p<normalpkt_p> &a, const pktevent_p<normalpkt_p> &b){
+        return a->pkt->orderKey < b->pkt->orderKey;
+    });
+}
+
 void Simulation::flushRemainingNormalPkts(){
 
-    auto it = this->NormalPktEventList.begin();
+    // Time-parallel mode: the next window delivers them
+    if(this->timeWindowId > 0 && this->timeWindowId < syndbConfig.numTimeWindows)
+        return;
 
-    for(it; it != this->NormalPktEventList.end(); it++){
+    std::vector<pktevent_p<normalpkt_p>> remainingEvents;
+    this->getRemainingNormalPktEvents(remainingEvents);
+
+    auto it = remainingEvents.begin();
+
+    for(it; it != remainingEvents.end(); it++){
         pktevent_p<normalpkt_p> event = *it;
 
         // Dump the pkt with INT data to the disk
         #if LOGGING
-        syndbSim.pktDumper->dumpPacket(event->pkt);
+        syndbSim->pktDumper->dumpPacket(event->pkt);
         #endif
 
 
@@ -339,17 +713,20 @@ void Simulation::logTriggerInfoMap(){
     trigger_id_t triggerId;
     switch_id_t originSwitch, rxSwitch;
 
-    auto it1 = syndbSim.TriggerInfoMap.begin();
+    auto it1 = syndbSim->TriggerInfoMap.begin();
 
     debug_print_yellow("\nTrigger pkt latencies between switches");
-    for(it1; it1 != syndbSim.TriggerInfoMap.end(); it1++){
+    for(it1; it1 != syndbSim->TriggerInfoMap.end(); it1++){
         
+        if(!this->isInTimeWindow(it1->second.triggerOrigTime))
+            continue; // time-parallel mode: dumped by a neighbor window
+
         triggerId = it1->first;
         originSwitch = it1->second.originSwitch;
-        SwitchType switchType = syndbSim.topo->getSwitchTypeById(originSwitch);
+        SwitchType switchType = syndbSim->topo->getSwitchTypeById(originSwitch);
 
         #if LOGGING
-        syndbSim.pktDumper->dumpTriggerInfo(triggerId, it1->second, switchType);
+        syndbSim->pktDumper->dumpTriggerInfo(triggerId, it1->second, switchType);
         #else
         /* Below code is only for debugging. TODO: comment out later. */
 
@@ -398,15 +775,15 @@ void Simulation::showLinkUtilizations(){
     std::ofstream networkLinkUtilsFile(networkLinkUtilsFileName);
 
     debug_print_yellow("Utilization on ToR links:");
-    for(auto it = syndbSim.topo->torLinkVector.begin(); it != syndbSim.topo->torLinkVector.end(); it++){
+    for(auto it = syndbSim->topo->torLinks.begin(); it != syndbSim->topo->torLinks.end(); it++){
         
-        util_to_tor = (double)((*it)->byte_count_to_tor * 8) / syndbSim.totalTime;
-        util_to_host = (double)((*it)->byte_count_to_host * 8) / syndbSim.totalTime;
+        util_to_tor = (double)(it->byte_count_to_tor * 8) / syndbSim->totalTime;
+        util_to_host = (double)(it->byte_count_to_host * 8) / syndbSim->totalTime;
 
         percent_util_to_tor = (util_to_tor / syndbConfig.torLinkSpeedGbps) * 100.0;
         percent_util_to_host = (util_to_host / syndbConfig.torLinkSpeedGbps) * 100.0;
 
-        debug_print("Link ID {}: towards host: {} | towards tor: {}", (*it)->id, percent_util_to_host, percent_util_to_tor);
+        debug_print("Link ID {}: towards host: {} | towards tor: {}", it->id, percent_util_to_host, percent_util_to_tor);
 
         torLinksPercentUtilSum += percent_util_to_tor;
         torLinksPercentUtilSum += percent_util_to_host;
@@ -418,24 +795,20 @@ void Simulation::showLinkUtilizations(){
     }
 
     debug_print_yellow("Utilization on Network links:");
-    for(auto it = syndbSim.topo->networkLinkVector.begin(); it != syndbSim.topo->networkLinkVector.end(); it++){
+    for(auto it = syndbSim->topo->networkLinks.begin(); it != syndbSim->topo->networkLinks.end(); it++){
         
-        auto map = (*it)->byte_count;
-        auto it_byte_count = map.begin();
+        switch_id_t sw1 = it->queues[0].dstSwitchId;
+        byte_count_t byteCount1 = it->queues[0].byteCount;
+        switch_id_t sw2 = it->queues[1].dstSwitchId;
+        byte_count_t byteCount2 = it->queues[1].byteCount;
 
-        switch_id_t sw1 = it_byte_count->first;
-        byte_count_t byteCount1 = it_byte_count->second;
-        it_byte_count++;
-        switch_id_t sw2 = it_byte_count->first;
-        byte_count_t byteCount2 = it_byte_count->second;
-
-        util1 = (double)(byteCount1 * 8) / syndbSim.totalTime;
-        util2 = (double)(byteCount2 * 8) / syndbSim.totalTime;
+        util1 = (double)(byteCount1 * 8) / syndbSim->totalTime;
+        util2 = (double)(byteCount2 * 8) / syndbSim->totalTime;
 
         percent_util1 = (util1 / syndbConfig.networkLinkSpeedGbps) * 100.0;
         percent_util2 = (util2 / syndbConfig.networkLinkSpeedGbps) * 100.0;
 
-        debug_print("Link ID {}: towards sw{}: {} | towards sw{}: {}", (*it)->id, sw1, percent_util1, sw2, percent_util2);
+        debug_print("Link ID {}: towards sw{}: {} | towards sw{}: {}", it->id, sw1, percent_util1, sw2, percent_util2);
 
         networkLinksPercentUtilSum += percent_util1;
         networkLinksPercentUtilSum += percent_util2;
@@ -457,9 +830,42 @@ void Simulation::showLinkUtilizations(){
 }
 
 void Simulation::printSimulationStats(){
-    syndbSim.showLinkUtilizations();
+    syndbSim->showLinkUtilizations();
     ndebug_print_yellow("#####  Total Pkts Summary  #####");
-    ndebug_print("Generated: {} | Delivered: {}", this->nextPktId, this->totalPktsDelivered);
+    ndebug_print("Generated: {} | Delivered: {}", this->nextPktId, this->getTotalPktsDelivered());
+
+    #if INTRA_STEP_PARALLEL
+    ndebug_print("Steals between the threads of a tick: {}", this->stepPool->numSteals.load());
+    #endif
+
+    #if PIPELINED_TRAFFIC_GEN
+    ndebug_print("Waits for the traffic gen threads: {}", this->trafficPipeline->numEmptyPops.load());
+    #endif
+
+    #if TRIGGERS_ENABLED && ANALYTICAL_TRIGGER_FLOOD
+    ndebug_print("Trigger flood copies: {} computed | {} pruned on receipt", this->triggerGen->flood.numCopies, this->triggerGen->flood.numPruned);
+    #endif
+
+    #if PACKET_TRAINS
+    uint64_t numTrainJoins = 0, numTrainSplits = 0;
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        numTrainJoins += (*it)->numTrainJoins;
+        numTrainSplits += (*it)->numTrainSplits;
+    }
+    ndebug_print("Packet trains: {} pkt hops queued behind a train | {} splits", numTrainJoins, numTrainSplits);
+    #endif
+
+    if(this->hybrid && !this->hybrid->reference)
+        ndebug_print("Hybrid mode: {} fluid phases, {}ns at fluid level | Fluid bytes carried by the links: {:.0f}", this->hybrid->numFluidPhases, this->hybrid->totalFluidTime, this->hybrid->fluidBytes);
+
+    #if OPTIMISTIC_ENGINE
+    uint64_t numRollbacks = 0, numRolledBackEvents = 0;
+    for(auto it = this->partitions.begin(); it != this->partitions.end(); it++){
+        numRollbacks += (*it)->numRollbacks;
+        numRolledBackEvents += (*it)->numRolledBackEvents;
+    }
+    ndebug_print("Rollbacks: {} | Rolled back events: {}", numRollbacks, numRolledBackEvents);
+    #endif
 }
 
 
@@ -496,12 +902,93 @@ void Simulation::printSimulationSetup(){
         ndebug_print("Incasts are disabled!");
     #endif
 
-    ndebug_print("Time increment is {}ns", syndbSim.timeIncrement);
-    ndebug_print("Running simulation for {}ns ...\n",syndbSim.totalTime);
+    #if EVENT_DRIVEN
+        ndebug_print("Event-driven engine is enabled!");
+    #else
+        ndebug_print("Event-driven engine is disabled!");
+    #endif
+
+    #if PARALLEL_ENGINE
+        ndebug_print("Parallel engine is enabled!");
+    #else
+        ndebug_print("Parallel engine is disabled!");
+    #endif
+
+    #if OPTIMISTIC_ENGINE
+        ndebug_print("Optimistic engine is enabled! Windows of {}ns", syndbConfig.optimisticWindowNs);
+    #else
+        ndebug_print("Optimistic engine is disabled!");
+    #endif
+
+    #if INTRA_STEP_PARALLEL
+        ndebug_print("Intra-step parallelism is enabled!");
+    #else
+        ndebug_print("Intra-step parallelism is disabled!");
+    #endif
+
+    #if PIPELINED_TRAFFIC_GEN
+        ndebug_print("Pipelined traffic generation is enabled!");
+    #else
+        ndebug_print("Pipelined traffic generation is disabled!");
+    #endif
+
+    #if ANALYTICAL_TRIGGER_FLOOD
+        ndebug_print("Analytical trigger flood is enabled!");
+    #else
+        ndebug_print("Analytical trigger flood is disabled!");
+    #endif
+
+    #if PACKET_TRAINS
+        ndebug_print("Packet trains are enabled!");
+    #else
+        ndebug_print("Packet trains are disabled!");
+    #endif
+
+    #if SPECIALIZED_FATTREE
+        ndebug_print("Specialized FatTree build is enabled!");
+    #else
+        ndebug_print("Specialized FatTree build is disabled!");
+    #endif
+
+    #if SOURCE_ROUTING
+        ndebug_print("Source routing is enabled!");
+    #else
+        ndebug_print("Source routing is disabled!");
+    #endif
+
+    if(syndbConfig.checkpointIntervalMSecs > 0)
+        ndebug_print("Checkpoints every {}ms to {}", syndbConfig.checkpointIntervalMSecs, syndbConfig.checkpointFile);
+    if(!syndbConfig.restoreCheckpointFile.empty())
+        ndebug_print("Resuming from checkpoint {}", syndbConfig.restoreCheckpointFile);
+    if(syndbConfig.numWhatIfBranches > 0)
+        ndebug_print("Forking {} what-if branches at {}ns", syndbConfig.numWhatIfBranches, syndbConfig.triggerInitialDelay);
+
+    if(this->replicaId > 0)
+        ndebug_print("Ensemble replica {} of {}", this->replicaId, syndbConfig.numEnsembleReplicas);
+    if(this->hybridReference)
+        ndebug_print("Full pkt-level reference run of the hybrid mode");
+    else if(syndbConfig.hybridWarmInNs > 0)
+        ndebug_print("Hybrid fluid/pkt mode: pkt level from {}ns before to {}ns after each trigger", syndbConfig.hybridWarmInNs, syndbConfig.hybridCoolDownNs);
+
+    if(this->timeWindowId > 0)
+        ndebug_print("Time window {} of {}: from {}ns to {}ns, after a fluid pre-pass and a pkt-level warm-up of {}ns", this->timeWindowId, syndbConfig.numTimeWindows, this->timeWindowStart, this->totalTime, syndbConfig.timeWindowWarmUpNs);
+
+    if(this->randomSeed == 0)
+        ndebug_print("Random seeds are taken from the clock");
+    else
+        ndebug_print("Random seed is {}", this->randomSeed);
+
+    ndebug_print("Time increment is {}ns", syndbSim->timeIncrement);
+    ndebug_print("Running simulation for {}ns ...\n",syndbSim->totalTime);
 }
 
 void Simulation::cleanUp(){
 
+    #if PIPELINED_TRAFFIC_GEN
+    if(this->trafficPipeline)
+        this->trafficPipeline->stop();
+    #endif
+
     ndebug_print_yellow("Flushing remaining normal pkts");
     this->flushRemainingNormalPkts();
     ndebug_print_yellow("Flushing trigger pkts info");
@@ -509,22 +996,31 @@ void Simulation::cleanUp(){
 
     /* Free NormalPkts from everywhere */
     // 1. From the Hosts. Implemented in the destructor ~Host(). Should be freed there.
-    // 2. From the HostPktEventList. Do NOT free in the destructor of HostPktEvent. It is destroyed in runtime.
-    for(auto it=this->HostPktEventList.begin(); it != this->HostPktEventList.end(); it++){
-        if(it->second.pkt != NULL)
-            delete it->second.pkt;
-    }
-    // 3. From the NormalPktEvents only. NOT the freeNormalPktEvents!
-    for(auto it=this->NormalPktEventList.begin(); it != this->NormalPktEventList.end(); it++){
+    // 2. (Formerly the HostPktEventList) Hosts hold their only not-yet-sent pkt themselves. See 1.
+    // 3. From the in-flight NormalPktEvents only. NOT the freeNormalPktEvents!
+    std::vector<pktevent_p<normalpkt_p>> remainingEvents;
+    this->getRemainingNormalPktEvents(remainingEvents);
+    for(auto it=remainingEvents.begin(); it != remainingEvents.end(); it++){
         if((*it)->pkt != NULL)
             delete (*it)->pkt;
     }
-    // 4. From the freeNormalPkts list. These are pkts from the freeNormalPktEvents
+    // 4. From the freeNormalPkts lists. These are pkts from the freeNormalPktEvents
     ndebug_print_yellow("Cleaning up freeNormalPkts ...");
-    for(auto it=this->freeNormalPkts.begin(); it != this->freeNormalPkts.end(); it++){
-        if(*it != NULL)
-            delete *it;
+    for(auto partitionIt = this->partitions.begin(); partitionIt != this->partitions.end(); partitionIt++){
+        SimPartition &partition = **partitionIt;
+
+        partition.NormalPktEventWheel.clear();
+        partition.eventQueue.heap.clear();
+
+        for(auto it=partition.freeNormalPkts.begin(); it != partition.freeNormalPkts.end(); it++){
+            if(*it != NULL)
+                delete *it;
+        }
+        partition.freeNormalPkts.clear();
     }
+
+    if(this->hybrid)
+        this->hybrid->finish(std::min(this->currTime, this->totalTime)); // the byte counts of a last fluid phase
     
     this->printSimulationStats();
 
@@ -3,11 +3,17 @@
 
 #include <list>
 #include <map>
+#include <csignal>
+#include <sys/types.h>
 #include "topology/topology.hpp"
 #include "simulation/event.hpp"
+#include "simulation/partition.hpp"
+#include "simulation/steppool.hpp"
+#include "traffic/trafficPipeline.hpp"
 #include "utils/pktdumper.hpp"
 #include "traffic/triggerGenerator.hpp"
 #include "traffic/incastGenerator.hpp"
+#include "simulation/hybrid.hpp"
 
 typedef struct Simulation
 {
@@ -21,13 +27,17 @@ typedef struct Simulation
     // packets-related
     pkt_id_t nextPktId;
     pkt_id_t nextTriggerPktId;
-    pkt_id_t totalPktsDelivered;
-    
-    std::multimap<sim_time_t, HostPktEvent> HostPktEventList;
-    std::list<pktevent_p<normalpkt_p>> NormalPktEventList;
-    std::list<pktevent_p<normalpkt_p>> freeNormalPktEvents; // to reuse shared_ptrs
-    std::list<pktevent_p<triggerpkt_p>> TriggerPktEventList;
-    std::list<normalpkt_p> freeNormalPkts;
+
+    // Engine state of the hosts and switches. A single partition unless PARALLEL_ENGINE.
+    std::vector<std::unique_ptr<SimPartition>> partitions;
+    std::vector<normalpkt_p> windowPkts; // scratch space for finishWindow()
+
+    // INTRA_STEP_PARALLEL: threads for the due normal pkt events of a tick
+    std::unique_ptr<StepThreadPool> stepPool;
+    static const size_t minParallelStepEvents = 32; // fewer due events are processed by the main thread alone
+
+    // PIPELINED_TRAFFIC_GEN: threads generating the hosts' pkts ahead of simulated time
+    std::unique_ptr<TrafficGenPipeline> trafficPipeline;
 
     // For tracking and logging triggerInfo
     std::map<trigger_id_t, triggerInfo> TriggerInfoMap;
@@ -40,32 +50,84 @@ typedef struct Simulation
 
     time_t startTime, endTime;
 
-    Simulation(); // default constructor
+    sim_time_t nextCheckpointTime; // max if no automatic checkpoint is due
+
+    // What-if branches fork()ed from the warm state at triggerInitialDelay
+    unsigned int branchId; // 0: the main run. Forked branches: 1..numWhatIfBranches
+    sim_time_t branchTime; // max if no branching is due
+    std::vector<pid_t> branchPids; // main run: the forked branches
+
+    // Ensemble mode: replicas run on threads of their own. All they share is read-only (syndbConfig, the CDF tables).
+    unsigned int replicaId; // 1..numEnsembleReplicas. 0: single run
+    uint64_t randomSeed; // of this run. See getRandomSeed()
+
+    // Hybrid fluid/pkt mode (hybrid.cpp). NULL if off.
+    std::unique_ptr<HybridModel> hybrid;
+    bool hybridReference; // the full pkt-level run that hybridCompareFull compares against
+
+    // Time-parallel mode (timeparallel.cpp): this run is one window of time of the whole run, which ends at totalTime
+    unsigned int timeWindowId; // 1..numTimeWindows. 0: not split
+    sim_time_t timeWindowStart, timeWindowEnd; // this window dumps the pkts delivered and the triggers/incasts in [start, end)
+
+    Simulation(unsigned int replicaId = 0);
     
-    // needs to be thread-safe when parallelizing
+    // never called concurrently: with PARALLEL_ENGINE, ids are assigned at the window barrier
     inline pkt_id_t getNextPktId() { return this->nextPktId++; }; 
     inline pkt_id_t getNextTriggerPktId() { return this->nextTriggerPktId++; };
     inline void buildTopo(){ this->topo->buildTopo(); };
-    pktevent_p<normalpkt_p> getNewNormalPktEvent();
-    normalpkt_p getNewNormalPkt(pkt_id_t pktId, pkt_size_t pktSize);
+    void initPartitions();
     void initTriggerGen();
     void initIncastGen();
     void initHosts();
-    void generateHostPktEvents();
+    void initHybrid();
+    void setTimeWindow(unsigned int windowId);
+    inline bool isInTimeWindow(sim_time_t time) { return time >= this->timeWindowStart && time < this->timeWindowEnd; };
+    void initTrafficPipeline(std::vector<Host*> &hosts);
+    void rescheduleHost(Host* host);
     void processHostPktEvents();
     void processTriggerPktEvents();
+    void initStepPool();
     void processNormalPktEvents();
+    void forwardNormalPktEventsParallel(SimPartition &partition);
+    sim_time_t getLookahead();
+    void runEventDriven();
+    void finishWindow();
+    void assignNewPktIds();
+    void resolveReceivedPktIds();
+    void dumpDeliveredPkts();
+    void collectTriggerRxRecords();
+    void exchangePktEvents();
+    pkt_id_t getTotalPktsDelivered();
+    void getRemainingNormalPktEvents(std::vector<pktevent_p<normalpkt_p>> &events);
     void flushRemainingNormalPkts();
     void logTriggerInfoMap();
     void showLinkUtilizations();
 
+    /* Checkpoints (checkpoint.cpp) */
+    void saveCheckpoint(const std::string &path, sim_time_t resumeTime);
+    void restoreCheckpoint(const std::string &path);
+    void scheduleNextCheckpoint(sim_time_t time);
+    bool checkpointAt(sim_time_t resumeTime);
+    std::string getCheckpointFile();
+
+    /* What-if branches (branching.cpp) */
+    void scheduleBranching();
+    inline bool isBranchingDue(sim_time_t resumeTime) { return resumeTime >= this->branchTime; };
+    void forkBranches(sim_time_t resumeTime);
+    bool waitForBranches();
+
     void printSimulationSetup();
     void printSimulationStats();
     void cleanUp();
 
 } Simulation;
 
-extern Simulation syndbSim;
+/*
+    The simulation the calling thread works on. Set by the thread running a simulation,
+    and passed on to the threads that it starts (partition workers, step pool, traffic gen threads).
+*/
+extern thread_local Simulation* syndbSim;
+extern volatile std::sig_atomic_t syndbStopSignal; // set by SIGINT/SIGTERM. The main loops stop at the next checkpointAt().
 
 
 #endif
\ No newline at end of file
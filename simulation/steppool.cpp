@@ -0,0 +1,133 @@
+#include "simulation/steppool.hpp"
+#include "simulation/simulation.hpp"
+
+void StepThreadPool::start(size_t numWorkers){
+    if(numWorkers == 0)
+        numWorkers = 1;
+
+    for(size_t workerId = 0; workerId < numWorkers; workerId++){
+        this->queues.emplace_back();
+    }
+
+    // Worker 0 is the thread calling run()
+    for(size_t workerId = 1; workerId < numWorkers; workerId++){
+        this->threads.push_back(std::thread(&StepThreadPool::workerLoop, this, workerId, syndbSim));
+    }
+}
+
+void StepThreadPool::run(size_t numTasks, const std::function<void(size_t)> &task){
+
+    for(size_t taskId = 0; taskId < numTasks; taskId++){
+        workerQueue &queue = this->queues[taskId % this->queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+        queue.tasks.push_back(taskId);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        this->task = &task;
+        this->numBusy = this->threads.size();
+        this->runNum++;
+    }
+    this->runStartCv.notify_all();
+
+    this->work(0);
+
+    std::unique_lock<std::mutex> lock(this->mtx);
+    this->runDoneCv.wait(lock, [this]{ return this->numBusy == 0; });
+    this->task = NULL;
+
+    if(this->error){
+        std::exception_ptr error = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void StepThreadPool::workerLoop(size_t workerId, Simulation* sim){
+    syndbSim = sim;
+    uint64_t lastRunNum = 0;
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->runStartCv.wait(lock, [&]{ return this->stopping || this->runNum != lastRunNum; });
+            if(this->stopping)
+                return;
+            lastRunNum = this->runNum;
+        }
+
+        this->work(workerId);
+
+        {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->numBusy--;
+            if(this->numBusy == 0)
+                this->runDoneCv.notify_one();
+        }
+    }
+}
+
+/* Runs tasks until no deque has any left. No task adds new tasks, so an empty round means the run is done. */
+void StepThreadPool::work(size_t workerId){
+    size_t taskId;
+
+    while(this->getTask(workerId, taskId)){
+        try{
+            (*this->task)(taskId);
+        }
+        catch(...){
+            std::lock_guard<std::mutex> lock(this->mtx);
+            if(!this->error)
+                this->error = std::current_exception();
+        }
+    }
+}
+
+bool StepThreadPool::getTask(size_t workerId, size_t &taskId){
+    {
+        workerQueue &own = this->queues[workerId];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if(!own.tasks.empty()){
+            taskId = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the back of the next non-empty deque
+    for(size_t i = 1; i < this->queues.size(); i++){
+        workerQueue &victim = this->queues[(workerId + i) % this->queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if(!victim.tasks.empty()){
+            taskId = victim.tasks.back();
+            victim.tasks.pop_back();
+            this->numSteals++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void StepThreadPool::stop(){
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        this->stopping = true;
+    }
+    this->runStartCv.notify_all();
+
+    for(auto it = this->threads.begin(); it != this->threads.end(); it++){
+        it->join();
+    }
+    this->threads.clear();
+
+    // Ready for another start()
+    this->queues.clear();
+    this->stopping = false;
+    this->runNum = 0;
+}
+
+StepThreadPool::~StepThreadPool(){
+    this->stop();
+}
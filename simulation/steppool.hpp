@@ -0,0 +1,53 @@
+#ifndef STEPPOOL_H
+#define STEPPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+struct Simulation;
+
+/*
+    INTRA_STEP_PARALLEL: work-stealing thread pool for the independent tasks of one tick of the tick-based loop.
+    run() deals the tasks round-robin to one deque per worker. A worker takes tasks from the front of its own deque
+    and, once it is empty, steals from the back of the others. The thread calling run() is worker 0.
+    run() returns once all tasks are done. An exception in a task is re-thrown by run().
+*/
+struct StepThreadPool
+{
+    struct workerQueue
+    {
+        std::mutex mtx;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::thread> threads;
+    std::deque<workerQueue> queues; // one per worker (mutex is not movable)
+    std::mutex mtx;
+    std::condition_variable runStartCv, runDoneCv;
+    uint64_t runNum = 0;
+    size_t numBusy = 0;
+    bool stopping = false;
+    const std::function<void(size_t)>* task = NULL;
+    std::exception_ptr error;
+    std::atomic<uint64_t> numSteals{0}; // stats
+
+    void start(size_t numWorkers);
+    void run(size_t numTasks, const std::function<void(size_t)> &task);
+    void stop(); // can be start()ed again after
+    inline size_t getNumWorkers() const { return this->queues.size(); };
+    ~StepThreadPool();
+
+    private:
+    void workerLoop(size_t workerId, Simulation* sim);
+    void work(size_t workerId);
+    bool getTask(size_t workerId, size_t &taskId);
+};
+
+
+#endif
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <ctime>
+#include <map>
+#include <thread>
+#include <fstream>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+#include "simulation/sweep.hpp"
+#include "simulation/simulation.hpp"
+#include "traffic/trafficGenerator.hpp"
+
+std::vector<config_params_t> expandGrid(const std::vector<configParam> &params){
+    std::vector<config_params_t> points(1);
+
+    for(auto param = params.begin(); param != params.end(); param++){
+        std::vector<config_params_t> expanded;
+
+        for(auto point = points.begin(); point != points.end(); point++){
+            for(auto value = param->values.begin(); value != param->values.end(); value++){
+                expanded.push_back(*point);
+                expanded.back().push_back(std::make_pair(param->key, *value));
+            }
+        }
+
+        points.swap(expanded);
+    }
+
+    return points;
+}
+
+static std::string pointToString(const config_params_t &point){
+    std::string str;
+    for(auto it = point.begin(); it != point.end(); it++){
+        str += fmt::format("{}{}={}", str.empty() ? "" : " ", it->first, it->second);
+    }
+    return str;
+}
+
+/*
+    The startup work that the points share is done once, here, and inherited by the children copy-on-write:
+    the CDF tables of the traffic distributions are read before the first fork().
+    The topology holds the per-run queue state, so every point builds its own.
+    The points are started in the order of their estimated cost (hosts * simulated time), largest first.
+*/
+bool runSweep(const std::vector<config_params_t> &points, bool (*runPoint)()){
+
+    std::vector<Config> configs(points.size(), syndbConfig);
+    bool needCDFs = false;
+    for(size_t i = 0; i < points.size(); i++){
+        configs[i].apply(points[i]);
+        needCDFs = needCDFs || configs[i].trafficGenType == TrafficGenType::Distribution;
+    }
+
+    if(needCDFs){
+        RandomFromCDF::getSharedCDF(DcTrafficGenerator::packetSizeDistFile);
+        RandomFromCDF::getSharedCDF(DcTrafficGenerator::packetArrivalDistFile);
+    }
+
+    std::vector<size_t> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&configs](size_t a, size_t b){
+        return (double)configs[a].numHosts * configs[a].totalTimeMSecs > (double)configs[b].numHosts * configs[b].totalTimeMSecs;
+    });
+
+    // Every point gets its own dump prefix (and checkpoint file) below a common one. The sweep settings are the first point's.
+    std::string sweepPrefix = configs[0].dumpPrefix;
+    if(sweepPrefix.empty()){
+        std::time_t currentTime = std::time(nullptr);
+        sweepPrefix = fmt::format("dump_{:%Y-%m-%d}_{:%H.%M.%S}_", fmt::localtime(currentTime), fmt::localtime(currentTime));
+    }
+
+    std::ofstream index("./data/" + sweepPrefix + "sweep.txt");
+    for(size_t i = 0; i < points.size(); i++){
+        configs[i].dumpPrefix = fmt::format("{}point{}_", sweepPrefix, i);
+        if(!configs[i].checkpointFile.empty())
+            configs[i].checkpointFile += fmt::format(".point{}", i);
+
+        index << fmt::format("point{} {}\n", i, pointToString(points[i]));
+    }
+    index.close();
+
+    unsigned int maxProcesses = configs[0].numSweepProcesses;
+    if(maxProcesses == 0)
+        maxProcesses = std::max(1u, std::thread::hardware_concurrency());
+
+    fmt::print("Parameter sweep: {} points, up to {} at a time. Index: ./data/{}sweep.txt\n", points.size(), maxProcesses, sweepPrefix);
+
+    std::map<pid_t, size_t> running;
+    size_t next = 0, numFailed = 0;
+
+    while(true){
+        // No new points once stopped by a signal. The running ones stop by themselves.
+        while(running.size() < maxProcesses && next < order.size() && syndbStopSignal == 0){
+            size_t i = order[next++];
+
+            fmt::print("Sweep point {}: {}\n", i, pointToString(points[i]));
+            fflush(stdout);
+            pid_t pid = fork();
+
+            if(pid < 0){
+                std::string msg = fmt::format("fork() of sweep point {} failed", i);
+                throw std::logic_error(msg);
+            }
+
+            if(pid == 0){
+                syndbConfig = configs[i];
+
+                bool ok = false;
+                try{
+                    ok = runPoint();
+                }
+                catch(const std::exception &e){
+                    fmt::print(stderr, "Sweep point {} failed: {}\n", i, e.what());
+                }
+
+                exit(syndbStopSignal != 0 ? syndbStopSignal : (ok ? 0 : 1));
+            }
+
+            running[pid] = i;
+        }
+
+        if(running.empty())
+            break;
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if(pid < 0){
+            if(errno == EINTR)
+                continue;
+            std::string msg = "Lost track of the running sweep points";
+            throw std::logic_error(msg);
+        }
+
+        auto it = running.find(pid);
+        if(it == running.end())
+            continue;
+
+        if(WIFEXITED(status) && WEXITSTATUS(status) == 0){
+            fmt::print("Sweep point {} finished\n", it->second);
+        }
+        else{
+            int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+            fmt::print("Sweep point {} failed with exit code {}\n", it->second, exitCode);
+            numFailed++;
+        }
+        running.erase(it);
+    }
+
+    fmt::print("Parameter sweep: {} of {} points finished, {} failed\n", next - numFailed, points.size(), numFailed);
+
+    return numFailed == 0 && next == order.size();
+}
@@ -0,0 +1,17 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <vector>
+#include "simulation/config.hpp"
+
+/* The points of the grid spanned by the params: every combination of their values. A single point if no param has several values. */
+std::vector<config_params_t> expandGrid(const std::vector<configParam> &params);
+
+/*
+    Runs every point with runPoint() in a fork()ed child process, up to numSweepProcesses at a time.
+    Returns false if any point failed.
+*/
+bool runSweep(const std::vector<config_params_t> &points, bool (*runPoint)());
+
+
+#endif
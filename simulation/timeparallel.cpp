@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/core.h>
+#include "simulation/timeparallel.hpp"
+#include "simulation/config.hpp"
+#include "utils/logger.hpp"
+
+
+static std::string getWindowFileName(const std::string &prefix, unsigned int windowId, const std::string &name){
+    return fmt::format("./data/{}window{}_{}", prefix, windowId, name);
+}
+
+static std::ifstream openWindowFile(const std::string &fileName){
+    std::ifstream file(fileName);
+    if(!file.is_open()){
+        std::string msg = fmt::format("Cannot open dump file {} of a time window", fileName);
+        throw std::logic_error(msg);
+    }
+    return file;
+}
+
+/* The stitched pkt ids of a window: its sorted local ids, numbered from offset on */
+struct windowPktIds
+{
+    std::vector<pkt_id_t> localIds;
+    pkt_id_t offset;
+
+    pkt_id_t getStitchedId(pkt_id_t localId, const std::string &fileName) const {
+        auto it = std::lower_bound(this->localIds.begin(), this->localIds.end(), localId);
+        if(it == this->localIds.end() || *it != localId){
+            std::string msg = fmt::format("Pkt {} of {} was not delivered in its time window", localId, fileName);
+            throw std::logic_error(msg);
+        }
+        return this->offset + (it - this->localIds.begin());
+    }
+};
+
+void stitchTimeWindows(const std::string &prefix, unsigned int numWindows, switch_id_t numSwitches){
+
+    std::vector<windowPktIds> windows(numWindows);
+    pkt_id_t numPkts = 0;
+
+    for(unsigned int i = 0; i < numWindows; i++){
+        std::ifstream file = openWindowFile(getWindowFileName(prefix, i + 1, "sourceDestination.txt"));
+        pkt_id_t id;
+        host_id_t srcHost, dstHost;
+        while(file >> id >> srcHost >> dstHost)
+            windows[i].localIds.push_back(id);
+
+        std::sort(windows[i].localIds.begin(), windows[i].localIds.end());
+        windows[i].offset = numPkts;
+        numPkts += windows[i].localIds.size();
+    }
+
+    std::vector<std::string> copiedFiles = {"summary.txt", "trigger.txt", "incast.txt"};
+    std::vector<std::string> fileNames = copiedFiles;
+    fileNames.push_back("sourceDestination.txt");
+    for(switch_id_t switchId = 0; switchId < numSwitches; switchId++)
+        fileNames.push_back(fmt::format("switch_{}.txt", switchId));
+
+    for(auto name = fileNames.begin(); name != fileNames.end(); name++){
+        std::ofstream stitched("./data/" + prefix + *name, std::ios::trunc);
+        bool copied = std::find(copiedFiles.begin(), copiedFiles.end(), *name) != copiedFiles.end();
+
+        for(unsigned int i = 0; i < numWindows; i++){
+            std::string fileName = getWindowFileName(prefix, i + 1, *name);
+            std::ifstream file = openWindowFile(fileName);
+
+            if(copied){
+                if(file.peek() != std::ifstream::traits_type::eof())
+                    stitched << file.rdbuf(); // sets failbit if nothing is copied
+            }
+            else if(*name == "sourceDestination.txt"){
+                pkt_id_t id;
+                host_id_t srcHost, dstHost;
+                while(file >> id >> srcHost >> dstHost)
+                    stitched << windows[i].getStitchedId(id, fileName) << '\t' << srcHost << '\t' << dstHost << '\n';
+            }
+            else{ // switch_<id>.txt
+                sim_time_t rxTime;
+                pkt_id_t id;
+                while(file >> rxTime >> id)
+                    stitched << rxTime << '\t' << windows[i].getStitchedId(id, fileName) << '\n';
+            }
+
+            file.close();
+            std::remove(fileName.c_str());
+        }
+
+        stitched.close();
+        if(stitched.fail()){
+            std::string msg = fmt::format("Failed to write the stitched dump file ./data/{}{}", prefix, *name);
+            throw std::logic_error(msg);
+        }
+    }
+
+    ndebug_print_yellow("Stitched {} time windows: {} pkts in ./data/{}*", numWindows, numPkts, prefix);
+}
+
+void reportSeamFidelity(const std::vector<std::vector<triggerFidelity>> &windowSnapshots, const std::string &prefix){
+
+    double latencyErrSum = 0, deliveredErrSum = 0, backlogErrSum = 0;
+    double latencyErrMax = 0, deliveredErrMax = 0, backlogErrMax = 0;
+    unsigned int numSeams = 0;
+
+    std::ofstream file("./data/" + prefix + "seams.txt");
+    file << "time meanLatencyBefore meanLatencyAfter deliveredBefore deliveredAfter latencyErr deliveredErr backlogErr" << std::endl;
+
+    for(size_t i = 1; i < windowSnapshots.size(); i++){
+        // Missing if a window was stopped early
+        if(windowSnapshots[i - 1].empty() || windowSnapshots[i].empty() || windowSnapshots[i - 1].back().time != windowSnapshots[i].front().time)
+            continue;
+
+        const triggerFidelity &before = windowSnapshots[i - 1].back();
+        const triggerFidelity &after = windowSnapshots[i].front();
+        fidelityErrors errors = compareSnapshots(before, after);
+
+        latencyErrSum += errors.latency;
+        deliveredErrSum += errors.delivered;
+        backlogErrSum += errors.backlog;
+        latencyErrMax = std::max(latencyErrMax, errors.latency);
+        deliveredErrMax = std::max(deliveredErrMax, errors.delivered);
+        backlogErrMax = std::max(backlogErrMax, errors.backlog);
+        numSeams++;
+
+        file << fmt::format("{} {:.1f} {:.1f} {} {} {:.4f} {:.4f} {:.4f}", before.time, before.meanLatency, after.meanLatency,
+            before.numDelivered, after.numDelivered, errors.latency, errors.delivered, errors.backlog) << std::endl;
+    }
+    file.close();
+
+    ndebug_print_yellow("#####  Time windows: mismatch at the seams  #####");
+    ndebug_print("Warm-up {}ns | Pkts delivered in the {}ns before each of {} seams", syndbConfig.timeWindowWarmUpNs, syndbConfig.hybridMeasureNs, numSeams);
+    if(numSeams == 0)
+        return;
+
+    ndebug_print("Mean latency error: {:.2f}% mean | {:.2f}% max", 100.0 * latencyErrSum / numSeams, 100.0 * latencyErrMax);
+    ndebug_print("Delivered pkts error: {:.2f}% mean | {:.2f}% max", 100.0 * deliveredErrSum / numSeams, 100.0 * deliveredErrMax);
+    ndebug_print("Link backlog error: {:.2f}% mean | {:.2f}% max", 100.0 * backlogErrSum / numSeams, 100.0 * backlogErrMax);
+    ndebug_print("Per seam: ./data/{}seams.txt", prefix);
+}
@@ -0,0 +1,24 @@
+#ifndef TIMEPARALLEL_H
+#define TIMEPARALLEL_H
+
+#include <vector>
+#include <string>
+#include "utils/types.hpp"
+#include "simulation/hybrid.hpp"
+
+/*
+    Time-parallel mode (numTimeWindows > 1): the dump files of the windows (./data/<prefix>window<i>_*) become the ones
+    of the whole run (./data/<prefix>*). Every window has pkt ids of its own. They are renumbered into one sequence:
+    window by window, in the order of the ids within a window. Trigger ids are the same in all windows.
+*/
+void stitchTimeWindows(const std::string &prefix, unsigned int numWindows, switch_id_t numSwitches);
+
+/*
+    The queue states at the seams: the snapshot of a window at its start is compared with the one of the previous window,
+    which simulated up to there without a break. windowSnapshots[i] are the ones of window i + 1.
+    Also written to ./data/<prefix>seams.txt
+*/
+void reportSeamFidelity(const std::vector<std::vector<triggerFidelity>> &windowSnapshots, const std::string &prefix);
+
+
+#endif
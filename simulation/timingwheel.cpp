@@ -0,0 +1,135 @@
+#include "simulation/timingwheel.hpp"
+#include "simulation/event.hpp"
+
+template<typename T>
+TimingWheel<T>::TimingWheel(sim_time_t granularity){
+    this->granularity = granularity;
+    this->currTick = 0;
+    this->numItems = 0;
+}
+
+template<typename T>
+void TimingWheel<T>::insert(sim_time_t time, const T &item){
+    // An item is due at the first tick which is >= its time
+    uint64_t tick = (time + this->granularity - 1) / this->granularity;
+    entry_t entry(tick, item);
+
+    this->place(entry);
+    this->numItems++;
+}
+
+template<typename T>
+void TimingWheel<T>::place(entry_t &entry){
+
+    if(entry.first < this->currTick){
+        this->overdue.push_back(std::move(entry));
+        return;
+    }
+
+    // Level is given by the highest digit where tick and currTick differ
+    uint64_t diff = entry.first ^ this->currTick;
+    uint32_t level = 0;
+    while(level < numLevels && (diff >> (slotBits * (level + 1))) != 0)
+        level++;
+
+    if(level == numLevels){
+        this->overflow.push_back(std::move(entry));
+        return;
+    }
+
+    uint32_t slot = (entry.first >> (slotBits * level)) & (numSlots - 1);
+    this->slots[level][slot].push_back(std::move(entry));
+}
+
+template<typename T>
+void TimingWheel<T>::cascade(std::vector<entry_t> &slot){
+    if(slot.empty())
+        return;
+
+    // Swap out first since place() may push back into the same slot vector
+    std::vector<entry_t> cascading;
+    cascading.swap(slot);
+
+    for(auto it = cascading.begin(); it != cascading.end(); it++){
+        this->place(*it);
+    }
+
+    // Hand the (cleared) buffer back to the slot to keep its capacity
+    cascading.clear();
+    if(slot.empty())
+        slot.swap(cascading);
+}
+
+template<typename T>
+void TimingWheel<T>::advance(sim_time_t now, std::vector<T> &dueItems){
+
+    uint64_t targetTick = now / this->granularity;
+
+    for(auto it = this->overdue.begin(); it != this->overdue.end(); it++){
+        dueItems.push_back(std::move(it->second));
+    }
+    this->numItems -= this->overdue.size();
+    this->overdue.clear();
+
+    while(this->currTick <= targetTick){
+
+        // Cascade higher levels down, top-most first, when the lower digits of currTick wrap to 0
+        if((this->currTick & (numSlots - 1)) == 0){
+
+            if((this->currTick >> (slotBits * numLevels)) != 0 && (this->currTick & ((1ULL << (slotBits * numLevels)) - 1)) == 0){
+                this->cascade(this->overflow);
+            }
+
+            for(int level = numLevels - 1; level > 0; level--){
+                uint64_t lowerMask = (1ULL << (slotBits * level)) - 1;
+                if((this->currTick & lowerMask) == 0){
+                    uint32_t slot = (this->currTick >> (slotBits * level)) & (numSlots - 1);
+                    this->cascade(this->slots[level][slot]);
+                }
+            }
+        }
+
+        std::vector<entry_t> &slot = this->slots[0][this->currTick & (numSlots - 1)];
+        for(auto it = slot.begin(); it != slot.end(); it++){
+            dueItems.push_back(std::move(it->second));
+        }
+        this->numItems -= slot.size();
+        slot.clear();
+
+        this->currTick++;
+    }
+}
+
+template<typename T>
+void TimingWheel<T>::collectAll(std::vector<T> &items) const{
+    for(uint32_t level = 0; level < numLevels; level++){
+        for(uint32_t slot = 0; slot < numSlots; slot++){
+            for(auto it = this->slots[level][slot].begin(); it != this->slots[level][slot].end(); it++)
+                items.push_back(it->second);
+        }
+    }
+
+    for(auto it = this->overdue.begin(); it != this->overdue.end(); it++)
+        items.push_back(it->second);
+
+    for(auto it = this->overflow.begin(); it != this->overflow.end(); it++)
+        items.push_back(it->second);
+}
+
+template<typename T>
+void TimingWheel<T>::clear(){
+    for(uint32_t level = 0; level < numLevels; level++){
+        for(uint32_t slot = 0; slot < numSlots; slot++)
+            this->slots[level][slot].clear();
+    }
+    this->overdue.clear();
+    this->overflow.clear();
+    this->numItems = 0;
+}
+
+/*
+    To avoid linking error for the template's methods,
+    instantiating the template class with the possible types
+*/
+
+template struct TimingWheel<pktevent_p<normalpkt_p>>;
@@ -0,0 +1,51 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <vector>
+#include <utility>
+#include "utils/types.hpp"
+
+/*
+    Hierarchical timing wheel (Varghese & Lauck) bucketed by time.
+    A tick spans granularity ns. Level L has numSlots slots, each covering 256^L ticks.
+    An item is placed on the level of the highest 8-bit digit where its tick differs from currTick,
+    and cascades down one level each time currTick reaches that digit.
+
+    insert() is O(1). advance() touches only the slots of the ticks it passes plus the due items.
+*/
+template<typename T>
+struct TimingWheel
+{
+    static const uint32_t slotBits = 8;
+    static const uint32_t numSlots = 1 << slotBits;
+    static const uint32_t numLevels = 4; // 256^4 ticks. With 100ns ticks this is ~429s
+
+    typedef std::pair<uint64_t, T> entry_t; // <tick, item>
+
+    sim_time_t granularity;
+    uint64_t currTick; // next tick to be drained. All earlier ticks are drained.
+    size_t numItems;
+
+    std::vector<entry_t> slots[numLevels][numSlots];
+    std::vector<entry_t> overdue; // inserted for an already drained tick
+    std::vector<entry_t> overflow; // beyond the top level
+
+    TimingWheel(sim_time_t granularity);
+
+    void insert(sim_time_t time, const T &item);
+    /* Moves all items with time <= now into dueItems, in tick order */
+    void advance(sim_time_t now, std::vector<T> &dueItems);
+    /* Copies all items still in the wheel into items. No particular order. */
+    void collectAll(std::vector<T> &items) const;
+    void clear();
+
+    inline size_t size() const { return this->numItems; };
+    inline bool empty() const { return this->numItems == 0; };
+
+    private:
+    void place(entry_t &entry);
+    void cascade(std::vector<entry_t> &slot);
+};
+
+
+#endif
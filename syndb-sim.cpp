@@ -1,92 +1,401 @@
 #include <stdio.h>
 #include <signal.h>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <fmt/core.h>
 #include <fmt/color.h>
+#include <fmt/chrono.h>
+#include <spdlog/spdlog.h>
 #include "utils/logger.hpp"
+#include "utils/utils.hpp"
 #include "simulation/config.hpp"
 #include "simulation/simulation.hpp"
+#include "simulation/checkpoint.hpp"
+#include "simulation/sweep.hpp"
+#include "simulation/timeparallel.hpp"
 #include "devtests/devtests.hpp"
 
 void signalHandler(int signum){
     ndebug_print_yellow("\nCaught signal {}", signum);
 
-    syndbSim.cleanUp();
+    // First signal: let the main loop stop at the end of the tick/window, after a last checkpoint
+    if(syndbStopSignal == 0){
+        syndbStopSignal = signum;
+        return;
+    }
+
+    // Ensemble mode: the other replicas are still running, only exit
+    if(syndbConfig.numEnsembleReplicas == 0 && syndbSim != NULL)
+        syndbSim->cleanUp();
 
     exit(signum);
 }
 
-int main(){
+/* Runs syndbSim (of the calling thread) to the end. Returns false if a forked what-if branch failed. */
+bool runSimulation(){
 
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
+    PhaseTimer startup;
 
-    syndbSim = Simulation();
-
-    // Init Step 0: Open files for logging
+    // Init Step 0: Open files for logging. A restored run appends to the files of the checkpointed run.
     #if LOGGING
-    syndbSim.pktDumper->openFiles(syndbConfig.numSwitches, syndbConfig.numHosts);
+    if(syndbConfig.restoreCheckpointFile.empty())
+        syndbSim->pktDumper->openFiles(syndbConfig.numSwitches, syndbConfig.numHosts);
+    else
+        syndbSim->pktDumper->openFiles(syndbConfig.numSwitches, syndbConfig.numHosts, readCheckpointDumpPrefix(syndbConfig.restoreCheckpointFile));
     #endif
-    syndbSim.printSimulationSetup();
+    syndbSim->printSimulationSetup();
+    startup.endPhase("dump files");
     
     // Init Step 1: Build the topology
-    syndbSim.buildTopo();
+    syndbSim->buildTopo();
+    syndbSim->initPartitions();
+    startup.endPhase("topology");
 
     // Init Step 2: Init the triggerGen schedule
     #if TRIGGERS_ENABLED
-    syndbSim.initTriggerGen();
-    syndbSim.triggerGen->printTriggerSchedule();
+    syndbSim->initTriggerGen();
+    syndbSim->triggerGen->printTriggerSchedule();
+    startup.endPhase("triggers");
     #endif
     #if INCASTS_ENABLED
-    syndbSim.initIncastGen();
-    syndbSim.incastGen->printIncastSchedule();
+    syndbSim->initIncastGen();
+    syndbSim->incastGen->printIncastSchedule();
+    startup.endPhase("incasts");
     #endif
     
     // Init Step 3: Initialize the hosts
-    syndbSim.initHosts();
+    syndbSim->initHosts();
+    #if INTRA_STEP_PARALLEL
+    syndbSim->initStepPool();
+    #endif
+    startup.endPhase("hosts");
 
+    // Init Step 4: Continue a checkpointed run
+    if(!syndbConfig.restoreCheckpointFile.empty())
+        syndbSim->restoreCheckpoint(syndbConfig.restoreCheckpointFile);
+    else
+        syndbSim->scheduleNextCheckpoint(0);
+    syndbSim->scheduleBranching();
 
-    // Main simulation loop: at time = 0; all event lists are empty. Only step 4 does some work.
-    for ( ; syndbSim.currTime <= syndbSim.totalTime; syndbSim.currTime += syndbSim.timeIncrement)
+    // Init Step 5: Hybrid fluid/pkt mode. May stop the hosts right away, until the first pkt-level window.
+    syndbSim->initHybrid();
+    startup.endPhase("checkpoint + hybrid");
+
+    ndebug_print_yellow("Startup: {}", startup.format());
+
+
+    #if EVENT_DRIVEN
+    // Event-driven main loop: jumps from one event timestamp to the next
+    syndbSim->runEventDriven();
+    #else
+    // Main simulation loop: at time = 0; all event lists are empty. Step 1 sends the first pkts (if due).
+    for ( ; syndbSim->currTime <= syndbSim->totalTime; syndbSim->currTime += syndbSim->timeIncrement)
     {
-        debug_print_yellow("########  Simulation Time: {}  ########", syndbSim.currTime);
-        if(syndbSim.currTime % 100000 == 0)
-            ndebug_print_yellow("########  Simulation Time: {}  ########", syndbSim.currTime);
+        debug_print_yellow("########  Simulation Time: {}  ########", syndbSim->currTime);
+        if(syndbSim->currTime % 100000 == 0)
+            ndebug_print_yellow("########  Simulation Time: {}  ########", syndbSim->currTime);
+
+        // Step 0: Hybrid mode: switch between fluid and pkt level, take the trigger snapshots (if due)
+        if(syndbSim->hybrid && syndbSim->currTime >= syndbSim->hybrid->nextActionTime)
+            syndbSim->hybrid->runActions(syndbSim->currTime);
         
-        // Step 1: Process all hostPktEvents
-        syndbSim.processHostPktEvents();
+        // Step 1: Send all due host pkts (and generate the next pkt on those hosts)
+        syndbSim->processHostPktEvents();
         
         // Step 2: Generate (as per schedule) and process triggerPktEvents
         #if TRIGGERS_ENABLED
-        syndbSim.triggerGen->generateTrigger();
-        syndbSim.processTriggerPktEvents();
+        syndbSim->triggerGen->generateTrigger();
+        syndbSim->processTriggerPktEvents();
         #endif
 
         // Step 3: Process all normalPktEvents
-        syndbSim.processNormalPktEvents();
+        syndbSim->processNormalPktEvents();
 
         // Step 4: Generate (rather modify) (as per schedule) incast pkts on certain hosts
         #if INCASTS_ENABLED
-        syndbSim.incastGen->generateIncast(); // these pkts would be picked-up first in step 5
+        syndbSim->incastGen->generateIncast(); // these pkts would be picked-up in step 1 of the next timeIncrement slot
         #endif
 
-        // Step 5: Generate hostPktEvents for the next timeIncrement slot
-        syndbSim.generateHostPktEvents();
+        // Step 5: Checkpoint (if due), between this and the next timeIncrement slot
+        if(syndbSim->checkpointAt(syndbSim->currTime + syndbSim->timeIncrement))
+            break; // stopped by a signal
+
+        // Step 6: Fork the what-if branches (if due). Each process continues with the next timeIncrement slot.
+        if(syndbSim->isBranchingDue(syndbSim->currTime + syndbSim->timeIncrement))
+            syndbSim->forkBranches(syndbSim->currTime + syndbSim->timeIncrement);
 
     } // end of main simulation loop
+    #endif
+
+    syndbSim->cleanUp();
 
-    syndbSim.cleanUp();
+    // Main run of a branching run: the branches were forked from this process
+    bool branchesOk = syndbSim->waitForBranches();
+
+    if(syndbStopSignal != 0)
+        return branchesOk;
 
     
 #ifdef DEBUG
     checkRemainingQueuingAtLinks();
     // testNormalPktLatencies(0, 1);
     // testRingBufferOps();
+    // testTimingWheelOps();
     // showSimpleTopoRingBuffers(); 
     // showFatTreeTopoRoutingTables();
+    if(syndbConfig.topoType == TopologyType::FatTree){
+        testFatTreeRouting();
+        testFatTreePaths();
+    }
+    if(syndbConfig.topoType == TopologyType::File)
+        testFileTopoRouting();
 #endif
 
     
-    return 0;
+    return branchesOk;
 }
 
+/*
+    Ensemble mode: numEnsembleReplicas independent runs, one thread each, in this process.
+    An exception of a replica is re-thrown once all of them are done.
+*/
+bool runEnsemble(){
+
+    if(!syndbConfig.restoreCheckpointFile.empty() || syndbConfig.numWhatIfBranches > 0){
+        std::string msg = "Ensemble runs can neither be restored from a checkpoint nor fork what-if branches";
+        throw std::logic_error(msg);
+    }
+
+    #if LOGGING
+    spdlog::init_thread_pool(QUEUE_SIZE, 1); // shared by the replicas
+    #endif
+
+    std::vector<std::thread> replicas;
+    std::vector<char> replicaOk(syndbConfig.numEnsembleReplicas, false);
+    std::vector<std::exception_ptr> replicaErrors(syndbConfig.numEnsembleReplicas);
 
+    for(unsigned int i = 0; i < syndbConfig.numEnsembleReplicas; i++){
+        replicas.push_back(std::thread([i, &replicaOk, &replicaErrors]{
+            try{
+                Simulation sim(i + 1);
+                syndbSim = &sim;
+                replicaOk[i] = runSimulation();
+                syndbSim = NULL;
+            }
+            catch(...){
+                replicaErrors[i] = std::current_exception();
+                syndbSim = NULL;
+            }
+        }));
+    }
+
+    for(auto it = replicas.begin(); it != replicas.end(); it++){
+        it->join();
+    }
+
+    for(auto it = replicaErrors.begin(); it != replicaErrors.end(); it++){
+        if(*it)
+            std::rethrow_exception(*it);
+    }
+
+    fmt::print("{} ensemble replicas finished\n", syndbConfig.numEnsembleReplicas);
+    return std::find(replicaOk.begin(), replicaOk.end(), false) == replicaOk.end();
+}
+
+/*
+    hybridCompareFull: the hybrid run and a full pkt-level run with the same random seed, one thread each, in this process.
+    Reports the fidelity loss of the hybrid run at the triggers once both are done (see reportHybridFidelity()).
+*/
+bool runHybridComparison(){
+
+    if(syndbConfig.numEnsembleReplicas > 0){
+        std::string msg = "hybridCompareFull runs a single hybrid simulation, not an ensemble";
+        throw std::logic_error(msg);
+    }
+
+    // Both runs MUST see the same traffic and schedules. The full run's files get a "full_" tag in the common prefix.
+    uint64_t randomSeed = syndbConfig.randomSeed;
+    if(randomSeed == 0)
+        randomSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+
+    if(syndbConfig.dumpPrefix.empty()){
+        std::time_t currentTime = std::time(nullptr);
+        syndbConfig.dumpPrefix = fmt::format("dump_{:%Y-%m-%d}_{:%H.%M.%S}_", fmt::localtime(currentTime), fmt::localtime(currentTime));
+    }
+
+    #if LOGGING
+    spdlog::init_thread_pool(QUEUE_SIZE, 1); // shared by the two runs
+    #endif
+
+    std::vector<std::thread> runs;
+    std::vector<char> runOk(2, false);
+    std::vector<std::exception_ptr> runErrors(2);
+    std::vector<std::vector<triggerFidelity>> snapshots(2);
+
+    for(unsigned int i = 0; i < 2; i++){
+        runs.push_back(std::thread([i, randomSeed, &runOk, &runErrors, &snapshots]{
+            try{
+                Simulation sim;
+                sim.hybridReference = (i == 0);
+                sim.randomSeed = randomSeed;
+                syndbSim = &sim;
+                runOk[i] = runSimulation();
+                snapshots[i] = sim.hybrid->snapshots;
+                syndbSim = NULL;
+            }
+            catch(...){
+                runErrors[i] = std::current_exception();
+                syndbSim = NULL;
+            }
+        }));
+    }
+
+    for(auto it = runs.begin(); it != runs.end(); it++){
+        it->join();
+    }
+
+    for(auto it = runErrors.begin(); it != runErrors.end(); it++){
+        if(*it)
+            std::rethrow_exception(*it);
+    }
+
+    #if LOGGING
+    reportHybridFidelity(snapshots[0], snapshots[1], syndbConfig.dumpPrefix);
+    #else
+    reportHybridFidelity(snapshots[0], snapshots[1], "");
+    #endif
+    return runOk[0] && runOk[1];
+}
+
+/*
+    Time-parallel mode: numTimeWindows windows of the run, one thread each, in this process. A window starts with a fluid
+    pre-pass up to timeWindowWarmUpNs before its start and simulates pkt by pkt from there. It dumps the pkts delivered
+    (and the triggers/incasts) from its start on. The dumps are stitched together once all windows are done.
+*/
+bool runTimeParallel(){
+
+    if(syndbConfig.numEnsembleReplicas > 0 || syndbConfig.hybridWarmInNs > 0 || syndbConfig.numWhatIfBranches > 0
+        || syndbConfig.checkpointIntervalMSecs > 0 || !syndbConfig.restoreCheckpointFile.empty()){
+        std::string msg = "Time-parallel runs can't be ensembles, hybrid runs, checkpointed, restored from a checkpoint or fork what-if branches";
+        throw std::logic_error(msg);
+    }
+
+    if(syndbConfig.hybridMeasureNs > syndbConfig.timeWindowWarmUpNs){
+        std::string msg = fmt::format("hybridMeasureNs of {}ns must not be longer than the timeWindowWarmUpNs of {}ns", syndbConfig.hybridMeasureNs, syndbConfig.timeWindowWarmUpNs);
+        throw std::logic_error(msg);
+    }
+
+    // The windows MUST see the same trigger and incast schedules
+    uint64_t randomSeed = syndbConfig.randomSeed;
+    if(randomSeed == 0)
+        randomSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+
+    if(syndbConfig.dumpPrefix.empty()){
+        std::time_t currentTime = std::time(nullptr);
+        syndbConfig.dumpPrefix = fmt::format("dump_{:%Y-%m-%d}_{:%H.%M.%S}_", fmt::localtime(currentTime), fmt::localtime(currentTime));
+    }
+
+    #if LOGGING
+    spdlog::init_thread_pool(QUEUE_SIZE, 1); // shared by the windows
+    #endif
+
+    unsigned int numWindows = syndbConfig.numTimeWindows;
+    std::vector<std::thread> windows;
+    std::vector<char> windowOk(numWindows, false);
+    std::vector<std::exception_ptr> windowErrors(numWindows);
+    std::vector<std::vector<triggerFidelity>> snapshots(numWindows);
+
+    for(unsigned int i = 0; i < numWindows; i++){
+        windows.push_back(std::thread([i, randomSeed, &windowOk, &windowErrors, &snapshots]{
+            try{
+                Simulation sim;
+                sim.randomSeed = randomSeed;
+                sim.setTimeWindow(i + 1);
+                syndbSim = &sim;
+                windowOk[i] = runSimulation();
+                snapshots[i] = sim.hybrid->snapshots;
+                syndbSim = NULL;
+            }
+            catch(...){
+                windowErrors[i] = std::current_exception();
+                syndbSim = NULL;
+            }
+        }));
+    }
+
+    for(auto it = windows.begin(); it != windows.end(); it++){
+        it->join();
+    }
+
+    for(auto it = windowErrors.begin(); it != windowErrors.end(); it++){
+        if(*it)
+            std::rethrow_exception(*it);
+    }
+
+    #if LOGGING
+    spdlog::shutdown(); // writes out and closes the files of all windows
+    if(syndbStopSignal == 0)
+        stitchTimeWindows(syndbConfig.dumpPrefix, numWindows, syndbConfig.numSwitches);
+    reportSeamFidelity(snapshots, syndbConfig.dumpPrefix);
+    #else
+    reportSeamFidelity(snapshots, "");
+    #endif
+
+    return std::find(windowOk.begin(), windowOk.end(), false) == windowOk.end();
+}
+
+/* A single run, an ensemble, a hybrid run with its reference or a time-parallel run, as configured */
+bool runConfigured(){
+    if(syndbConfig.numTimeWindows > 1)
+        return runTimeParallel();
+
+    if(syndbConfig.hybridWarmInNs > 0 && syndbConfig.hybridCompareFull)
+        return runHybridComparison();
+
+    if(syndbConfig.numEnsembleReplicas > 0)
+        return runEnsemble();
+
+    Simulation sim;
+    syndbSim = &sim;
+    bool ok = runSimulation();
+    syndbSim = NULL;
+    return ok;
+}
+
+/*
+    Usage: syndb-sim [config file]
+    The config file overrides the compiled-in config (see readConfigFile()). A key with several values makes a parameter sweep.
+*/
+int main(int argc, char** argv){
+
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    if(argc > 2){
+        fmt::print(stderr, "Usage: {} [config file]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<config_params_t> points(1);
+    if(argc == 2)
+        points = expandGrid(readConfigFile(argv[1]));
+
+    bool ok;
+    if(points.size() > 1){
+        ok = runSweep(points, runConfigured);
+    }
+    else{
+        syndbConfig.apply(points[0]);
+        ok = runConfigured();
+    }
+
+    if(syndbStopSignal != 0)
+        exit(syndbStopSignal);
+
+    return ok ? 0 : 1;
+}
@@ -1,119 +1,212 @@
 #include "topology/fattree_topology.hpp"
 #include "utils/logger.hpp"
+#include "utils/utils.hpp"
 
+template<typename T>
+static switch_p placeSwitch(std::shared_ptr<ObjectArena<T>> &arena, size_t idx, switch_id_t id, SwitchType type){
+    T* sw = arena->create(idx, id);
+    sw->type = type;
+    return switch_p(arena, sw); // aliasing: owns the arena, points to the switch
+}
+
+/*
+    The ids are closed-form, the same as building the pods one after the other:
+    switches: per pod the k/2 ToRs, then the k/2 Aggrs. The cores come after all the pods.
+    links: per pod the host links of each ToR, then the ToR links of each Aggr. The core links come after all the pods.
+    Writes only to the slots of this pod, so the pods can be built in parallel.
+*/
 void Pod::buildPod(){
+    FattreeTopology &topo = this->parentTopo;
+    uint halfK = topo.k / 2;
+    switch_id_t firstSwitchId = this->id * topo.k;
+    link_id_t firstLinkId = (link_id_t)this->id * topo.k * halfK;
+    uint64_t firstNetworkLinkSlot = (uint64_t)this->id * halfK * halfK;
 
-   
     // Construct the racks
-    auto tor_it = this->torSwitches.begin();
-    for(tor_it; tor_it != this->torSwitches.end(); tor_it++){
-        
-        // create the ToR switch
-        *tor_it = parentTopo.createNewSwitch(SwitchType::FtTor);
+    for(uint z = 0; z < halfK; z++){
+        host_id_t rackId = this->id * halfK + z;
+        switch_p torSwitch = placeSwitch(topo.torArena, rackId, firstSwitchId + z, SwitchType::FtTor);
+        this->torSwitches[z] = torSwitch;
+        topo.switches[torSwitch->id] = torSwitch;
 
-        // Update podId for the ToR switch
-        std::dynamic_pointer_cast<SwitchFtTor>(*tor_it)->podId = this->id;
+        SwitchFtTor* tor = static_cast<SwitchFtTor*>(torSwitch.get());
+        tor->podId = this->id;
+        tor->podLocalIdx = z;
+        tor->rackId = rackId;
 
         // create and add k/2 hosts to the ToR switch
-        for(int i=0; i < (syndbConfig.fatTreeTopoK / 2); i++){
-            host_p h = parentTopo.createNewHost();
-            parentTopo.addHostToTor(h, *tor_it);
-        }
-
-    } // end of tor_it loop
+        for(uint i = 0; i < halfK; i++){
+            host_id_t hostId = rackId * halfK + i;
+            Host* host = topo.hostArena->create(hostId, hostId);
+            topo.hosts[hostId] = host_p(topo.hostArena, host);
 
-     // Initialize the Aggr switches
-    // racklocal_host_id_t localHostId = 0;
-    auto aggr_it = this->aggrSwitches.begin();
-    for(aggr_it; aggr_it != this->aggrSwitches.end(); aggr_it++){
-        *aggr_it = parentTopo.createNewSwitch(SwitchType::FtAggr);
-        std::dynamic_pointer_cast<SwitchFtAggr>(*aggr_it)->podId = this->id;
+            HostTorLink* link = topo.placeToRLink(hostId, firstLinkId + z * halfK + i);
+            topo.connectHostToTor(host, tor, link);
+        }
+    }
 
-        // connect the Aggr switch to the ToR switches
-        auto tor_it = this->torSwitches.begin();
-        for(tor_it; tor_it != this->torSwitches.end(); tor_it++){
-            // Adds links, updates neighborSwitch tables on both the switches
-            parentTopo.connectSwitchToSwitch(*tor_it, *aggr_it);
+    // Initialize the Aggr switches and connect them to the ToR switches
+    firstLinkId += halfK * halfK;
+    for(uint z = 0; z < halfK; z++){
+        switch_p aggrSwitch = placeSwitch(topo.aggrArena, this->id * halfK + z, firstSwitchId + halfK + z, SwitchType::FtAggr);
+        this->aggrSwitches[z] = aggrSwitch;
+        topo.switches[aggrSwitch->id] = aggrSwitch;
+
+        SwitchFtAggr* aggr = static_cast<SwitchFtAggr*>(aggrSwitch.get());
+        aggr->podId = this->id;
+        aggr->podLocalIdx = z;
+
+        for(uint t = 0; t < halfK; t++){
+            Switch* tor = this->torSwitches[t].get();
+            NetworkLink* link = topo.placeNetworkLink(firstNetworkLinkSlot + z * halfK + t, firstLinkId + z * halfK + t, tor->id, aggr->id);
+            topo.connectSwitchToSwitch(tor, aggr, link);
         }
     }
 
-    
     // Populate routing tables for the ToR switches
-    ft_scale_t ftscaleK = syndbConfig.fatTreeTopoK;
-    uint aggrSwitchIdx;
-
-    for(int z=0; z < this->torSwitches.size(); z++){ // loops over ToR switches
-        std::shared_ptr<SwitchFtTor> tor = std::dynamic_pointer_cast<SwitchFtTor>(this->torSwitches[z]);
+    for(uint z = 0; z < halfK; z++){ // loops over ToR switches
+        SwitchFtTor* tor = static_cast<SwitchFtTor*>(this->torSwitches[z].get());
 
         // Fills routing table of tor for all possible racklocal host IDs
-        for(int rlocalHostId=0; rlocalHostId < ftscaleK/2; rlocalHostId++){ 
-            aggrSwitchIdx = (rlocalHostId + z) % (ftscaleK/2);
+        for(uint rlocalHostId = 0; rlocalHostId < halfK; rlocalHostId++){
+            uint aggrSwitchIdx = (rlocalHostId + z) % halfK;
             tor->routingTable[rlocalHostId] = this->aggrSwitches[aggrSwitchIdx]->id;
         }
     }
 
 }
 
-void FattreeTopology::buildTopo(){
+/* Sizes the switches, hosts and links of the topology and its arenas. The pods and cores then fill their slots. */
+void FattreeTopology::allocate(){
+    uint halfK = this->k / 2;
+    uint64_t numPodSwitches = (uint64_t)this->k * halfK; // of each kind
+    uint64_t numHosts = numPodSwitches * halfK;
+    uint64_t numPodLinks = numPodSwitches * halfK; // ToR to Aggr
+
+    this->hostArena = std::make_shared<ObjectArena<Host>>(numHosts);
+    this->torArena = std::make_shared<ObjectArena<SwitchFtTor>>(numPodSwitches);
+    this->aggrArena = std::make_shared<ObjectArena<SwitchFtAggr>>(numPodSwitches);
+    this->coreArena = std::make_shared<ObjectArena<SwitchFtCore>>(this->numCoreSwitches);
+
+    this->switches.resize(2 * numPodSwitches + this->numCoreSwitches);
+    this->hosts.resize(numHosts);
+    this->hostTors.resize(numHosts);
+    this->torLinks.resize(numHosts);
+    this->networkLinks.resize(numPodLinks + (uint64_t)this->numCoreSwitches * this->k);
+
+    this->nextSwitchId = this->switches.size();
+    this->nextHostId = this->hosts.size();
+    this->nextLinkId = this->torLinks.size() + this->networkLinks.size();
+}
 
-    // Instantiate and build the pods 
-    for(int i=0; i < this->k; i++){
-        this->pods[i] = pod_p(new Pod(this->getNextPodId(),*this));
-        this->pods[i]->buildPod();
+/*
+    Core switches of a stride connect to the Aggr of the same index in every pod. Update routing on the Core switches
+    and on the Aggrs of the stride. Only this stride touches them, so the strides can be built in parallel.
+*/
+void FattreeTopology::buildCoreStride(uint stride){
+    uint halfK = this->k / 2;
+    uint64_t firstLinkSlot = (uint64_t)this->k * halfK * halfK;
+
+    for(uint coreSwitchIdx = stride * halfK; coreSwitchIdx < std::min(this->numCoreSwitches, (stride + 1) * halfK); coreSwitchIdx++){
+        switch_p coreSwitch = placeSwitch(this->coreArena, coreSwitchIdx, this->k * this->k + coreSwitchIdx, SwitchType::FtCore);
+        this->coreSwitches[coreSwitchIdx] = coreSwitch;
+        this->switches[coreSwitch->id] = coreSwitch;
+        SwitchFtCore* core = static_cast<SwitchFtCore*>(coreSwitch.get());
+
+        for(pod_id_t podIdx = 0; podIdx < this->k; podIdx++){
+            SwitchFtAggr* aggr = static_cast<SwitchFtAggr*>(this->pods[podIdx]->aggrSwitches[stride].get());
+
+            uint64_t slot = firstLinkSlot + (uint64_t)coreSwitchIdx * this->k + podIdx;
+            NetworkLink* link = this->placeNetworkLink(slot, this->torLinks.size() + slot, core->id, aggr->id);
+            this->connectSwitchToSwitch(core, aggr, link);
+
+            core->routingTable[podIdx] = aggr->id;
+            aggr->coreSwitchesList.push_back(core->id);
+        }
     }
 
-    // Create all Core switches
-    for(int i=0; i < this->numCoreSwitches; i++){
-        this->coreSwitches[i] = this->createNewSwitch(SwitchType::FtCore);
+    // Fill entries in the routing tables of the Aggrs of the stride
+    for(pod_id_t podIdx = 0; podIdx < this->k; podIdx++){
+        SwitchFtAggr* aggr = static_cast<SwitchFtAggr*>(this->pods[podIdx]->aggrSwitches[stride].get());
+
+        for(uint rlocalHostId = 0; rlocalHostId < halfK; rlocalHostId++){
+            uint coreSwitchIdx = (rlocalHostId + stride) % halfK;
+            aggr->routingTable[rlocalHostId] = aggr->coreSwitchesList[coreSwitchIdx];
+        }
     }
+}
 
-    // Connect Core switches to the pods. Update routing on only the Core switches
-    /* 
-        For each core switch, compute the stride number it belongs to. 
-        Then for each pod, index the aggrSwitch array with the stride number 
-        to get the connected aggr switch.
-    */
-    for(uint coreSwitchIdx=0; coreSwitchIdx < this->numCoreSwitches; coreSwitchIdx++){
-        // compute the stride for the core switch
-        uint stride = coreSwitchIdx / (this->k/2); 
-        uint strideLocalCoreSwitchIdx = coreSwitchIdx % (this->k/2); 
-        switch_p coreSwitch = this->coreSwitches[coreSwitchIdx];
-
-        for(pod_id_t podIdx=0; podIdx < this->k; podIdx++){
-            switch_p aggrSwitch = this->pods[podIdx]->aggrSwitches[stride];
-
-            // Add links, update neighborSwitch tables on both the switches
-            this->connectSwitchToSwitch(coreSwitch, aggrSwitch);
-            // Update routing table on the Core Switch
-            std::dynamic_pointer_cast<SwitchFtCore>(coreSwitch)->routingTable[podIdx] = aggrSwitch->id;
-
-            // Add the core switch to AggrSwitch's coreSwitchesList
-            std::dynamic_pointer_cast<SwitchFtAggr>(aggrSwitch)->coreSwitchesList.push_back(coreSwitch->id);
-          
-        }    
-        
-    } // end of for loop on all core switches
-
-
-    // Update routing on all Aggr switches (across all pods)
-    ft_scale_t ftscaleK = syndbConfig.fatTreeTopoK;
-    uint coreSwitchIdx;
-    for(int i=0; i < this->pods.size(); i++){ // loops over all pods
-        pod_p pod = this->pods[i];
-
-        for(int z=0; z < pod->aggrSwitches.size(); z++){ // loops over aggr switches in the pod
-            std::shared_ptr<SwitchFtAggr> aggrSwitch = std::dynamic_pointer_cast<SwitchFtAggr>(pod->aggrSwitches[z]);
-
-            // Fill entries in the routing table of the aggrSwitch
-            for(int rlocalHostId=0; rlocalHostId < ftscaleK/2; rlocalHostId++){
-                coreSwitchIdx = (rlocalHostId + z) % (ftscaleK/2);
-                aggrSwitch->routingTable[rlocalHostId] = aggrSwitch->coreSwitchesList[coreSwitchIdx];
-            } // end of routing table entries   
-        } // end of aggrSwitches in the pod
-    } // end of loop over all pods
+void FattreeTopology::buildTopo(){
+    PhaseTimer build;
+    uint halfK = this->k / 2;
+
+    this->allocate();
+    build.endPhase("allocate");
+
+    // Instantiate and build the pods
+    for(int i=0; i < this->k; i++)
+        this->pods[i] = pod_p(new Pod(this->getNextPodId(), *this));
+
+    unsigned int numThreads = parallelFor(this->k, syndbConfig.numBuildThreads, [this](uint64_t i){
+        this->pods[i]->buildPod();
+    });
+    build.endPhase("pods");
+
+    // Create the Core switches, connect them to the pods
+    uint numStrides = (this->numCoreSwitches + halfK - 1) / halfK;
+    parallelFor(numStrides, syndbConfig.numBuildThreads, [this](uint64_t stride){
+        this->buildCoreStride(stride);
+    });
+    build.endPhase("cores");
+
+    for(switch_id_t id = 0; id < this->switches.size(); id++)
+        this->switchTypeIDMap[this->switches[id]->type].insert(id);
+
+    this->initPorts();
+    build.endPhase("ports");
 
     ndebug_print_yellow("Built FatTree Topo (k={})", this->k);
-    ndebug_print("Total Hosts: {}", this->hostIDMap.size());
-    ndebug_print("Total Switches: {} (Core: {}, Agg: {}, ToR: {})", this->switchIDMap.size(), this->coreSwitches.size(), this->pods.size() * this->pods[0]->aggrSwitches.size(), this->pods.size() * this->pods[0]->torSwitches.size());
-    
+    ndebug_print("Total Hosts: {}", this->hosts.size());
+    ndebug_print("Total Switches: {} (Core: {}, Agg: {}, ToR: {})", this->switches.size(), this->coreSwitches.size(), this->pods.size() * this->pods[0]->aggrSwitches.size(), this->pods.size() * this->pods[0]->torSwitches.size());
+    ndebug_print("Build: {} ({} threads)", build.format(), numThreads);
+}
+
+/*
+    The egress ports of the closed-form routing (see switch_ft.hpp):
+    ToR: hosts by rack-local id | up: k/2 + index of the Aggr in the pod
+    Aggr: down: index of the ToR in the pod | up: k/2 + index of the core among the k/2 ones of the Aggr
+    Core: the Aggr of each pod, by pod id
+*/
+void FattreeTopology::initPorts(){
+    uint halfK = this->k / 2;
+
+    for(auto podIt = this->pods.begin(); podIt != this->pods.end(); podIt++){
+        Pod &pod = **podIt;
+
+        for(uint z = 0; z < halfK; z++){
+            std::shared_ptr<SwitchFtTor> tor = std::static_pointer_cast<SwitchFtTor>(pod.torSwitches[z]);
+            std::shared_ptr<SwitchFtAggr> aggr = std::static_pointer_cast<SwitchFtAggr>(pod.aggrSwitches[z]);
+
+            tor->hostPorts.resize(halfK);
+            for(auto it = tor->neighborHostTable.begin(); it != tor->neighborHostTable.end(); it++)
+                tor->hostPorts[ftModHalfK(it->first, this->k)] = it->second;
+
+            tor->pathCache = &this->pathCache;
+            tor->ports.resize(this->k);
+            aggr->ports.resize(this->k);
+            for(uint j = 0; j < halfK; j++){
+                tor->ports[halfK + j] = tor->getPortTo(pod.aggrSwitches[j].get());
+                aggr->ports[j] = aggr->getPortTo(pod.torSwitches[j].get());
+                aggr->ports[halfK + j] = aggr->getPortTo(this->getSwitchById(aggr->coreSwitchesList[j]));
+            }
+        }
+    }
+
+    for(uint coreSwitchIdx = 0; coreSwitchIdx < this->numCoreSwitches; coreSwitchIdx++){
+        std::shared_ptr<SwitchFtCore> core = std::static_pointer_cast<SwitchFtCore>(this->coreSwitches[coreSwitchIdx]);
+
+        core->ports.resize(this->k);
+        for(pod_id_t podIdx = 0; podIdx < this->k; podIdx++)
+            core->ports[podIdx] = core->getPortTo(this->pods[podIdx]->aggrSwitches[coreSwitchIdx / halfK].get());
+    }
 }
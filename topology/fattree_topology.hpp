@@ -1,9 +1,11 @@
 #ifndef FATTREE_TOPOLOGY_H
 #define FATTREE_TOPOLOGY_H
 
-#include <array>
+#include <vector>
 #include "simulation/config.hpp"
 #include "topology/topology.hpp"
+#include "topology/ft_paths.hpp"
+#include "utils/arena.hpp"
 
 struct Pod;
 typedef std::shared_ptr<Pod> pod_p;
@@ -13,16 +15,30 @@ struct FattreeTopology : Topology
     ft_scale_t k;
     uint numCoreSwitches;
     pod_id_t nextPodId = 0;
-    std::array<pod_p, syndbConfig.fatTreeTopoK> pods;
-    std::array<switch_p, syndbConfig.numCoreSwitches> coreSwitches;
+    std::vector<pod_p> pods; // k
+    std::vector<switch_p> coreSwitches; // numCoreSwitches
+    FtPathCache pathCache; // SOURCE_ROUTING
+
+    // All hosts and switches of a kind in one allocation. switch_p/host_p share the ownership of the arena.
+    std::shared_ptr<ObjectArena<Host>> hostArena;
+    std::shared_ptr<ObjectArena<SwitchFtTor>> torArena;
+    std::shared_ptr<ObjectArena<SwitchFtAggr>> aggrArena;
+    std::shared_ptr<ObjectArena<SwitchFtCore>> coreArena;
 
     // Override the virtual function of the abstract Topology class
     void buildTopo();
-    inline FattreeTopology(ft_scale_t k):Topology(){
+    inline FattreeTopology(ft_scale_t k):Topology(), pathCache(k){
         this->k = k;
         this->numCoreSwitches = syndbConfig.numCoreSwitches;
+        this->pods.resize(k);
+        this->coreSwitches.resize(this->numCoreSwitches);
     }
     inline pod_id_t getNextPodId(){ return this->nextPodId++;}
+
+    private:
+    void allocate();
+    void buildCoreStride(uint stride);
+    void initPorts();
 };
 
 struct Pod
@@ -30,11 +46,13 @@ struct Pod
     pod_id_t id;
     FattreeTopology &parentTopo;
 
-    std::array<switch_p, syndbConfig.fatTreeTopoK/2 > aggrSwitches;
-    std::array<switch_p, syndbConfig.fatTreeTopoK/2 > torSwitches;
+    std::vector<switch_p> aggrSwitches; // k/2
+    std::vector<switch_p> torSwitches; // k/2
 
     Pod(pod_id_t id, FattreeTopology &parent) : parentTopo(parent){
         this->id = id;
+        this->aggrSwitches.resize(parent.k / 2);
+        this->torSwitches.resize(parent.k / 2);
     };
 
     void buildPod();
@@ -0,0 +1,320 @@
+#include <fstream>
+#include <cctype>
+#include <sstream>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <unordered_set>
+#include <stdexcept>
+#include <fmt/core.h>
+#include "simulation/config.hpp"
+#include "topology/file_topology.hpp"
+#include "utils/logger.hpp"
+#include "utils/utils.hpp"
+
+
+void CsrGraph::build(switch_id_t numSwitches, const std::vector<switch_link_t> &links){
+    this->offsets.assign((uint64_t)numSwitches + 1, 0);
+    for(auto it = links.begin(); it != links.end(); it++){
+        this->offsets[it->first + 1]++;
+        this->offsets[it->second + 1]++;
+    }
+
+    for(switch_id_t s = 0; s < numSwitches; s++){
+        if(this->offsets[s + 1] >= noNextHopPort){
+            std::string msg = fmt::format("Switch {} has {} links. At most {} are supported", s, this->offsets[s + 1], noNextHopPort - 1);
+            throw std::logic_error(msg);
+        }
+        this->offsets[s + 1] += this->offsets[s];
+    }
+
+    this->neighbors.resize(this->offsets[numSwitches]);
+    std::vector<uint64_t> next(this->offsets.begin(), this->offsets.end() - 1);
+    for(auto it = links.begin(); it != links.end(); it++){
+        this->neighbors[next[it->first]++] = it->second;
+        this->neighbors[next[it->second]++] = it->first;
+    }
+
+    for(switch_id_t s = 0; s < numSwitches; s++)
+        std::sort(this->neighbors.begin() + this->getRowBegin(s), this->neighbors.begin() + this->getRowEnd(s));
+}
+
+
+/*
+    Picks among the equal-cost next hops: round robin over the dst ToRs, so that every switch spreads them evenly over
+    its ports, rotated by the switch id like the FatTree routing. A ToR does not count itself, else e.g. on a leaf-spine
+    with 2 spines, (torIdx + switchId) % 2 would never be 0 for the ToR itself and spine 0 would take half of the traffic of spine 1.
+*/
+static inline uint64_t getEcmpPick(const NextHopTable &nextHops, switch_id_t switchId, switch_id_t dstTorIdx, uint64_t numCandidates){
+    switch_id_t ownTorIdx = nextHops.torIdx[switchId];
+    uint64_t dstRank = (ownTorIdx != noTorIdx && dstTorIdx > ownTorIdx) ? dstTorIdx - 1 : dstTorIdx;
+    return (dstRank + switchId) % numCandidates;
+}
+
+/* The first pair of ToRs without a path, if any, of the BFS of a thread */
+struct unreachableTors
+{
+    bool found = false;
+    switch_id_t src;
+    switch_id_t dst;
+};
+
+static void bfsFromTors(const CsrGraph &graph, NextHopTable &nextHops, const std::vector<switch_id_t> &tors, switch_id_t torBegin, switch_id_t torEnd, unreachableTors &unreachable){
+    const uint32_t notReached = std::numeric_limits<uint32_t>::max();
+    switch_id_t numSwitches = graph.getNumSwitches();
+    std::vector<uint32_t> dist(numSwitches);
+    std::vector<switch_id_t> queue(numSwitches);
+
+    for(switch_id_t t = torBegin; t < torEnd; t++){
+        std::fill(dist.begin(), dist.end(), notReached);
+        uint64_t head = 0, tail = 0;
+        dist[tors[t]] = 0;
+        queue[tail++] = tors[t];
+
+        while(head < tail){
+            switch_id_t s = queue[head++];
+            for(uint64_t i = graph.getRowBegin(s); i < graph.getRowEnd(s); i++){
+                switch_id_t n = graph.neighbors[i];
+                if(dist[n] == notReached){
+                    dist[n] = dist[s] + 1;
+                    queue[tail++] = n;
+                }
+            }
+        }
+
+        // Next hop of s: a neighbor one hop closer to the ToR
+        for(switch_id_t s = 0; s < numSwitches; s++){
+            if(dist[s] == notReached){
+                if(!unreachable.found && nextHops.torIdx[s] != noTorIdx){
+                    unreachable.found = true;
+                    unreachable.src = s;
+                    unreachable.dst = tors[t];
+                }
+                continue;
+            }
+            if(dist[s] == 0)
+                continue;
+
+            uint64_t begin = graph.getRowBegin(s), end = graph.getRowEnd(s);
+            uint64_t numCandidates = 0;
+            for(uint64_t i = begin; i < end; i++)
+                numCandidates += dist[graph.neighbors[i]] == dist[s] - 1;
+
+            uint64_t pick = getEcmpPick(nextHops, s, t, numCandidates);
+            for(uint64_t i = begin; i < end; i++){
+                if(dist[graph.neighbors[i]] == dist[s] - 1 && pick-- == 0){
+                    nextHops.ports[(uint64_t)s * nextHops.numTors + t] = i - begin;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void buildNextHopTable(const CsrGraph &graph, NextHopTable &nextHops, unsigned int numThreads){
+    nextHops.numSwitches = graph.getNumSwitches();
+    nextHops.ports.assign((uint64_t)nextHops.numSwitches * nextHops.numTors, noNextHopPort);
+
+    std::vector<switch_id_t> tors(nextHops.numTors); // by ToR index
+    for(switch_id_t s = 0; s < nextHops.numSwitches; s++){
+        if(nextHops.torIdx[s] != noTorIdx)
+            tors[nextHops.torIdx[s]] = s;
+    }
+
+    // One contiguous range of ToRs per thread, with the BFS arrays of its own
+    if(numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::max<unsigned int>(1, std::min<unsigned int>(numThreads, nextHops.numTors));
+    std::vector<unreachableTors> unreachable(numThreads);
+
+    parallelFor(numThreads, numThreads, [&graph, &nextHops, &tors, &unreachable, numThreads](uint64_t w){
+        switch_id_t torBegin = (uint64_t)nextHops.numTors * w / numThreads;
+        switch_id_t torEnd = (uint64_t)nextHops.numTors * (w + 1) / numThreads;
+        bfsFromTors(graph, nextHops, tors, torBegin, torEnd, unreachable[w]);
+    });
+
+    for(auto it = unreachable.begin(); it != unreachable.end(); it++){
+        if(it->found){
+            std::string msg = fmt::format("ToR switch {} has no path to ToR switch {}", it->src, it->dst);
+            throw std::logic_error(msg);
+        }
+    }
+}
+
+
+/* The contents of a topology file */
+struct topoFileContents
+{
+    std::vector<switch_link_t> links; // in file order, without duplicates
+    std::vector<switch_id_t> hostTors; // by host id
+    std::vector<bool> switchSeen; // by switch id
+};
+
+struct topoFileNode
+{
+    bool isHost;
+    uint64_t id;
+};
+
+static void badTopoLine(const std::string &path, unsigned int lineNum, const std::string &what){
+    std::string msg = fmt::format("Topology file {} line {}: {}", path, lineNum, what);
+    throw std::logic_error(msg);
+}
+
+static topoFileNode parseTopoNode(const std::string &token, const std::string &path, unsigned int lineNum){
+    topoFileNode node;
+    size_t end = 0;
+
+    if(token.size() < 2 || (token[0] != 'h' && token[0] != 's') || !std::isdigit(token[1]))
+        badTopoLine(path, lineNum, fmt::format("\"{}\" is neither a switch s<id> nor a host h<id>", token));
+
+    node.isHost = token[0] == 'h';
+    node.id = std::stoull(token.substr(1), &end);
+
+    // The largest id of both types stays free: it marks "none" (e.g. noTorIdx)
+    uint64_t maxId = node.isHost ? std::numeric_limits<host_id_t>::max() : std::numeric_limits<switch_id_t>::max();
+    if(end != token.size() - 1 || node.id >= maxId)
+        badTopoLine(path, lineNum, fmt::format("bad id \"{}\"", token));
+
+    return node;
+}
+
+static void addTopoEdge(topoFileContents &contents, std::unordered_set<uint64_t> &linkKeys, topoFileNode a, topoFileNode b, const std::string &path, unsigned int lineNum){
+    if(a.isHost && b.isHost)
+        badTopoLine(path, lineNum, "hosts connect to switches only");
+
+    if(a.isHost)
+        std::swap(a, b);
+
+    if(a.id >= contents.switchSeen.size())
+        contents.switchSeen.resize(a.id + 1, false);
+    contents.switchSeen[a.id] = true;
+
+    if(b.isHost){
+        if(b.id >= contents.hostTors.size())
+            contents.hostTors.resize(b.id + 1, noTorIdx);
+        if(contents.hostTors[b.id] != noTorIdx && contents.hostTors[b.id] != a.id)
+            badTopoLine(path, lineNum, fmt::format("host {} is already connected to switch {}", b.id, contents.hostTors[b.id]));
+        contents.hostTors[b.id] = a.id;
+        return;
+    }
+
+    if(a.id == b.id)
+        badTopoLine(path, lineNum, fmt::format("switch {} is linked to itself", a.id));
+
+    if(b.id >= contents.switchSeen.size())
+        contents.switchSeen.resize(b.id + 1, false);
+    contents.switchSeen[b.id] = true;
+
+    uint64_t key = (std::min(a.id, b.id) << 32) | std::max(a.id, b.id);
+    if(linkKeys.insert(key).second)
+        contents.links.push_back(switch_link_t(a.id, b.id));
+}
+
+static topoFileContents readTopologyFile(const std::string &path){
+    std::ifstream file(path);
+    if(!file.is_open()){
+        std::string msg = fmt::format("Could not open topology file {}", path);
+        throw std::logic_error(msg);
+    }
+
+    topoFileContents contents;
+    std::unordered_set<uint64_t> linkKeys;
+    std::string line;
+    unsigned int lineNum = 0;
+
+    while(std::getline(file, line)){
+        lineNum++;
+        std::istringstream tokens(line.substr(0, line.find('#')));
+        std::string first, token;
+        if(!(tokens >> first))
+            continue;
+
+        if(first.back() == ':'){ // adjacency
+            topoFileNode node = parseTopoNode(first.substr(0, first.size() - 1), path, lineNum);
+            if(!node.isHost){ // a switch without links is still a switch
+                if(node.id >= contents.switchSeen.size())
+                    contents.switchSeen.resize(node.id + 1, false);
+                contents.switchSeen[node.id] = true;
+            }
+            while(tokens >> token)
+                addTopoEdge(contents, linkKeys, node, parseTopoNode(token, path, lineNum), path, lineNum);
+        }
+        else{ // edge
+            if(!(tokens >> token))
+                badTopoLine(path, lineNum, "an edge needs two ends");
+            std::string extra;
+            if(tokens >> extra)
+                badTopoLine(path, lineNum, "an edge has two ends only. Adjacency lines start with \"<node>:\"");
+            addTopoEdge(contents, linkKeys, parseTopoNode(first, path, lineNum), parseTopoNode(token, path, lineNum), path, lineNum);
+        }
+    }
+
+    for(uint64_t s = 0; s < contents.switchSeen.size(); s++){
+        if(!contents.switchSeen[s]){
+            std::string msg = fmt::format("Topology file {}: switch {} is missing. Switch ids must be 0, 1, 2, ...", path, s);
+            throw std::logic_error(msg);
+        }
+    }
+    for(uint64_t h = 0; h < contents.hostTors.size(); h++){
+        if(contents.hostTors[h] == noTorIdx){
+            std::string msg = fmt::format("Topology file {}: host {} is missing. Host ids must be 0, 1, 2, ...", path, h);
+            throw std::logic_error(msg);
+        }
+    }
+
+    return contents;
+}
+
+
+void FileTopology::buildTopo(){
+    PhaseTimer build;
+
+    topoFileContents contents = readTopologyFile(this->path);
+    switch_id_t numSwitches = contents.switchSeen.size();
+    host_id_t numHosts = contents.hostTors.size();
+
+    if(numSwitches != syndbConfig.numSwitches || numHosts != syndbConfig.numHosts){
+        std::string msg = fmt::format("Topology file {} has {} switches and {} hosts. Set numSwitches = {} and numHosts = {} in the config (got {} and {})",
+            this->path, numSwitches, numHosts, numSwitches, numHosts, syndbConfig.numSwitches, syndbConfig.numHosts);
+        throw std::logic_error(msg);
+    }
+
+    // Ids follow the file: switches and hosts are created in id order
+    for(switch_id_t s = 0; s < numSwitches; s++)
+        this->createNewSwitch(SwitchType::Generic);
+    for(host_id_t h = 0; h < numHosts; h++)
+        this->createNewHost();
+
+    for(auto it = contents.links.begin(); it != contents.links.end(); it++)
+        this->connectSwitchToSwitch(this->switches[it->first], this->switches[it->second]);
+    for(host_id_t h = 0; h < numHosts; h++)
+        this->addHostToTor(this->hosts[h], this->switches[contents.hostTors[h]]);
+
+    this->graph.build(numSwitches, contents.links);
+
+    this->nextHops.torIdx.assign(numSwitches, noTorIdx);
+    for(switch_id_t s = 0; s < numSwitches; s++){
+        if(!this->switches[s]->neighborHostTable.empty())
+            this->nextHops.torIdx[s] = this->nextHops.numTors++;
+    }
+
+    build.endPhase("file");
+    buildNextHopTable(this->graph, this->nextHops, syndbConfig.numBuildThreads);
+    build.endPhase("next hop tables");
+
+    for(switch_id_t s = 0; s < numSwitches; s++){
+        SwitchGeneric* sw = static_cast<SwitchGeneric*>(this->switches[s].get());
+        sw->nextHops = &this->nextHops;
+        sw->hostTors = &this->hostTors;
+        for(uint64_t i = this->graph.getRowBegin(s); i < this->graph.getRowEnd(s); i++)
+            sw->ports.push_back(sw->getPortTo(this->switches[this->graph.neighbors[i]].get()));
+    }
+    build.endPhase("ports");
+
+    ndebug_print_yellow("Built Topo from file {}", this->path);
+    ndebug_print("Total Hosts: {}", this->hosts.size());
+    ndebug_print("Total Switches: {} (ToR: {}) | Links: {}", this->switches.size(), this->nextHops.numTors, contents.links.size());
+    ndebug_print("Next hop tables: {:.1f}MB", this->nextHops.ports.size() * sizeof(generic_port_t) / 1e6);
+    ndebug_print("Build: {}", build.format());
+}
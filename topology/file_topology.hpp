@@ -0,0 +1,58 @@
+#ifndef FILE_TOPOLOGY_H
+#define FILE_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "topology/topology.hpp"
+#include "topology/switch_generic.hpp"
+
+typedef std::pair<switch_id_t, switch_id_t> switch_link_t;
+
+/*
+    The switch-to-switch links in CSR form: the neighbors of switch s are neighbors[offsets[s], offsets[s + 1]), sorted by id.
+    The index of a neighbor within the row of s is the egress port of s towards it.
+*/
+struct CsrGraph
+{
+    std::vector<uint64_t> offsets; // numSwitches + 1
+    std::vector<switch_id_t> neighbors; // 2 per link
+
+    inline switch_id_t getNumSwitches() const { return this->offsets.size() - 1; };
+    inline uint64_t getRowBegin(switch_id_t s) const { return this->offsets[s]; };
+    inline uint64_t getRowEnd(switch_id_t s) const { return this->offsets[s + 1]; };
+
+    void build(switch_id_t numSwitches, const std::vector<switch_link_t> &links);
+};
+
+/*
+    Fills nextHops.ports (nextHops.torIdx given): the shortest paths towards every ToR, by one BFS from each ToR.
+    The BFS run on numThreads threads (0: one per core), each on a contiguous range of ToRs.
+    With several shortest paths, every switch spreads the dst ToRs evenly over its equal-cost ports.
+    Throws if a ToR cannot reach another one.
+*/
+void buildNextHopTable(const CsrGraph &graph, NextHopTable &nextHops, unsigned int numThreads);
+
+/*
+    A topology read from the file syndbConfig.topoFile, e.g. a leaf-spine or an oversubscribed Clos fabric.
+    Switches are s<id>, hosts h<id>, both with dense ids from 0. '#' starts a comment. Each line is either
+        an edge:        s0 s4    or    h3 s0
+        or adjacency:   s4: s0 s1 s2 s3
+    Links are bidirectional and listed once or twice. Every host connects to exactly one switch, its ToR.
+    numHosts and numSwitches must match the file: the dump files are opened before the topology is built.
+*/
+struct FileTopology : Topology
+{
+    std::string path;
+    CsrGraph graph;
+    NextHopTable nextHops;
+
+    // Override the virtual function of the abstract Topology class
+    void buildTopo();
+    inline FileTopology(const std::string &path):Topology(){
+        this->path = path;
+    }
+};
+
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef FTPATHS_H
+#define FTPATHS_H
+
+#include <vector>
+#include <stdexcept>
+#include <fmt/core.h>
+#include "utils/types.hpp"
+
+/*
+    Source routing on FatTrees: the egress ports of all hops of a pkt, packed into one ft_path_t.
+    Hop i is the i-th switch on the path (the src ToR is hop 0), its port is at bits [6i, 6i + 6).
+    At most 5 hops: ToR -> Aggr -> Core -> Aggr -> ToR. The last port is the one of the dst host on its ToR.
+    The port numbers are the ones of FattreeTopology::initPorts(), so they are < k, and k <= 64.
+
+    Header-only: the analysis binary uses the same paths.
+*/
+static const unsigned int ftPathPortBits = 6;
+static const unsigned int ftPathMaxHops = 5;
+static const unsigned int ftPathMaxK = 1 << ftPathPortBits;
+
+/*
+    The path of a pkt only depends on its src rack and dst host. The cache keeps one row of the paths to all hosts
+    per src rack, computed when the rack first asks for one. All hosts of a rack are in the partition of their ToR,
+    so each partition fills and reads its own rows without locks.
+    All rows together take (k^2 / 2) x (k^3 / 4) x 4B, e.g. 512KB for k=16 and 16MB for k=32.
+*/
+struct FtPathCache
+{
+    ft_scale_t k;
+    std::vector<std::vector<ft_path_t>> rows; // by src rack, then by dst host. Empty until first used
+
+    inline FtPathCache(ft_scale_t k){
+        this->k = k;
+        this->rows.resize((uint64_t)k * k / 2);
+    };
+
+    static inline ft_port_t getHopPort(ft_path_t path, unsigned int hop){
+        return (path >> (hop * ftPathPortBits)) & (ftPathMaxK - 1);
+    };
+
+    inline ft_path_t getPath(host_id_t srcRack, host_id_t dstHost){
+        std::vector<ft_path_t> &row = this->rows[srcRack];
+        if(row.empty())
+            this->fillRow(srcRack);
+        return row[dstHost];
+    };
+
+    /* Same ports as SwitchFtTorAggr::getUplinkPort() and SwitchFt{Aggr,Core}::getNextHopPort() */
+    ft_path_t computePath(host_id_t srcRack, host_id_t dstHost) const {
+        uint64_t halfK = this->k / 2;
+        uint64_t rackLocalId = dstHost % halfK;
+        uint64_t dstRack = dstHost / halfK;
+        ft_path_t path = 0;
+        unsigned int hop = 0;
+
+        auto addHop = [&path, &hop](uint64_t port){
+            path |= (ft_path_t)port << (hop * ftPathPortBits);
+            hop++;
+        };
+
+        if(srcRack != dstRack){
+            uint64_t aggrIdx = (rackLocalId + srcRack % halfK) % halfK;
+            addHop(halfK + aggrIdx); // src ToR: up
+
+            if(srcRack / halfK != dstRack / halfK){
+                addHop(halfK + (rackLocalId + aggrIdx) % halfK); // src Aggr: up
+                addHop(dstRack / halfK); // core: down to the dst pod
+            }
+            addHop(dstRack % halfK); // (dst) Aggr: down to the dst ToR
+        }
+        addHop(rackLocalId); // dst ToR: to the host
+
+        return path;
+    };
+
+    void fillRow(host_id_t srcRack){
+        if(this->k > ftPathMaxK){
+            std::string msg = fmt::format("FatTree paths only fit ports < {}. Got k={}", ftPathMaxK, this->k);
+            throw std::logic_error(msg);
+        }
+
+        uint64_t numHosts = (uint64_t)this->k * this->k * this->k / 4;
+        std::vector<ft_path_t> &row = this->rows[srcRack];
+        row.resize(numHosts);
+        for(uint64_t dstHost = 0; dstHost < numHosts; dstHost++)
+            row[dstHost] = this->computePath(srcRack, dstHost);
+    };
+
+    /* The ids of the switches on the path from srcHost to dstHost, src ToR first. Follows the ports like the pkts do. */
+    std::vector<switch_id_t> getSwitches(host_id_t srcHost, host_id_t dstHost){
+        uint64_t k = this->k;
+        uint64_t halfK = k / 2;
+        host_id_t srcRack = srcHost / halfK;
+        ft_path_t path = this->getPath(srcRack, dstHost);
+
+        std::vector<switch_id_t> switches;
+        uint64_t sw = (srcRack / halfK) * k + srcRack % halfK; // src ToR
+
+        for(unsigned int hop = 0; hop < ftPathMaxHops; hop++){
+            switches.push_back(sw);
+            uint64_t port = getHopPort(path, hop);
+
+            if(sw >= k * k) // core: to the Aggr with the same index as the core's Aggrs
+                sw = port * k + halfK + (sw - k * k) / halfK;
+            else if(sw % k < halfK){ // ToR
+                if(port < halfK)
+                    break; // to the dst host
+                sw = (sw / k) * k + port;
+            }
+            else if(port < halfK) // Aggr: down
+                sw = (sw / k) * k + port;
+            else // Aggr: up
+                sw = k * k + (sw % k - halfK) * halfK + (port - halfK);
+        }
+
+        return switches;
+    };
+};
+
+
+#endif
@@ -13,6 +13,12 @@ Host::Host(host_id_t id, bool disableTrafficGen){
     this->nextPkt = NULL;
     this->nextPktTime = 0;
     this->prevPktTime = 0;
+    this->partition = NULL;
+    this->schedulerIdx = Host::notScheduled;
+    this->descriptorRing = NULL;
+    #if PACKET_TRAINS
+    this->trainTail = NULL;
+    #endif
 
     this->id = id;
     this->trafficGenDisabled = disableTrafficGen;
@@ -23,7 +29,7 @@ Host::Host(host_id_t id, bool disableTrafficGen){
     else if (syndbConfig.trafficGenType == TrafficGenType::Distribution)
     {
         this->trafficGen = std::shared_ptr<TrafficGenerator>(new DcTrafficGenerator());
-        this->trafficGen->loadTrafficDistribution(syndbConfig.packetSizeDistFile, syndbConfig.flowArrivalDistFile);
+        this->trafficGen->loadTrafficDistribution(syndbConfig.packetSizeDistFile, syndbConfig.flowArrivalDistFile, this->id);
     }
 
     switch(syndbConfig.trafficPatternType){
@@ -47,17 +53,31 @@ Host::Host(host_id_t id, bool disableTrafficGen){
 }
 
 void Host::generateNextPkt(){
-    
+
+    #if PIPELINED_TRAFFIC_GEN
+    // Pktsize + delay + dstHost were generated ahead by the producer thread of this host
+    pktDescriptor desc;
+    syndbSim->trafficPipeline->pop(*this->descriptorRing, desc);
+    this->nextPktInfo.size = desc.size;
+    this->nextPktInfo.sendDelay = desc.sendDelay;
+
+    this->nextPkt = this->partition->getNewNormalPkt(this->nextPktInfo.size);
+    this->nextPkt->srcHost = this->id;
+    this->nextPkt->size = this->nextPktInfo.size;
+    this->nextPkt->dstHost = desc.dstHost;
+    #else
     // Get the pktsize + delay from the trafficGen
-    this->trafficGen->getNextPacket(this->nextPktInfo);
+    this->getNextPktInfo(this->nextPktInfo);
 
     // Construct a pkt
-    this->nextPkt = syndbSim.getNewNormalPkt(syndbSim.getNextPktId(), this->nextPktInfo.size);
+    this->nextPkt = this->partition->getNewNormalPkt(this->nextPktInfo.size);
     this->nextPkt->srcHost = this->id;
     this->nextPkt->size = this->nextPktInfo.size;
     // Get the dstHost from the TrafficPattern
-    this->nextPkt->dstHost = this->trafficPattern->applyTrafficPattern();
+    this->nextPkt->dstHost = this->getNextDstHost();
+    #endif
     this->prevPktTime = this->nextPktTime; // save curr next time to prev
+    this->partition->setPktId(this->nextPkt, this->prevPktTime);
     
     sim_time_t pktGenSendTime = this->nextPktTime + this->nextPktInfo.sendDelay;
     sim_time_t nextPktSerializeStart = std::max<sim_time_t>(pktGenSendTime, this->torLink->next_idle_time_to_tor);
@@ -87,11 +107,15 @@ void Host::sendPkt(normalpkt_p &nextPkt, sim_time_t nextPktTime){
     // For quick testing of AlltoAll traffic pattern
     // ndebug_print("sendPkt(): {} --> {}", this->id, nextPkt->dstHost);
 
+    #if SOURCE_ROUTING
+    nextPkt->path = static_cast<SwitchFtTor*>(this->torSwitch)->getPath(nextPkt->dstHost);
+    #endif
+
     // Step 1: Pass the pkt to ToR for its own processing
     this->torSwitch->receiveNormalPkt(nextPkt, nextPktTime); // can parallelize switch's processing?
 
     // Step 2: Call the routing + scheduling on the ToR switch to get rsinfo
-    syndb_status_t s = this->torSwitch->routeScheduleNormalPkt(nextPkt, nextPktTime, rsinfo); 
+    syndb_status_t s = routeScheduleNormalPktOn(this->torSwitch, nextPkt, nextPktTime, rsinfo);
 
     if(s != syndb_status_t::success){
         std::string msg = fmt::format("Host {} failed to send Pkt to host {} since routing on the ToR failed!", this->id, nextPkt->dstHost);
@@ -100,13 +124,17 @@ void Host::sendPkt(normalpkt_p &nextPkt, sim_time_t nextPktTime){
 
     // Create, fill and add a new normal pkt event
     // pktevent_p<normalpkt_p> newPktEvent = pktevent_p<normalpkt_p>(new PktEvent<normalpkt_p>());
-    pktevent_p<normalpkt_p> newPktEvent = syndbSim.getNewNormalPktEvent();
+    pktevent_p<normalpkt_p> newPktEvent = this->partition->getNewNormalPktEvent();
     newPktEvent->pkt = nextPkt;
     newPktEvent->pktForwardTime = rsinfo.pktNextForwardTime;
     newPktEvent->currSwitch = this->torSwitch;
     newPktEvent->nextSwitch = rsinfo.nextSwitch;
 
-    syndbSim.NormalPktEventList.push_front(newPktEvent);
+    #if PACKET_TRAINS
+    this->partition->addNormalPktEventToTrain(newPktEvent, this->trainTail);
+    #else
+    this->partition->addNormalPktEvent(newPktEvent);
+    #endif
 
 }
 
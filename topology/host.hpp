@@ -7,12 +7,14 @@
 #include "topology/switch.hpp"
 #include "traffic/trafficGenerator.hpp"
 #include "traffic/trafficPattern.hpp"
+#include "traffic/trafficPipeline.hpp"
+#include "simulation/config.hpp"
 
 /* Host struct */
 typedef struct Host
 {
     host_id_t id;
-    host_tor_link_p torLink;
+    HostTorLink* torLink;
     Switch* torSwitch;
 
     packetInfo nextPktInfo;
@@ -23,6 +25,13 @@ typedef struct Host
     std::shared_ptr<TrafficGenerator> trafficGen;
     std::shared_ptr<TrafficPattern> trafficPattern;
     bool trafficGenDisabled;
+    SimPartition* partition; // engine state this host belongs to
+    size_t schedulerIdx; // position in partition->hostScheduler
+    PktDescriptorRing* descriptorRing; // PIPELINED_TRAFFIC_GEN: the next pkts, generated ahead by a producer thread
+    static const size_t notScheduled = (size_t)-1;
+    #if PACKET_TRAINS
+    PktEvent<normalpkt_p>* trainTail; // the event of the last pkt sent (events are pooled, never freed during the run). The next pkt joins its train if they share the hop.
+    #endif
 
     Host(host_id_t id, bool disableTrafficGen = false);
     ~Host();
@@ -30,6 +39,23 @@ typedef struct Host
     void generateNextPkt();
     void sendPkt(normalpkt_p &nextPkt, sim_time_t nextPktTime);
 
+    /* The per-pkt calls into the traffic generator and pattern. SPECIALIZED_FATTREE: direct calls to the (final) Distribution and FtMixed classes. */
+    inline void getNextPktInfo(packetInfo &pktInfo){
+        #if SPECIALIZED_FATTREE
+        static_cast<DcTrafficGenerator*>(this->trafficGen.get())->getNextPacket(pktInfo);
+        #else
+        this->trafficGen->getNextPacket(pktInfo);
+        #endif
+    };
+
+    inline host_id_t getNextDstHost(){
+        #if SPECIALIZED_FATTREE
+        return static_cast<FtMixedTrafficPattern*>(this->trafficPattern.get())->applyTrafficPattern();
+        #else
+        return this->trafficPattern->applyTrafficPattern();
+        #endif
+    };
+
 } Host;
 
 typedef std::shared_ptr<Host> host_p;
@@ -9,12 +9,13 @@ Link::Link(link_id_t id, link_speed_gbps_t speed) {
 
 NetworkLink::NetworkLink(link_id_t id, link_speed_gbps_t speed, switch_id_t sw1, switch_id_t sw2) : Link::Link(id, speed){
 
-    this->next_idle_time[sw1] = 0;
-    this->next_idle_time[sw2] = 0;
-    this->next_idle_time_priority[sw1] = 0;
-    this->next_idle_time_priority[sw2] = 0;
-    this->byte_count[sw1] = 0;
-    this->byte_count[sw2] = 0;
+    this->queues[0].dstSwitchId = sw2;
+    this->queues[1].dstSwitchId = sw1;
+    for(int i = 0; i < 2; i++){
+        this->queues[i].nextIdleTime = 0;
+        this->queues[i].nextIdleTimePriority = 0;
+        this->queues[i].byteCount = 0;
+    }
 }
 
 
@@ -3,7 +3,6 @@
 
 #include <cstdint>
 #include <memory>
-#include <unordered_map>
 #include "utils/types.hpp"
 
 /* Link struct */
@@ -16,15 +15,27 @@ typedef struct Link
     Link(link_id_t id, link_speed_gbps_t speed);
 } Link;
 
+/* The queues of a NetworkLink in one direction */
+struct linkQueue
+{
+    switch_id_t dstSwitchId; // the switch at the far end
+    sim_time_t nextIdleTime; // normal pkts
+    sim_time_t nextIdleTimePriority; // trigger pkts
+    byte_count_t byteCount;
+};
+
 /* NetworkLink struct */
 typedef struct NetworkLink : Link
 {
-    std::unordered_map<switch_id_t, sim_time_t> next_idle_time;
-    std::unordered_map<switch_id_t, sim_time_t> next_idle_time_priority;
-    std::unordered_map<switch_id_t, byte_count_t> byte_count;
+    linkQueue queues[2]; // sw1 -> sw2 | sw2 -> sw1
 
+    NetworkLink() = default; // preallocated slot, see Topology::placeNetworkLink()
     NetworkLink(link_id_t id, link_speed_gbps_t speed, switch_id_t sw1, switch_id_t sw2);
 
+    inline linkQueue& getQueueTowards(switch_id_t dstSwitchId){
+        return this->queues[this->queues[0].dstSwitchId == dstSwitchId ? 0 : 1];
+    };
+
 } NetworkLink;
 
 typedef struct HostTorLink : Link
@@ -34,11 +45,9 @@ typedef struct HostTorLink : Link
     byte_count_t byte_count_to_tor;
     byte_count_t byte_count_to_host;
 
+    HostTorLink() = default;
     HostTorLink(link_id_t id, link_speed_gbps_t speed);
 } HostTorLink;
 
-/* Shared pointer to a Link struct object */
-typedef std::shared_ptr<NetworkLink> network_link_p;
-typedef std::shared_ptr<HostTorLink> host_tor_link_p;
 
 #endif
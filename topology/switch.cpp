@@ -12,11 +12,12 @@
 
 Switch::Switch(switch_id_t id){
     this->id = id;
+    this->partition = NULL;
     this->hop_delay = syndbConfig.switchHopDelayNs;
 
     #if HOP_DELAY_NOISE
     this->hop_delay_variation = syndbConfig.maxSwitchHopDelayNs - syndbConfig.minSwitchHopDelayNs;
-    uint64_t seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed = getRandomSeed(RandomStream::SwitchHopDelay, this->id);
     this->randHopDelay = std::default_random_engine(seed);
     #endif
 }
@@ -65,15 +66,16 @@ syndb_status_t Switch::scheduleToNextHopSwitch(const pkt_size_t pktsize, const s
         nextLink = search->second;
         
         // Choose different queues on the nextLink based on the packet type
+        linkQueue &queue = nextLink->getQueueTowards(nextHopSwitch->id);
         if(ptype == PacketType::NormalPkt){
             // Schedule on the normal queue
-            schedulePkt(pktsize, pktArrivalTime, nextLink->speed, nextLink->next_idle_time[nextHopSwitch->id], nextLink->byte_count[nextHopSwitch->id]);
-            rsinfo.pktNextForwardTime = nextLink->next_idle_time[nextHopSwitch->id];
+            schedulePkt(pktsize, pktArrivalTime, nextLink->speed, queue.nextIdleTime, queue.byteCount);
+            rsinfo.pktNextForwardTime = queue.nextIdleTime;
         }
         else if (ptype == PacketType::TriggerPkt){
             // Schedule on the priority queue
-            schedulePkt(pktsize, pktArrivalTime, nextLink->speed, nextLink->next_idle_time_priority[nextHopSwitch->id], nextLink->byte_count[nextHopSwitch->id]);
-            rsinfo.pktNextForwardTime = nextLink->next_idle_time_priority[nextHopSwitch->id];
+            schedulePkt(pktsize, pktArrivalTime, nextLink->speed, queue.nextIdleTimePriority, queue.byteCount);
+            rsinfo.pktNextForwardTime = queue.nextIdleTimePriority;
         }
 
         rsinfo.nextSwitch = nextHopSwitch;
@@ -90,10 +92,24 @@ syndb_status_t Switch::scheduleToNextHopSwitch(const pkt_size_t pktsize, const s
 }
 
 
+switchPort Switch::getPortTo(Switch* nextSwitch){
+    NetworkLink* link = this->neighborSwitchTable.at(nextSwitch->id);
+
+    switchPort port;
+    port.nextSwitch = nextSwitch;
+    port.queue = &link->getQueueTowards(nextSwitch->id);
+    port.speed = link->speed;
+    return port;
+}
+
 void Switch::schedulePkt(const pkt_size_t pktsize, const sim_time_t pktArrivalTime, const link_speed_gbps_t linkSpeed, sim_time_t &qNextIdleTime, byte_count_t &byteCount){
     
     sim_time_t pktSendTime, timeAfterSwitchHop, pktNextSerializeStartTime, hopDelay; 
 
+    #if OPTIMISTIC_ENGINE
+    this->partition->saveQueueState(this, qNextIdleTime, byteCount); // for rollbacks
+    #endif
+
     #if HOP_DELAY_NOISE
     hopDelay = this->getRandomHopDelay();
     #else
@@ -162,7 +178,7 @@ void Switch::receiveTriggerPkt(triggerpkt_p pkt, sim_time_t rxTime){
     this->triggerHistory.insert(pkt->triggerId); 
 
     // Logging the triggerInfo
-    syndbSim.TriggerInfoMap[pkt->triggerId].rxSwitchTimes[this->id] = rxTime;
+    this->partition->logTriggerRx(pkt->triggerId, this->id, rxTime);
 
     // Flush the current RingBuffer
     #if RING_BUFFER
@@ -171,6 +187,8 @@ void Switch::receiveTriggerPkt(triggerpkt_p pkt, sim_time_t rxTime){
 
     // Broadcast forward to neighbors with source pruning
     switch_id_t srcSwitch = pkt->srcSwitchId;
+    std::vector<PktEvent<triggerpkt_p>> &batch = this->partition->triggerPktBatch;
+    batch.clear();
 
     auto it2 = this->neighborSwitchTable.begin();
     for(it2; it2 != this->neighborSwitchTable.end(); it2++){
@@ -180,10 +198,13 @@ void Switch::receiveTriggerPkt(triggerpkt_p pkt, sim_time_t rxTime){
 
         dstSwitchId = it2->first;
         // debug_print("Fowarding to neighbor switch {}", dstSwitchId); 
-        this->createSendTriggerPkt(dstSwitchId, pkt->triggerId, pkt->triggerOriginSwId, pkt->triggerTime, rxTime);
+        this->createTriggerPktEvent(dstSwitchId, pkt->triggerId, pkt->triggerOriginSwId, pkt->triggerTime, rxTime, batch);
 
     }
 
+    // Enqueue all the neighbor copies in one go
+    this->partition->addTriggerPktEvents(batch);
+
 }
 
 void Switch::generateTrigger(){
@@ -192,36 +213,46 @@ void Switch::generateTrigger(){
     switch_id_t dstSwitchId;
     routeScheduleInfo rsinfo;
 
-    newTriggerId = syndbSim.getNextTriggerPktId();
+    newTriggerId = syndbSim->getNextTriggerPktId();
 
     this->triggerHistory.insert(newTriggerId); // this switch has already seen this triggerPkt
 
-    // debug_print_yellow("Generating Trigger {} on switch {} at time {}:", newTriggerId, this->id, syndbSim.currTime);
+    // debug_print_yellow("Generating Trigger {} on switch {} at time {}:", newTriggerId, this->id, syndbSim->currTime);
 
     // Create and add TriggerInfo to TriggerInfoMap
     triggerInfo newTriggerInfo;
     newTriggerInfo.originSwitch = this->id;
-    newTriggerInfo.triggerOrigTime = syndbSim.currTime;
-    syndbSim.TriggerInfoMap[newTriggerId] = newTriggerInfo;
+    newTriggerInfo.triggerOrigTime = syndbSim->currTime;
+    syndbSim->TriggerInfoMap[newTriggerId] = newTriggerInfo;
 
+    #if ANALYTICAL_TRIGGER_FLOOD
+    syndbSim->triggerGen->flood.sendCopies(this, newTriggerId, this->id, syndbSim->currTime); // no neighbor is this switch: no pruning
+    #else
     // Iterate over the neighbors and schedule a triggerPkt for each neighbor
+    std::vector<PktEvent<triggerpkt_p>> &batch = this->partition->triggerPktBatch;
+    batch.clear();
+
     auto it = this->neighborSwitchTable.begin();
 
     for(it; it != this->neighborSwitchTable.end(); it++){
 
         dstSwitchId = it->first;
 
-        this->createSendTriggerPkt(dstSwitchId, newTriggerId, this->id, syndbSim.currTime, syndbSim.currTime); // when generating, the pktArrivalTime is syndbSim.currTime
+        this->createTriggerPktEvent(dstSwitchId, newTriggerId, this->id, syndbSim->currTime, syndbSim->currTime, batch); // when generating, the pktArrivalTime is syndbSim->currTime
     }
 
+    this->partition->addTriggerPktEvents(batch);
+    #endif
+
 }
 
-void Switch::createSendTriggerPkt(switch_id_t dstSwitchId, trigger_id_t triggerId, switch_id_t originSwitchId, sim_time_t origTriggerTime, sim_time_t pktArrivalTime){
+/* Creates a (pooled) trigger pkt for the neighbor dstSwitchId, schedules it and appends its event to batch */
+void Switch::createTriggerPktEvent(switch_id_t dstSwitchId, trigger_id_t triggerId, switch_id_t originSwitchId, sim_time_t origTriggerTime, sim_time_t pktArrivalTime, std::vector<PktEvent<triggerpkt_p>> &batch){
 
     syndb_status_t status;
     routeScheduleInfo rsinfo;
 
-    triggerpkt_p newTriggerPkt = triggerpkt_p(new TriggerPkt(triggerId, syndbConfig.triggerPktSize)); 
+    triggerpkt_p newTriggerPkt = this->partition->triggerPktPool.getNewTriggerPkt(triggerId, syndbConfig.triggerPktSize); 
     newTriggerPkt->srcSwitchId = this->id;
     newTriggerPkt->dstSwitchId = dstSwitchId; // neighbor switch ID
     newTriggerPkt->triggerOriginSwId = originSwitchId;
@@ -238,21 +269,20 @@ void Switch::createSendTriggerPkt(switch_id_t dstSwitchId, trigger_id_t triggerI
     }
     
 
-    // Create, fill and add a new trigger pkt event
-    pktevent_p<triggerpkt_p> newEvent = pktevent_p<triggerpkt_p>(new PktEvent<triggerpkt_p>);
-
-    newEvent->pkt = newTriggerPkt;
-    newEvent->pktForwardTime = rsinfo.pktNextForwardTime;
-    newEvent->currSwitch = syndbSim.topo->getSwitchById(this->id); 
-    newEvent->nextSwitch = rsinfo.nextSwitch;
+    // Create, fill and add a new trigger pkt event to the batch
+    batch.emplace_back();
+    PktEvent<triggerpkt_p> &newEvent = batch.back();
 
-    syndbSim.TriggerPktEventList.push_back(newEvent);
+    newEvent.pkt = newTriggerPkt;
+    newEvent.pktForwardTime = rsinfo.pktNextForwardTime;
+    newEvent.currSwitch = this; 
+    newEvent.nextSwitch = rsinfo.nextSwitch;
 }
 
 syndb_status_t Switch::routeScheduleTriggerPkt(triggerpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo) {
     Switch* nextHopSwitch;
 
-    nextHopSwitch = syndbSim.topo->getSwitchById(pkt->dstSwitchId); // since triggerPkts sent to neighbors only
+    nextHopSwitch = syndbSim->topo->getSwitchById(pkt->dstSwitchId); // since triggerPkts sent to neighbors only
 
     return this->scheduleToNextHopSwitch(pkt->size, pktArrivalTime, nextHopSwitch, rsinfo, PacketType::TriggerPkt);
 }
@@ -277,7 +307,7 @@ syndb_status_t SimpleSwitch::routeScheduleNormalPkt(normalpkt_p &pkt, const sim_
 
     switch_id_t dstTorId;
 
-    dstTorId = syndbSim.topo->getTorId(pkt->dstHost);
+    dstTorId = syndbSim->topo->getTorId(pkt->dstHost);
     
     if(dstTorId == this->id){ // intra-rack routing
         return this->intraRackRouteNormalPkt(pkt, pktArrivalTime, rsinfo); 
@@ -303,7 +333,7 @@ Switch* SimpleSwitch::getNextHop(switch_id_t dstSwitchId){
     if(it != this->neighborSwitchTable.end()){ // dst switch is a neighbor
         // So it itself is the nextHop
         // simply return the shared_pointer to the dstSwitchId 
-        return syndbSim.topo->getSwitchById(dstSwitchId); 
+        return syndbSim->topo->getSwitchById(dstSwitchId); 
     }
 
     // Not a neighbor. Now refer to the routing table.
@@ -316,7 +346,7 @@ Switch* SimpleSwitch::getNextHop(switch_id_t dstSwitchId){
         nextHopSwitchId = it1->second;
         
         // Simply return the pointer to the nextHopSwitch
-        return syndbSim.topo->getSwitchById(nextHopSwitchId);
+        return syndbSim->topo->getSwitchById(nextHopSwitchId);
 
     }
     else // Err No known route to dst ToR
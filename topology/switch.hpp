@@ -2,6 +2,7 @@
 #define SWITCH_H
 
 #include <memory>
+#include <vector>
 #include <random>
 #include <unordered_map>
 #include <set>
@@ -16,7 +17,7 @@
 typedef std::unordered_map<switch_id_t, NetworkLink*> neighbor_switch_table_t;
 typedef std::unordered_map<host_id_t, HostTorLink*> neighbor_host_table_t;
 
-enum class SwitchType {Simple, FtTor, FtAggr, FtCore};
+enum class SwitchType {Simple, FtTor, FtAggr, FtCore, Generic};
 
 inline std::string switchTypeToString(SwitchType type){
     switch(type){
@@ -32,6 +33,9 @@ inline std::string switchTypeToString(SwitchType type){
         case SwitchType::FtCore:
             return "Core";
             break;
+        case SwitchType::Generic:
+            return "Generic";
+            break;
         default:
             std::string msg = fmt::format("Unknown SwitchType {}", type);
             throw std::logic_error(msg);
@@ -39,6 +43,9 @@ inline std::string switchTypeToString(SwitchType type){
 }
 
 struct routeScheduleInfo;
+struct switchPort;
+struct SimPartition;
+template<typename T> struct PktEvent;
 
 struct Switch;
 typedef std::shared_ptr<Switch> switch_p;
@@ -54,6 +61,7 @@ struct Switch
     neighbor_switch_table_t neighborSwitchTable;
     neighbor_host_table_t neighborHostTable;
     std::default_random_engine randHopDelay;
+    SimPartition* partition; // engine state this switch belongs to
 
     /* SyNDB specific members */
     #if RING_BUFFER
@@ -66,7 +74,7 @@ struct Switch
     void receiveNormalPkt(normalpkt_p pkt, sim_time_t rxTime);
     void receiveTriggerPkt(triggerpkt_p pkt, sim_time_t rxTime);
     void generateTrigger();
-    void createSendTriggerPkt(switch_id_t dstSwitchId, trigger_id_t triggerId, switch_id_t originSwitchId, sim_time_t origTriggerTime, sim_time_t pktArrivalTime);
+    void createTriggerPktEvent(switch_id_t dstSwitchId, trigger_id_t triggerId, switch_id_t originSwitchId, sim_time_t origTriggerTime, sim_time_t pktArrivalTime, std::vector<PktEvent<triggerpkt_p>> &batch);
     void snapshotRingBuffer(sim_time_t triggerPktRcvTime);
 
     /* Fills rinfo. Returns Success or Failure */
@@ -77,6 +85,7 @@ struct Switch
     /* Inter-switch scheduling  */ 
     syndb_status_t scheduleToNextHopSwitch(const pkt_size_t pktsize, const sim_time_t pktArrivalTime, Switch* nextHopSwitch, routeScheduleInfo &rsinfo, PacketType ptype);
     void schedulePkt(const pkt_size_t pktsize, const sim_time_t pktArrivalTime, const link_speed_gbps_t linkSpeed, sim_time_t &qNextIdleTime, byte_count_t &byte_count);
+    switchPort getPortTo(Switch* nextSwitch); // nextSwitch must be a neighbor
 
     sim_time_t getRandomHopDelay();
     
@@ -86,7 +95,7 @@ struct Switch
 
 };
 
-struct SimpleSwitch : Switch{
+struct SimpleSwitch final : Switch{
 
     std::unordered_map<switch_id_t, switch_id_t> routingTable;
 
@@ -106,4 +115,22 @@ struct routeScheduleInfo
     sim_time_t pktNextForwardTime;
 };
 
+/* An egress port towards another switch. Points to the queue of the link in that direction. */
+struct switchPort
+{
+    Switch* nextSwitch;
+    linkQueue* queue; // &link->getQueueTowards(nextSwitch->id)
+    link_speed_gbps_t speed;
+};
+
+/* Schedules a normal pkt on the queue of an egress port */
+inline syndb_status_t scheduleToPort(Switch* sw, const switchPort &port, const pkt_size_t pktsize, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
+    sw->schedulePkt(pktsize, pktArrivalTime, port.speed, port.queue->nextIdleTime, port.queue->byteCount);
+
+    rsinfo.nextSwitch = port.nextSwitch;
+    rsinfo.pktNextForwardTime = port.queue->nextIdleTime;
+
+    return syndb_status_t::success;
+}
+
 #endif
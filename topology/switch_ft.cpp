@@ -8,7 +8,7 @@ Switch* SwitchFtTorAggr::getNextHop(host_id_t dstHostId){
     racklocal_host_id_t rackLocalHostId;
     Switch* nextHopSwitch;
 
-    rackLocalHostId = dstHostId % (this->fatTreeScaleK / 2);
+    rackLocalHostId = ftModHalfK(dstHostId, this->fatTreeScaleK);
 
     auto it = this->routingTable.find(rackLocalHostId);
 
@@ -19,60 +19,33 @@ Switch* SwitchFtTorAggr::getNextHop(host_id_t dstHostId){
     }
 
     nextHopSwitchId = it->second; 
-    nextHopSwitch = syndbSim.topo->getSwitchById(nextHopSwitchId);
+    nextHopSwitch = syndbSim->topo->getSwitchById(nextHopSwitchId);
 
     return nextHopSwitch;
 }
 
 syndb_status_t SwitchFtTor::routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
 
-    switch_id_t dstTorId;
-
-    dstTorId = syndbSim.topo->getTorId(pkt->dstHost);
-    
-    if(dstTorId == this->id){ // intra-rack routing
-        return this->intraRackRouteNormalPkt(pkt, pktArrivalTime, rsinfo); 
-    } // end of intra-rack routing case
+    if(ftGetRackId(pkt->dstHost, this->fatTreeScaleK) == this->rackId){ // intra-rack routing
+        return this->scheduleToHostPort(ftModHalfK(pkt->dstHost, this->fatTreeScaleK), pkt->size, pktArrivalTime, rsinfo);
+    }
     else // inter-rack routing
     {
-        Switch* nextHopSwitch;
-        nextHopSwitch = this->getNextHop(pkt->dstHost);
-
-        // call the switch-to-switch scheduling since we know the nextHopSwitch
-        return this->scheduleToNextHopSwitch(pkt->size, pktArrivalTime, nextHopSwitch, rsinfo, PacketType::NormalPkt);
-
+        return scheduleToPort(this, this->ports[this->getUplinkPort(pkt->dstHost)], pkt->size, pktArrivalTime, rsinfo);
     }
 }
 
 
 syndb_status_t SwitchFtAggr::routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
-    switch_id_t dstTorId;
-    Switch* nextHopSwitch;
-    dstTorId = syndbSim.topo->getTorId(pkt->dstHost);
-
-    // find if dstTor is in the neighbors (if intra-pod routing)
-    auto it = this->neighborSwitchTable.find(dstTorId);
-    if(it != this->neighborSwitchTable.end()){ // intra-pod routing
-        nextHopSwitch = syndbSim.topo->getSwitchById(dstTorId);
-    }
-    else // inter-pod routing. Send to the uplink core
-    {
-        // Get the uplink core switch from the routing table
-        nextHopSwitch = this->getNextHop(pkt->dstHost);
-    }
-
-    // call the switch-to-switch scheduling since we know the nextHopSwitch
-    return this->scheduleToNextHopSwitch(pkt->size, pktArrivalTime, nextHopSwitch, rsinfo, PacketType::NormalPkt);
-
+    return scheduleToPort(this, this->ports[this->getNextHopPort(pkt->dstHost)], pkt->size, pktArrivalTime, rsinfo);
 }
 
 
 Switch* SwitchFtCore::getNextHop(host_id_t dstHostId){
     Switch* nextHopSwitch;
     pod_id_t podId;
-    ft_scale_t kBy2 = this->fatTreeScaleK / 2;
     
-    podId = dstHostId / (kBy2 * kBy2);
+    podId = ftGetPodId(dstHostId, this->fatTreeScaleK);
 
     auto it = this->routingTable.find(podId);
 
@@ -82,18 +55,12 @@ Switch* SwitchFtCore::getNextHop(host_id_t dstHostId){
     }
     
     // it->second is the aggr switch id
-    nextHopSwitch = syndbSim.topo->getSwitchById(it->second);
+    nextHopSwitch = syndbSim->topo->getSwitchById(it->second);
 
     return nextHopSwitch;   
 
 }
 
 syndb_status_t SwitchFtCore::routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
-
-    Switch* nextHopSwitch;
-    nextHopSwitch = this->getNextHop(pkt->dstHost);
-
-    // call the switch-to-switch scheduling since we know the nextHopSwitch
-    return this->scheduleToNextHopSwitch(pkt->size, pktArrivalTime, nextHopSwitch, rsinfo, PacketType::NormalPkt);
-
+    return scheduleToPort(this, this->ports[this->getNextHopPort(pkt->dstHost)], pkt->size, pktArrivalTime, rsinfo);
 }
@@ -2,6 +2,59 @@
 #define FTSWITCHES_H
 
 #include "topology/switch.hpp"
+#include "simulation/config.hpp"
+#include "topology/ft_paths.hpp"
+
+/*
+    The FatTree divisions of the routing hot path: by k/2 (hosts per rack) and by (k/2)^2 (hosts per pod).
+    k is a runtime param, so the common values of k get a case of their own with a compile-time divisor,
+    which the compiler turns into a multiply and shift. Any other k takes a real division.
+*/
+template<ft_scale_t K>
+struct FtFixedScale
+{
+    template<typename T>
+    static inline T modHalfK(T x){ return x % (K / 2); };
+    static inline pod_id_t getPodId(host_id_t hostId){ return hostId / ((K / 2) * (K / 2)); };
+    static inline host_id_t getRackId(host_id_t hostId){ return hostId / (K / 2); };
+};
+
+#define FT_COMMON_SCALES(CALL) \
+    case 4: return FtFixedScale<4>::CALL; \
+    case 8: return FtFixedScale<8>::CALL; \
+    case 16: return FtFixedScale<16>::CALL; \
+    case 24: return FtFixedScale<24>::CALL; \
+    case 32: return FtFixedScale<32>::CALL; \
+    case 48: return FtFixedScale<48>::CALL;
+
+template<typename T>
+inline T ftModHalfK(T x, ft_scale_t k){
+    switch(k){
+        FT_COMMON_SCALES(modHalfK(x))
+        default: return x % (k / 2);
+    }
+}
+
+inline pod_id_t ftGetPodId(host_id_t hostId, ft_scale_t k){
+    switch(k){
+        FT_COMMON_SCALES(getPodId(hostId))
+        default: return hostId / ((k / 2) * (k / 2));
+    }
+}
+
+/* The rack (= index of the ToR among all ToRs) of a host */
+inline host_id_t ftGetRackId(host_id_t hostId, ft_scale_t k){
+    switch(k){
+        FT_COMMON_SCALES(getRackId(hostId))
+        default: return hostId / (k / 2);
+    }
+}
+
+/*
+    Closed-form FatTree routing: the egress port follows from the dst host id and the position of the switch,
+    in a few integer ops. See FattreeTopology::initPorts() for the port numbers.
+    The routingTables give the same next hops. They are kept as the reference (see devtests).
+*/
 
 
 /* Abstract class for common implementations between ToR/Aggr switches */
@@ -12,9 +65,16 @@ struct SwitchFtTorAggr : Switch
     // For ToR: <racklocalhost_id, aggr switch_id>
     // For Aggr: <racklocalhost_id, core switch_id>
     std::unordered_map<racklocal_host_id_t, switch_id_t> routingTable; 
+    ft_scale_t podLocalIdx; // index among the ToRs / Aggrs of the pod
+    std::vector<switchPort> ports; // [0, k/2): down (ToR: unused), [k/2, k): up
 
     /* Functions specific to ToR/Aggr switch's routing */
-    Switch* getNextHop(host_id_t dstHostId);
+    Switch* getNextHop(host_id_t dstHostId); // table-driven
+
+    /* Up: spread by the rack-local id of the dst host, shifted by the position of the switch in the pod */
+    inline ft_port_t getUplinkPort(host_id_t dstHostId){
+        return this->fatTreeScaleK / 2 + ftModHalfK<unsigned int>(ftModHalfK(dstHostId, this->fatTreeScaleK) + this->podLocalIdx, this->fatTreeScaleK);
+    };
 
     inline SwitchFtTorAggr(switch_id_t id) : Switch(id){
         this->fatTreeScaleK = syndbConfig.fatTreeTopoK;
@@ -22,17 +82,36 @@ struct SwitchFtTorAggr : Switch
 };
 
 
-struct SwitchFtTor : SwitchFtTorAggr
+struct SwitchFtTor final : SwitchFtTorAggr
 {
+    host_id_t rackId;
+    std::vector<HostTorLink*> hostPorts; // by rack-local host id
+    FtPathCache* pathCache;
+
     // resuse constructor of the base class
     using SwitchFtTorAggr::SwitchFtTorAggr;
 
+    /* SOURCE_ROUTING: the path of a pkt from this rack */
+    inline ft_path_t getPath(host_id_t dstHostId){
+        return this->pathCache->getPath(this->rackId, dstHostId);
+    };
+
+    inline syndb_status_t scheduleToHostPort(racklocal_host_id_t rackLocalHostId, const pkt_size_t pktsize, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
+        HostTorLink* hostTorLink = this->hostPorts[rackLocalHostId];
+        this->schedulePkt(pktsize, pktArrivalTime, hostTorLink->speed, hostTorLink->next_idle_time_to_host, hostTorLink->byte_count_to_host);
+
+        rsinfo.nextSwitch = NULL; // next hop is a host
+        rsinfo.pktNextForwardTime = hostTorLink->next_idle_time_to_host;
+
+        return syndb_status_t::success;
+    };
+
     /* Overriding the virtual function of the base class */
     syndb_status_t routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo);
     
 };
 
-struct SwitchFtAggr : SwitchFtTorAggr
+struct SwitchFtAggr final : SwitchFtTorAggr
 {
     std::vector<switch_id_t> coreSwitchesList;
     // resuse constructor of the base class
@@ -41,19 +120,30 @@ struct SwitchFtAggr : SwitchFtTorAggr
     /* Overriding the virtual function of the base class */
     syndb_status_t routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo);
 
+    /* Down to the dst ToR if it is in this pod, else up */
+    inline ft_port_t getNextHopPort(host_id_t dstHostId){
+        if(ftGetPodId(dstHostId, this->fatTreeScaleK) == this->podId)
+            return ftModHalfK(ftGetRackId(dstHostId, this->fatTreeScaleK), this->fatTreeScaleK);
+        return this->getUplinkPort(dstHostId);
+    };
 };
 
 
-struct SwitchFtCore : Switch
+struct SwitchFtCore final : Switch
 {
     ft_scale_t fatTreeScaleK;
     // <pod_id, aggr_switch_id>
     std::unordered_map<pod_id_t, switch_id_t> routingTable;
+    std::vector<switchPort> ports; // by pod id
+
+    inline ft_port_t getNextHopPort(host_id_t dstHostId){
+        return ftGetPodId(dstHostId, this->fatTreeScaleK);
+    };
 
     /* Overriding the virtual function of the base class */
     syndb_status_t routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo);
 
-    Switch* getNextHop(host_id_t dstHostId);
+    Switch* getNextHop(host_id_t dstHostId); // table-driven
 
     inline SwitchFtCore(switch_id_t id) : Switch(id) {
         this->fatTreeScaleK = syndbConfig.fatTreeTopoK;
@@ -61,6 +151,44 @@ struct SwitchFtCore : Switch
 };
 
 
-
+/* SOURCE_ROUTING: the egress port of the hop is read from the path the pkt carries. Each switch adds its INT info before routing, so the INT list tells the hop. */
+inline syndb_status_t routeScheduleNormalPktOnPath(Switch* sw, normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
+    ft_port_t port = FtPathCache::getHopPort(pkt->path, pkt->switchINTInfoList.size() - 1);
+
+    switch(sw->type){
+        case SwitchType::FtTor:{
+            SwitchFtTor* tor = static_cast<SwitchFtTor*>(sw);
+            if(port < tor->fatTreeScaleK / 2)
+                return tor->scheduleToHostPort(port, pkt->size, pktArrivalTime, rsinfo);
+            return scheduleToPort(sw, tor->ports[port], pkt->size, pktArrivalTime, rsinfo);
+        }
+        case SwitchType::FtAggr:
+            return scheduleToPort(sw, static_cast<SwitchFtAggr*>(sw)->ports[port], pkt->size, pktArrivalTime, rsinfo);
+        default:
+            return scheduleToPort(sw, static_cast<SwitchFtCore*>(sw)->ports[port], pkt->size, pktArrivalTime, rsinfo);
+    }
+}
+
+/*
+    The routing of a normal pkt on any switch: the one call per hop into the switch classes.
+    SPECIALIZED_FATTREE: the build only runs FatTrees, so the switch type picks the routing function, which the
+    compiler calls directly (the FatTree switch classes are final) instead of through the vtable.
+*/
+inline syndb_status_t routeScheduleNormalPktOn(Switch* sw, normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
+    #if SOURCE_ROUTING
+    return routeScheduleNormalPktOnPath(sw, pkt, pktArrivalTime, rsinfo);
+    #elif SPECIALIZED_FATTREE
+    switch(sw->type){
+        case SwitchType::FtTor:
+            return static_cast<SwitchFtTor*>(sw)->routeScheduleNormalPkt(pkt, pktArrivalTime, rsinfo);
+        case SwitchType::FtAggr:
+            return static_cast<SwitchFtAggr*>(sw)->routeScheduleNormalPkt(pkt, pktArrivalTime, rsinfo);
+        default:
+            return static_cast<SwitchFtCore*>(sw)->routeScheduleNormalPkt(pkt, pktArrivalTime, rsinfo);
+    }
+    #else
+    return sw->routeScheduleNormalPkt(pkt, pktArrivalTime, rsinfo);
+    #endif
+}
 
 #endif
@@ -0,0 +1,20 @@
+#include <fmt/core.h>
+#include "topology/switch_generic.hpp"
+
+
+syndb_status_t SwitchGeneric::routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo){
+
+    switch_id_t dstTorId = (*this->hostTors)[pkt->dstHost];
+
+    if(dstTorId == this->id){ // intra-rack routing
+        return this->intraRackRouteNormalPkt(pkt, pktArrivalTime, rsinfo);
+    }
+
+    generic_port_t port = this->nextHops->getPort(this->id, this->nextHops->torIdx[dstTorId]);
+    if(port == noNextHopPort){ // the loader checks that all ToRs reach each other
+        std::string msg = fmt::format("No next hop from switch {} towards ToR {} (host {})", this->id, dstTorId, pkt->dstHost);
+        throw std::logic_error(msg);
+    }
+
+    return scheduleToPort(this, this->ports[port], pkt->size, pktArrivalTime, rsinfo);
+}
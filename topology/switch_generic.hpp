@@ -0,0 +1,44 @@
+#ifndef GENERICSWITCHES_H
+#define GENERICSWITCHES_H
+
+#include <vector>
+#include <limits>
+#include "topology/switch.hpp"
+
+typedef uint16_t generic_port_t;
+static const generic_port_t noNextHopPort = std::numeric_limits<generic_port_t>::max();
+static const switch_id_t noTorIdx = std::numeric_limits<switch_id_t>::max();
+
+/*
+    The next hops of all switches towards all ToRs of a topology read from a file (see file_topology.hpp).
+    One egress port index per (switch, dst ToR): numSwitches x numTors x 2B, e.g. 20MB for 2K switches and 5K ToRs.
+    The row of a switch is contiguous, so the lookups of a switch stay in its row.
+*/
+struct NextHopTable
+{
+    switch_id_t numSwitches = 0;
+    switch_id_t numTors = 0;
+    std::vector<switch_id_t> torIdx; // by switch id: index among the ToRs, noTorIdx for the others
+    std::vector<generic_port_t> ports; // [switchId * numTors + torIdx]. noNextHopPort: no path, or the ToR itself
+
+    inline generic_port_t getPort(switch_id_t switchId, switch_id_t dstTorIdx) const {
+        return this->ports[(uint64_t)switchId * this->numTors + dstTorIdx];
+    };
+};
+
+
+/* A switch of a topology file: routes on the next hop table. Any switch with hosts is a ToR. */
+struct SwitchGeneric final : Switch
+{
+    std::vector<switchPort> ports; // in the order of the neighbor ids, as in the CSR graph of the topology
+    const NextHopTable* nextHops;
+    const std::vector<switch_id_t>* hostTors; // Topology::hostTors
+
+    /* Overriding the virtual function of the base class */
+    syndb_status_t routeScheduleNormalPkt(normalpkt_p &pkt, const sim_time_t pktArrivalTime, routeScheduleInfo &rsinfo);
+
+    SwitchGeneric(switch_id_t id):Switch(id) {};
+};
+
+
+#endif
@@ -1,7 +1,10 @@
 #include "topology/syndb_ringbuffer.hpp"
 #include "utils/logger.hpp"
+#include "simulation/checkpoint.hpp"
 
 RingBuffer::RingBuffer(){
+    this->capacity = syndbConfig.ringBufferSize;
+    this->pRecordArray.reset(new pRecord[this->capacity]);
     this->end = -1; // ring buffer is empty
     this->next = 0; // points to the start after wrap around
     this->wrapAround = false;
@@ -14,7 +17,7 @@ void RingBuffer::insertPrecord(pkt_id_t pktId, sim_time_t arrivalTime){
 
     // Common pointers management
     this->end = this->next;
-    this->next = (this->next + 1) % this->pRecordArray.size();
+    this->next = (this->next + 1) % this->capacity;
 
     if(this->next == 0 && this->wrapAround == false){ // next becomes zero after incr
         this->wrapAround = true;
@@ -22,7 +25,11 @@ void RingBuffer::insertPrecord(pkt_id_t pktId, sim_time_t arrivalTime){
 }
 
 pRecord RingBuffer::getPrecord(ringbuffer_index_t idx){
-    return this->pRecordArray.at(idx); 
+    if(idx < 0 || (size_t)idx >= this->capacity){
+        std::string msg = fmt::format("RingBuffer index {} out of range", idx);
+        throw std::out_of_range(msg);
+    }
+    return this->pRecordArray[idx];
 }
 
 ringbuffer_index_t RingBuffer::getStart(){
@@ -54,7 +61,7 @@ actualRingBufferInfo RingBuffer::getActualRingBufferInfo(uint32_t actualSize){
 
         if(this->wrapAround == true){
             remainingElements = actualSize - elementsTillEnd;
-            start = this->pRecordArray.size() - remainingElements;
+            start = this->capacity - remainingElements;
         }
         else // NOT wrapped around and elements in ringBuffer < actualSize
         {
@@ -75,7 +82,7 @@ actualRingBufferInfo RingBuffer::getActualRingBufferInfo(uint32_t actualSize){
 }
 
 ringbuffer_index_t RingBuffer::getNextIndex(ringbuffer_index_t idx){
-    return (idx + 1) % this->pRecordArray.size();
+    return (idx + 1) % this->capacity;
 }
 
 void RingBuffer::printRingBufferRange(ringbuffer_index_t start, ringbuffer_index_t end){
@@ -107,3 +114,26 @@ void RingBuffer::printActualRingBuffer(uint32_t actualSize){
     this->printRingBufferRange(info.start, info.end);
 
 }
+
+/* Only the filled part of the array: all of it once it wrapped around */
+void RingBuffer::saveState(CheckpointWriter &ckpt){
+    ckpt.write(this->next);
+    ckpt.write(this->end);
+    ckpt.write(this->wrapAround);
+
+    size_t numFilled = this->wrapAround ? this->capacity : this->next;
+    for(size_t idx = 0; idx < numFilled; idx++){
+        ckpt.write(this->pRecordArray[idx]);
+    }
+}
+
+void RingBuffer::loadState(CheckpointReader &ckpt){
+    ckpt.read(this->next);
+    ckpt.read(this->end);
+    ckpt.read(this->wrapAround);
+
+    size_t numFilled = this->wrapAround ? this->capacity : this->next;
+    for(size_t idx = 0; idx < numFilled; idx++){
+        ckpt.read(this->pRecordArray[idx]);
+    }
+}
@@ -1,10 +1,13 @@
 #ifndef SWITCH_SYNDB_H
 #define SWITCH_SYNDB_H
 
-#include <array>
+#include <memory>
 #include "utils/types.hpp"
 #include "simulation/config.hpp"
 
+struct CheckpointWriter;
+struct CheckpointReader;
+
 
 struct pRecord
 {
@@ -23,7 +26,9 @@ struct RingBuffer
 {
     private:
 
-    std::array<pRecord, syndbConfig.ringBufferSize> pRecordArray;
+    // ringBufferSize records. Left uninitialized like the array it was, so that unused ring buffers cost no memory.
+    std::unique_ptr<pRecord[]> pRecordArray;
+    size_t capacity;
     ringbuffer_index_t next, end;
     bool wrapAround;
 
@@ -40,6 +45,9 @@ struct RingBuffer
     void printRingBuffer();
     void printActualRingBuffer(uint32_t actualSize);
     ringbuffer_index_t getNextIndex(ringbuffer_index_t idx); 
+
+    void saveState(CheckpointWriter &ckpt);
+    void loadState(CheckpointReader &ckpt);
 };
 
 
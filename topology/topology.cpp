@@ -1,81 +1,53 @@
 #include <stdexcept>
+#include <limits>
 #include <fmt/core.h>
 #include "simulation/config.hpp"
 #include "simulation/simulation.hpp"
 #include "topology/topology.hpp"
 #include "utils/logger.hpp"
 
+static const switch_id_t noTor = std::numeric_limits<switch_id_t>::max(); // hosts not connected yet
+
 
 Topology::Topology(){
     this->switchTypeIDMap[SwitchType::Simple] = std::set<switch_id_t>();
     this->switchTypeIDMap[SwitchType::FtTor] = std::set<switch_id_t>();
     this->switchTypeIDMap[SwitchType::FtAggr] = std::set<switch_id_t>();
     this->switchTypeIDMap[SwitchType::FtCore] = std::set<switch_id_t>();
+    this->switchTypeIDMap[SwitchType::Generic] = std::set<switch_id_t>();
 }
 
 SwitchType Topology::getSwitchTypeById(switch_id_t id){
-    auto typeit = this->switchTypeIDMap.begin();
-    for(typeit; typeit != this->switchTypeIDMap.end(); typeit++){
-        if(typeit->second.find(id) != typeit->second.end()) // Found the switch ID
-            return typeit->first; 
-    }
-
-    std::string msg = fmt::format("Switch id {} has no assigned type. This should NEVER happen!",id);
-    throw std::logic_error(msg);
+    return this->getSwitchById(id)->type;
 }
 
-Switch* Topology::getSwitchById(switch_id_t id){
-    auto it = this->switchIDMap.find(id);
-    if(it != this->switchIDMap.end()){ // found the switch_p
-        return it->second.get();
-    }
-    else
-    {
-        std::string msg = fmt::format("No switch_p found for switch_id {}. This should NEVER happen!", id);
-        throw std::logic_error(msg); 
-    }
-}
-
-Host* Topology::getHostById(host_id_t hostId){
-    auto it = this->hostIDMap.find(hostId);
-    if(it != this->hostIDMap.end()){ // found the switch_p
-        return it->second.get();
-    }
-    else
-    {
-        std::string msg = fmt::format("No host_p found for host_id {}. This should NEVER happen!", hostId);
-        throw std::logic_error(msg); 
-    }
+void Topology::throwUnknownId(const char* type, uint64_t id){
+    std::string msg = fmt::format("No {} found for id {}. This should NEVER happen!", type, id);
+    throw std::logic_error(msg);
 }
 
 switch_id_t Topology::getTorId(host_id_t hostId){
 
-    auto it = hostTorMap.find(hostId);
-
-    if(it == hostTorMap.end()){
+    if(hostId >= this->hostTors.size() || this->hostTors[hostId] == noTor){
         std::string msg = fmt::format("No ToR found for host {} in the topology!", hostId);
         throw std::logic_error(msg);
     }
-    // We have found the ToR, if we reach here
-    return it->second;
+
+    return this->hostTors[hostId];
 }
 
-host_tor_link_p Topology::createNewToRLink(){
+HostTorLink* Topology::createNewToRLink(){
 
-    // host_tor_link_p newLink = host_tor_link_p(new HostTorLink(this->getNextLinkId(), syndbConfig.torLinkSpeedGbps));
-    host_tor_link_p newLink = std::make_shared<HostTorLink>(this->getNextLinkId(), syndbConfig.torLinkSpeedGbps);
-    this->torLinkVector.push_back(newLink);
+    this->torLinks.emplace_back(this->getNextLinkId(), syndbConfig.torLinkSpeedGbps);
 
-    return newLink;
+    return &this->torLinks.back();
 }
 
-network_link_p Topology::createNewNetworLink(switch_id_t sw1, switch_id_t sw2){
+NetworkLink* Topology::createNewNetworLink(switch_id_t sw1, switch_id_t sw2){
 
-    // network_link_p newLink = network_link_p(new NetworkLink(this->getNextLinkId(), syndbConfig.networkLinkSpeedGbps, sw1, sw2));
-    network_link_p newLink = std::make_shared<NetworkLink>(this->getNextLinkId(), syndbConfig.networkLinkSpeedGbps, sw1, sw2);
-    this->networkLinkVector.push_back(newLink);
+    this->networkLinks.emplace_back(this->getNextLinkId(), syndbConfig.networkLinkSpeedGbps, sw1, sw2);
 
-    return newLink;
+    return &this->networkLinks.back();
 }
 
 switch_p Topology::createNewSwitch(SwitchType type){
@@ -92,6 +64,9 @@ switch_p Topology::createNewSwitch(SwitchType type){
         case SwitchType::FtCore:
             newSwitch = std::make_shared<SwitchFtCore>(this->getNextSwitchId()); 
             break;
+        case SwitchType::Generic:
+            newSwitch = std::make_shared<SwitchGeneric>(this->getNextSwitchId());
+            break;
         case SwitchType::Simple:
         default:
             newSwitch = std::make_shared<SimpleSwitch>(this->getNextSwitchId());
@@ -102,7 +77,7 @@ switch_p Topology::createNewSwitch(SwitchType type){
 
     // newSwitch->swPktArrivalFile = std::unique_ptr<std::ofstream>(new std::ofstream(fmt::format("./pktarrival/{}_sw{}.txt", switchTypeToString(type), newSwitch->id), std::ofstream::out)); 
      
-    this->switchIDMap[newSwitch->id] = newSwitch; 
+    this->switches.push_back(newSwitch); // at index newSwitch->id
     this->switchTypeIDMap[type].insert(newSwitch->id); 
 
     return newSwitch;  
@@ -113,7 +88,8 @@ host_p Topology::createNewHost(bool trafficGenDisabled){
     // host_p newHost = host_p(new Host(this->getNextHostId(), trafficGenDisabled));
     host_p newHost = std::make_shared<Host>(this->getNextHostId(), trafficGenDisabled);
 
-    this->hostIDMap[newHost->id] = newHost; 
+    this->hosts.push_back(newHost); // at index newHost->id
+    this->hostTors.push_back(noTor);
 
     return newHost;
 }
@@ -121,17 +97,9 @@ host_p Topology::createNewHost(bool trafficGenDisabled){
 
 void Topology::addHostToTor(host_p &host, switch_p &tor){
 
-    host_tor_link_p newLink = createNewToRLink();
+    HostTorLink* newLink = createNewToRLink();
 
-    // Update things on Host
-    host->torLink = newLink;
-    host->torSwitch = tor.get();
-
-    // Update things on Switch
-    tor->neighborHostTable[host->id] = newLink.get();
-
-    // Update things on Topology
-    this->hostTorMap[host->id] = tor->id;
+    this->connectHostToTor(host.get(), tor.get(), newLink);
 
     // debug_print("Connected h{} to sw{}", host->id, tor->id);
 
@@ -139,18 +107,46 @@ void Topology::addHostToTor(host_p &host, switch_p &tor){
 
 void Topology::connectSwitchToSwitch(switch_p &s1, switch_p &s2){
 
-    network_link_p newLink = createNewNetworLink(s1->id, s2->id);
+    NetworkLink* newLink = createNewNetworLink(s1->id, s2->id);
 
-    // Update things on s1
-    s1->neighborSwitchTable[s2->id] = newLink.get();
-
-    // Update things on s2
-    s2->neighborSwitchTable[s1->id] = newLink.get();
+    this->connectSwitchToSwitch(s1.get(), s2.get(), newLink);
 
     // debug_print("Connected sw{} to sw{}", s1->id, s2->id);
 
 }
 
+HostTorLink* Topology::placeToRLink(uint64_t slot, link_id_t id){
+    this->torLinks[slot] = HostTorLink(id, syndbConfig.torLinkSpeedGbps);
+    return &this->torLinks[slot];
+}
+
+NetworkLink* Topology::placeNetworkLink(uint64_t slot, link_id_t id, switch_id_t sw1, switch_id_t sw2){
+    this->networkLinks[slot] = NetworkLink(id, syndbConfig.networkLinkSpeedGbps, sw1, sw2);
+    return &this->networkLinks[slot];
+}
+
+void Topology::connectHostToTor(Host* host, Switch* tor, HostTorLink* link){
+
+    // Update things on Host
+    host->torLink = link;
+    host->torSwitch = tor;
+
+    // Update things on Switch
+    tor->neighborHostTable[host->id] = link;
+
+    // Update things on Topology
+    this->hostTors[host->id] = tor->id;
+}
+
+void Topology::connectSwitchToSwitch(Switch* s1, Switch* s2, NetworkLink* link){
+
+    // Update things on s1
+    s1->neighborSwitchTable[s2->id] = link;
+
+    // Update things on s2
+    s2->neighborSwitchTable[s1->id] = link;
+}
+
 
 void SimpleTopology::buildTopo(){
 
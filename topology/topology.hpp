@@ -2,16 +2,13 @@
 #define TOPOLOGY_H
 
 #include <vector>
+#include <deque>
 #include <map>
-#include <unordered_map>
 #include "topology/host.hpp"
 #include "topology/link.hpp"
 #include "topology/switch.hpp"
 #include "topology/switch_ft.hpp"
-
-typedef std::unordered_map<host_id_t, switch_id_t> host_tor_map_t;
-typedef std::unordered_map<host_id_t, host_p> host_id_map_t;
-typedef std::unordered_map<switch_id_t, switch_p> switch_id_map_t;
+#include "topology/switch_generic.hpp"
 
 
 struct Topology
@@ -20,35 +17,60 @@ struct Topology
     link_id_t nextLinkId = 0;
     switch_id_t nextSwitchId = 0;
 
-    // Hold all shared_ptrs so that hosts, links, switches don't get destroyed by mistake
-    // Keeping two links separate for possible future optimizations
-    std::vector<network_link_p> networkLinkVector;
-    std::vector<host_tor_link_p> torLinkVector;
-    host_id_map_t hostIDMap;   
-    switch_id_map_t switchIDMap;
+    /*
+        The ids are dense, so hosts and switches are stored by id. The links are stored in the order they are created:
+        the FatTree builds pod by pod, so the links (with the queue state of both directions) of a pod are next to each other.
+        deques keep their addresses stable while growing, the switches and hosts point to them.
+    */
+    std::deque<NetworkLink> networkLinks;
+    std::deque<HostTorLink> torLinks;
+    std::vector<host_p> hosts; // by host id
+    std::vector<switch_p> switches; // by switch id
     
-    host_tor_map_t hostTorMap; // updated by addHostToTor()
-    std::map<SwitchType, std::set<switch_id_t>> switchTypeIDMap; // updated by createNewSwitch()
+    std::vector<switch_id_t> hostTors; // by host id, updated by addHostToTor() / connectHostToTor()
+    std::map<SwitchType, std::set<switch_id_t>> switchTypeIDMap; // updated by createNewSwitch(), or once built (FatTree)
 
     switch_id_t getTorId(host_id_t hostId);
-    Switch* getSwitchById(switch_id_t id);
     SwitchType getSwitchTypeById(switch_id_t id); 
-    Host* getHostById(host_id_t hostId);
+
+    inline Switch* getSwitchById(switch_id_t id){
+        if(id >= this->switches.size())
+            throwUnknownId("switch", id);
+        return this->switches[id].get();
+    };
+
+    inline Host* getHostById(host_id_t hostId){
+        if(hostId >= this->hosts.size())
+            throwUnknownId("host", hostId);
+        return this->hosts[hostId].get();
+    };
 
     inline host_id_t getNextHostId() {return this->nextHostId++;}
     inline link_id_t getNextLinkId() {return this->nextLinkId++;}
     inline switch_id_t getNextSwitchId() {return this->nextSwitchId++;}
 
-    host_tor_link_p createNewToRLink();
-    network_link_p createNewNetworLink(switch_id_t sw1, switch_id_t sw2);
+    HostTorLink* createNewToRLink();
+    NetworkLink* createNewNetworLink(switch_id_t sw1, switch_id_t sw2);
     switch_p createNewSwitch(SwitchType type);
     host_p createNewHost(bool trafficGenDisabled = false);
 
     void addHostToTor(host_p &host, switch_p &tor);
     void connectSwitchToSwitch(switch_p &s1, switch_p &s2);
 
+    /*
+        Bulk construction (see FattreeTopology::buildTopo()): the links go to slots of the preallocated networkLinks/torLinks,
+        with the ids they would have got in the order of creation. Threads may fill different slots and connect different switches.
+    */
+    HostTorLink* placeToRLink(uint64_t slot, link_id_t id);
+    NetworkLink* placeNetworkLink(uint64_t slot, link_id_t id, switch_id_t sw1, switch_id_t sw2);
+    void connectHostToTor(Host* host, Switch* tor, HostTorLink* link);
+    void connectSwitchToSwitch(Switch* s1, Switch* s2, NetworkLink* link);
+
     Topology();
     virtual void buildTopo() = 0;
+
+    private:
+    [[noreturn]] void throwUnknownId(const char* type, uint64_t id);
   
 };
 
@@ -2,7 +2,8 @@
 #include <set>
 #include <random>
 #include <chrono>
-#include <algorithm>    // std::random_shuffle
+#include <algorithm>    // std::shuffle
+#include <limits>
 #include "traffic/incastGenerator.hpp"
 #include "simulation/config.hpp"
 #include "simulation/simulation.hpp"
@@ -46,7 +47,7 @@ IncastGenerator::IncastGenerator(){
 
     // Pick randomly numTargetHosts number of unique hosts
     std::set<host_id_t> targetHosts;
-    uint64_t seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed = getRandomSeed(RandomStream::IncastTargets, syndbSim->branchId);
     std::default_random_engine randTargetHosts(seed);
 
     while (targetHosts.size() != numTargetHosts)
@@ -63,32 +64,25 @@ IncastGenerator::IncastGenerator(){
             targetHostsVector.push_back(host);
         }
     }
-    std::random_shuffle(targetHostsVector.begin(), targetHostsVector.end()); 
+    std::shuffle(targetHostsVector.begin(), targetHostsVector.end(), randTargetHosts); // not random_shuffle(): its rand() would be shared by the ensemble replicas
 
     // Generate the schedule and add hosts from targetHostsVector sequentially
     sim_time_t interIncastGap = availableTime / (totalIncasts + 1);
-    sim_time_t halfSimTimeIncrement = syndbSim.timeIncrement / 2;
+    sim_time_t halfSimTimeIncrement = syndbSim->timeIncrement / 2;
     
     // Align the interIncastGap to sim timeIncr
-    interIncastGap = ((interIncastGap + halfSimTimeIncrement) / syndbSim.timeIncrement) * syndbSim.timeIncrement;
+    interIncastGap = ((interIncastGap + halfSimTimeIncrement) / syndbSim->timeIncrement) * syndbSim->timeIncrement;
 
-    seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    std::default_random_engine randSourceHosts(seed);
+    seed = getRandomSeed(RandomStream::IncastSources, syndbSim->branchId);
+    this->randSourceHosts = std::default_random_engine(seed);
+    this->isSource.resize(syndbConfig.numHosts, false);
     sim_time_t currTime = this->initialDelay + interIncastGap;
-    host_id_t srcHost;
 
     for(auto it = targetHostsVector.begin(); it != targetHostsVector.end(); it++){
        
         incastScheduleInfo_p newIncast = std::shared_ptr<incastScheduleInfo>(new incastScheduleInfo()); 
         newIncast->time = currTime;
         newIncast->targetHostId = *it;
-
-        while (newIncast->sourceHosts.size() != syndbConfig.incastFanInRatio)
-        {
-            srcHost = randSourceHosts() % syndbConfig.numHosts;
-            if(srcHost != newIncast->targetHostId)
-                newIncast->sourceHosts.insert(srcHost);
-        }
         
         this->incastSchedule.push_back(newIncast);
 
@@ -98,36 +92,74 @@ IncastGenerator::IncastGenerator(){
     this->updateNextIncast();
 }
 
+void IncastGenerator::drawSourceHosts(incastScheduleInfo &incast){
+    host_id_t srcHost;
+    incast.sourceHosts.reserve(syndbConfig.incastFanInRatio);
+
+    // Same draws as into a set: repeated hosts are skipped
+    while (incast.sourceHosts.size() != syndbConfig.incastFanInRatio)
+    {
+        srcHost = this->randSourceHosts() % syndbConfig.numHosts;
+        if(srcHost != incast.targetHostId && !this->isSource[srcHost]){
+            this->isSource[srcHost] = true;
+            incast.sourceHosts.push_back(srcHost);
+        }
+    }
+    std::sort(incast.sourceHosts.begin(), incast.sourceHosts.end());
+    for(auto it = incast.sourceHosts.begin(); it != incast.sourceHosts.end(); it++)
+        this->isSource[*it] = false;
+}
+
 
 void IncastGenerator::updateNextIncast(){
     if(this->incastSchedule.size() > 0){
         this->nextIncast = *this->incastSchedule.begin();
         this->nextIncastTime = this->nextIncast->time;
         this->incastSchedule.pop_front();
+        this->drawSourceHosts(*this->nextIncast);
+    }
+    else{ // no more incasts left
+        this->nextIncastTime = std::numeric_limits<sim_time_t>::max();
+    }
+}
+
+void IncastGenerator::skipIncastsBefore(sim_time_t time){
+    while(this->nextIncastTime < time){
+        this->updateNextIncast();
     }
 }
 
 void IncastGenerator::generateIncast(){
 
-    if(syndbSim.currTime == this->nextIncastTime){ // it MUST be equal
+    if(syndbSim->currTime == this->nextIncastTime){ // it MUST be equal
 
         host_id_t targetHost = this->nextIncast->targetHostId;
 
-        for(auto it = this->nextIncast->sourceHosts.begin(); it != this->nextIncast->sourceHosts.end(); it++){
-            Host* host = syndbSim.topo->getHostById(*it);
-
-            host->nextPkt->size = 1500;
-            host->nextPkt->dstHost = targetHost;
-
-            sim_time_t newNextPktTime = host->prevPktTime + getSerializationDelay(1500, syndbConfig.torLinkSpeedGbps);
-            host->nextPktTime = newNextPktTime;
-            host->torLink->next_idle_time_to_tor = newNextPktTime;
-
-            // ndebug_print("Incast pkt ID: {}", host->nextPkt->id);
+        // Hybrid mode, between pkt-level windows: the hosts are stopped, the incast pkts go straight to the fluid queues
+        if(syndbSim->hybrid && syndbSim->hybrid->fluid){
+            syndbSim->hybrid->addIncast(*this->nextIncast, syndbSim->currTime);
+        }
+        else{
+            for(auto it = this->nextIncast->sourceHosts.begin(); it != this->nextIncast->sourceHosts.end(); it++){
+                Host* host = syndbSim->topo->getHostById(*it);
+
+                host->nextPkt->size = 1500;
+                host->nextPkt->dstHost = targetHost;
+
+                // Never in the past: a pkt sent before the incast time would reach the network retroactively
+                sim_time_t newNextPktTime = host->prevPktTime + getSerializationDelay(1500, syndbConfig.torLinkSpeedGbps);
+                newNextPktTime = std::max<sim_time_t>(newNextPktTime, syndbSim->currTime);
+                host->nextPktTime = newNextPktTime;
+                host->torLink->next_idle_time_to_tor = newNextPktTime;
+                syndbSim->rescheduleHost(host);
+
+                // ndebug_print("Incast pkt ID: {}", host->nextPkt->id);
+            }
         }
 
         #if LOGGING
-        syndbSim.pktDumper->dumpIncastInfo(*this->nextIncast);
+        if(syndbSim->isInTimeWindow(syndbSim->currTime))
+            syndbSim->pktDumper->dumpIncastInfo(*this->nextIncast);
         #endif
         
         this->updateNextIncast();
@@ -158,6 +190,8 @@ void incastScheduleInfo::printScheduleInfo(){
     for(auto it = this->sourceHosts.begin(); it != this->sourceHosts.end(); it++){
         srcHosts.append(fmt::format("{} ", *it));            
     }
+    if(srcHosts.empty())
+        srcHosts = "drawn when lined up";
     debug_print("Time: {}\tTarget: {} | Sources: {}", incastTime, targetHost, srcHosts); 
     #endif
 }
@@ -4,7 +4,8 @@
 #include <memory>
 #include <functional>
 #include <list>
-#include <set>
+#include <vector>
+#include <random>
 #include "utils/types.hpp"
 
 
@@ -12,7 +13,7 @@ struct incastScheduleInfo{
     sim_time_t time;
     host_id_t targetHostId;
 
-    std::set<host_id_t> sourceHosts;
+    std::vector<host_id_t> sourceHosts; // sorted, no duplicates. Not a set: large FatTrees have thousands per incast. Empty until lined up
 
     void printScheduleInfo();
 };
@@ -28,11 +29,22 @@ struct IncastGenerator
     
     sim_time_t nextIncastTime;
     incastScheduleInfo_p nextIncast;
+
+    /*
+        The sources of an incast are drawn when it is lined up, in the order of the schedule: the same draws as drawing the whole
+        schedule upfront, without holding numHosts/4 sources for each of the thousands of incasts of a large FatTree.
+    */
+    std::default_random_engine randSourceHosts;
+    std::vector<bool> isSource; // of the incast being drawn
   
     IncastGenerator();
     void generateIncast();
     void updateNextIncast();
+    void skipIncastsBefore(sim_time_t time); // forked what-if branch: drops the incasts that already happened
     void printIncastSchedule();
+
+    private:
+    void drawSourceHosts(incastScheduleInfo &incast);
 };
 
 
@@ -6,11 +6,11 @@
 Pkt::Pkt(pkt_size_t size){
     this->size = size;
 
-    // debug_print(fmt::format("[Sim Time {}ns] Packet {} constructed!", syndbSim.currTime, id));
+    // debug_print(fmt::format("[Sim Time {}ns] Packet {} constructed!", syndbSim->currTime, id));
 }
 
 NormalPkt::~NormalPkt(){
-    // debug_print(fmt::format("[Sim Time {}ns] Normal Packet {} destructed!", syndbSim.currTime, this->id));
+    // debug_print(fmt::format("[Sim Time {}ns] Normal Packet {} destructed!", syndbSim->currTime, this->id));
 }
 
 
@@ -21,4 +21,31 @@ NormalPkt::NormalPkt(pkt_id_t id, pkt_size_t size):Pkt::Pkt(size){
 
 TriggerPkt::TriggerPkt(trigger_id_t triggerId, pkt_size_t size):Pkt::Pkt(size){
     this->triggerId = triggerId;
+    this->nextFree = NULL;
+}
+
+triggerpkt_p TriggerPktPool::getNewTriggerPkt(trigger_id_t triggerId, pkt_size_t size){
+    triggerpkt_p newTriggerPkt;
+
+    if(this->freeList != NULL){
+        newTriggerPkt = this->freeList; // retrieve
+        this->freeList = newTriggerPkt->nextFree; // remove
+
+        newTriggerPkt->triggerId = triggerId;
+        newTriggerPkt->size = size;
+        newTriggerPkt->nextFree = NULL;
+    }
+    else{
+        this->store.emplace_back(triggerId, size);
+        newTriggerPkt = &this->store.back();
+    }
+
+    this->numInUse++;
+    return newTriggerPkt;
+}
+
+void TriggerPktPool::freeTriggerPkt(triggerpkt_p pkt){
+    pkt->nextFree = this->freeList;
+    this->freeList = pkt;
+    this->numInUse--;
 }
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <memory>
 #include <list>
+#include <deque>
 #include "utils/types.hpp"
 
 struct switchINTInfo
@@ -26,9 +27,11 @@ typedef struct Pkt {
 } Pkt;
 
 typedef struct NormalPkt : Pkt {
+    host_id_t srcHost; // first: goes next to the size, in the padding before the id
     pkt_id_t id;
-    host_id_t srcHost;
+    uint64_t orderKey; // (generation time << getIdKeyBits(numHosts) | srcHost). Same order as id, but known before the id (see SimPartition::setPktId())
     host_id_t dstHost;
+    ft_path_t path; // SOURCE_ROUTING: set by the src host
 
     /* INT data for simulation */
     sim_time_t startTime, endTime;
@@ -48,15 +51,34 @@ typedef struct TriggerPkt : Pkt {
     trigger_id_t triggerId;
     switch_id_t srcSwitchId;
     switch_id_t dstSwitchId;
-    trigger_id_t triggerOriginSwId;
-    sim_time_t triggerTime;
+    switch_id_t triggerOriginSwId;
+    union {
+        sim_time_t triggerTime;
+        TriggerPkt* nextFree; // intrusive link for the TriggerPktPool's free list. Only there: shares the bytes of the triggerTime
+    };
 
+    TriggerPkt() = default;
     TriggerPkt(trigger_id_t triggerId, pkt_size_t size);
     // using Pkt::Pkt; // Inheriting constructor of base class Pkt
 
 } TriggerPkt;
 
-typedef std::shared_ptr<TriggerPkt> triggerpkt_p;
+// typedef std::shared_ptr<TriggerPkt> triggerpkt_p;
+typedef TriggerPkt* triggerpkt_p;
+
+/* 
+    Pooled store for TriggerPkts. Free pkts are chained through TriggerPkt::nextFree,
+    so recycling a pkt never allocates. The store only grows at the peak of concurrent trigger floods.
+*/
+struct TriggerPktPool
+{
+    std::deque<TriggerPkt> store; // deque keeps pkt addresses stable while growing
+    TriggerPkt* freeList = NULL;
+    size_t numInUse = 0;
+
+    triggerpkt_p getNewTriggerPkt(trigger_id_t triggerId, pkt_size_t size);
+    void freeTriggerPkt(triggerpkt_p pkt);
+};
 
 enum class PacketType {NormalPkt, TriggerPkt};
 
@@ -1,6 +1,7 @@
-#include <chrono>
-#include <thread>
+#include <map>
+#include <mutex>
 #include "simulation/config.hpp"
+#include "utils/utils.hpp"
 #include "randomGenCDF.hpp"
 using namespace std;
 
@@ -26,12 +27,28 @@ std::vector<int> RandomFromCDF::readCDFFile (string fileName) {
     return distribution;
 }   
 
-void RandomFromCDF::loadCDFs (std::string packetsizeDistFile, std::string packetarrivalDistFile) {
-    packetSizeDist = readCDFFile(packetsizeDistFile);
-    packetArrivalDist = readCDFFile(packetarrivalDistFile);
-    uint64_t mySeed1 = std::chrono::system_clock::now().time_since_epoch().count();
-    std::this_thread::sleep_for(std::chrono::microseconds(1));
-    uint64_t mySeed2 = std::chrono::system_clock::now().time_since_epoch().count();
+static std::mutex sharedCDFsMutex;
+static std::map<std::string, cdf_table_p> sharedCDFs;
+
+/* The table of a CDF file. Read on first use only. Thread-safe. */
+cdf_table_p RandomFromCDF::getSharedCDF(const std::string &fileName) {
+    std::lock_guard<std::mutex> lock(sharedCDFsMutex);
+
+    auto it = sharedCDFs.find(fileName);
+    if (it != sharedCDFs.end()) {
+        return it->second;
+    }
+
+    cdf_table_p table = std::make_shared<const std::vector<int>>(readCDFFile(fileName));
+    sharedCDFs[fileName] = table;
+    return table;
+}
+
+void RandomFromCDF::loadCDFs (std::string packetsizeDistFile, std::string packetarrivalDistFile, host_id_t hostId) {
+    packetSizeDist = getSharedCDF(packetsizeDistFile);
+    packetArrivalDist = getSharedCDF(packetarrivalDistFile);
+    uint64_t mySeed1 = getRandomSeed(RandomStream::PktSize, hostId);
+    uint64_t mySeed2 = getRandomSeed(RandomStream::PktDelay, hostId);
     generator.seed(mySeed1);
     generator2.seed(mySeed2);
     uniformDist = std::uniform_int_distribution<>(0,99);
@@ -40,15 +57,18 @@ void RandomFromCDF::loadCDFs (std::string packetsizeDistFile, std::string packet
 int RandomFromCDF::getNextPacketSize () {
     int packetSize;
     int random = uniformDist(generator);
-    packetSize = packetSizeDist.at(random);
+    packetSize = packetSizeDist->at(random);
     return packetSize;
 }
 
 int RandomFromCDF::getNextPacketDelay () {
     int packetDelay;
     int random = uniformDist(generator2);
-    packetDelay = packetArrivalDist.at(random);
-    packetDelay = (int)((double) packetDelay / ((double)syndbConfig.targetBaseNetworkLoadPercent / 3.0));
-    return packetDelay;
+    packetDelay = packetArrivalDist->at(random);
+    return scalePacketDelay(packetDelay);
+}
+
+int RandomFromCDF::scalePacketDelay (int packetDelay) {
+    return (int)((double) packetDelay / ((double)syndbConfig.targetBaseNetworkLoadPercent / 3.0));
 }
 
@@ -9,24 +9,30 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
 #include "utils/types.hpp"
 
 
+typedef std::shared_ptr<const std::vector<int>> cdf_table_p;
+
 typedef struct randomCDF
 {
-    std::vector<int> packetSizeDist;
-    std::vector<int> packetArrivalDist;
+    // Read once per file and shared by all hosts, also across ensemble replicas. See getSharedCDF().
+    cdf_table_p packetSizeDist;
+    cdf_table_p packetArrivalDist;
 
     std::default_random_engine generator;
     std::default_random_engine generator2;
 
     std::uniform_int_distribution<int> uniformDist;
 
-    std::vector<int> readCDFFile(std::string fileName);
-    void loadCDFs(std::string packetsizeDistFile, std::string flowarrivalDistFile);
+    static std::vector<int> readCDFFile(std::string fileName);
+    static cdf_table_p getSharedCDF(const std::string &fileName);
+    void loadCDFs(std::string packetsizeDistFile, std::string flowarrivalDistFile, host_id_t hostId);
 
     int getNextPacketSize();
     int getNextPacketDelay();
+    static int scalePacketDelay(int packetDelay); // to the targetBaseNetworkLoadPercent
 
 } RandomFromCDF;
 
@@ -1,8 +1,10 @@
 
 #include <cmath>
+#include <algorithm>
 #include "traffic/trafficGenerator.hpp"
 #include "simulation/simulation.hpp"
 #include "utils/utils.hpp"
+#include "simulation/checkpoint.hpp"
 
 
 
@@ -13,6 +15,9 @@ TrafficGenerator::~TrafficGenerator(){
     // this->interPktGapFile.close();
 }
 
+const std::string DcTrafficGenerator::packetSizeDistFile = "traffic-dist/fb_webserver_packetsizedist_cdf.csv";
+const std::string DcTrafficGenerator::packetArrivalDistFile = "traffic-dist/packetinterarrival_ns_cdf.csv";
+
 /* Data-ceter Traffic generator based on   */
 /* Load variation: return pkt_size 0, if no packet is to be sent. */
 
@@ -25,7 +30,7 @@ void DcTrafficGenerator::getNextPacket(packetInfo &pktInfo){
 
 }
 
-int DcTrafficGenerator::loadTrafficDistribution (std::string packetsizeDistFile, std::string flowarrivalDistFile) {
+int DcTrafficGenerator::loadTrafficDistribution (std::string packetsizeDistFile, std::string flowarrivalDistFile, host_id_t hostId) {
     pkt_size_t base_size = 80; // in bytes
     pkt_size_t size_on_wire = base_size + 24;
     // int pps = ((this->torLinkSpeed * 1000000000)/ (size_on_wire * 8));
@@ -33,10 +38,35 @@ int DcTrafficGenerator::loadTrafficDistribution (std::string packetsizeDistFile,
     sim_time_t min_delay_ns = (size_on_wire * 8) / syndbConfig.torLinkSpeedGbps;
 
 
-    myRandomFromCDF.loadCDFs("traffic-dist/fb_webserver_packetsizedist_cdf.csv", "traffic-dist/packetinterarrival_ns_cdf.csv");
+    myRandomFromCDF.loadCDFs(DcTrafficGenerator::packetSizeDistFile, DcTrafficGenerator::packetArrivalDistFile, hostId);
     return 0;
 }
 
+/* A pkt occupies the host's link for its send delay plus its serialization. Size and delay are drawn independently. */
+double DcTrafficGenerator::getMeanRate(link_speed_gbps_t linkSpeed){
+    const std::vector<int> &sizes = *this->myRandomFromCDF.packetSizeDist;
+    const std::vector<int> &delays = *this->myRandomFromCDF.packetArrivalDist;
+    double bytes = 0, time = 0;
+
+    // The draws are uniform over the first 100 entries of the CDF tables
+    for(int i = 0; i < 100; i++){
+        bytes += sizes.at(i) + 24;
+        time += getSerializationDelay(sizes.at(i), linkSpeed) + RandomFromCDF::scalePacketDelay(delays.at(i));
+    }
+
+    return time > 0 ? bytes / time : 0;
+}
+
+void DcTrafficGenerator::saveState(CheckpointWriter &ckpt){
+    ckpt.writeRandomEngine(this->myRandomFromCDF.generator);
+    ckpt.writeRandomEngine(this->myRandomFromCDF.generator2);
+}
+
+void DcTrafficGenerator::loadState(CheckpointReader &ckpt){
+    ckpt.readRandomEngine(this->myRandomFromCDF.generator);
+    ckpt.readRandomEngine(this->myRandomFromCDF.generator2);
+}
+
 /* Simple pkt generator for now: continuous generation  */
 /* Load variation: return pkt_size 0, if no packet is to be sent. */
 void SimpleTrafficGenerator::getNextPacket(packetInfo &pktInfo){
@@ -46,7 +76,12 @@ void SimpleTrafficGenerator::getNextPacket(packetInfo &pktInfo){
 
 }
 
-int SimpleTrafficGenerator::loadTrafficDistribution (std::string packetsizeDistFile, std::string flowarrivalDistFile) {
+double SimpleTrafficGenerator::getMeanRate(link_speed_gbps_t linkSpeed){
+    pkt_size_t size = syndbConfig.fixedPktSizeForSimpleTrafficGen;
+    return (double)(size + 24) / std::max<sim_time_t>(getSerializationDelay(size, linkSpeed), 1);
+}
+
+int SimpleTrafficGenerator::loadTrafficDistribution (std::string packetsizeDistFile, std::string flowarrivalDistFile, host_id_t hostId) {
 
     return 0;
 }
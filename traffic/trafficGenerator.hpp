@@ -6,6 +6,9 @@
 #include "traffic/packet.hpp"
 #include "randomGenCDF.hpp"
 
+struct CheckpointWriter;
+struct CheckpointReader;
+
 struct packetInfo
 {
    
@@ -23,28 +26,38 @@ struct TrafficGenerator
     ~TrafficGenerator();
  
     virtual void getNextPacket(packetInfo &pktInfo) = 0;
-    virtual int loadTrafficDistribution(std::string packetsizeDistFile, std::string packetarrivalDistFile) = 0;
+    virtual int loadTrafficDistribution(std::string packetsizeDistFile, std::string packetarrivalDistFile, host_id_t hostId) = 0;
+    /* Hybrid mode: the mean on-wire rate of the generated pkts in bytes/ns, when sent on a link of linkSpeed */
+    virtual double getMeanRate(link_speed_gbps_t linkSpeed) = 0;
+    /* Checkpoints: the RNG state. Nothing by default. */
+    virtual void saveState(CheckpointWriter &ckpt) {};
+    virtual void loadState(CheckpointReader &ckpt) {};
 };
 
 
 /* SimpleTrafficGenerator struct */
-struct SimpleTrafficGenerator : TrafficGenerator
+struct SimpleTrafficGenerator final : TrafficGenerator
 {
     
     /* Overriding method of the abstract class */
     void getNextPacket(packetInfo &pktInfo);
-    int loadTrafficDistribution(std::string packetsizeDistFile, std::string packetarrivalDistFile);
+    int loadTrafficDistribution(std::string packetsizeDistFile, std::string packetarrivalDistFile, host_id_t hostId);
+    double getMeanRate(link_speed_gbps_t linkSpeed);
 };
 
 /* DC Trafficgenerator struct */
-struct DcTrafficGenerator : TrafficGenerator
+struct DcTrafficGenerator final : TrafficGenerator
 {
     RandomFromCDF myRandomFromCDF;
+    static const std::string packetSizeDistFile, packetArrivalDistFile; // what is read, regardless of the config's dist files
     
     // using TrafficGenerator::TrafficGenerator;
     
     void getNextPacket(packetInfo &pktInfo);
-    int loadTrafficDistribution(std::string packetsizeDistFile, std::string packetarrivalDistFile);
+    int loadTrafficDistribution(std::string packetsizeDistFile, std::string packetarrivalDistFile, host_id_t hostId);
+    double getMeanRate(link_speed_gbps_t linkSpeed);
+    void saveState(CheckpointWriter &ckpt);
+    void loadState(CheckpointReader &ckpt);
 };
 
 
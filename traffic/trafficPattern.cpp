@@ -1,16 +1,29 @@
-#include <chrono>
-#include <thread>
 #include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/core.h>
 #include "traffic/trafficPattern.hpp"
 #include "simulation/simulation.hpp"
 #include "topology/host.hpp"
+#include "topology/switch_ft.hpp"
 #include "utils/logger.hpp"
+#include "utils/utils.hpp"
+#include "simulation/checkpoint.hpp"
+
+void TrafficPattern::addDstRates(double rate, std::vector<double> &dstRates){
+    std::string msg = fmt::format("The traffic pattern {} has no fluid model", trafficPatternTypeToString(syndbConfig.trafficPatternType));
+    throw std::logic_error(msg);
+}
 
 host_id_t SimpleTopoTrafficPattern::applyTrafficPattern(){
     // Hard-coded logic for destination host. Mainly for SimpleTopology
     return (this->parentHostId + 1) % 2; // 1 for 0 and 0 for 1
 }
 
+void SimpleTopoTrafficPattern::addDstRates(double rate, std::vector<double> &dstRates){
+    dstRates[(this->parentHostId + 1) % 2] += rate;
+}
+
 AlltoAllTrafficPattern::AlltoAllTrafficPattern(host_id_t hostId): TrafficPattern::TrafficPattern(hostId){
     this->nextDst = (hostId + 1) % syndbConfig.numHosts;
 }
@@ -29,6 +42,14 @@ host_id_t AlltoAllTrafficPattern::applyTrafficPattern(){
     */
 }
 
+void AlltoAllTrafficPattern::saveState(CheckpointWriter &ckpt){
+    ckpt.write(this->nextDst);
+}
+
+void AlltoAllTrafficPattern::loadState(CheckpointReader &ckpt){
+    ckpt.read(this->nextDst);
+}
+
 
 FtUniformTrafficPattern::FtUniformTrafficPattern(host_id_t hostId):TrafficPattern::TrafficPattern(hostId){
     host_id_t halfPoint = syndbConfig.numHosts / 2;
@@ -46,21 +67,19 @@ host_id_t FtUniformTrafficPattern::applyTrafficPattern(){
     return this->fixedDstHost;
 }
 
+void FtUniformTrafficPattern::addDstRates(double rate, std::vector<double> &dstRates){
+    dstRates[this->fixedDstHost] += rate;
+}
+
 FtMixedTrafficPattern::FtMixedTrafficPattern(host_id_t hostId):TrafficPattern::TrafficPattern(hostId){
     
-    uint64_t seed1 = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed1 = getRandomSeed(RandomStream::TrafficType, hostId);
     this->randTrafficType = std::default_random_engine(seed1);
 
-    // sleep to ensure suffiently different next seed
-    std::this_thread::sleep_for(std::chrono::microseconds(1)); 
-
-    uint64_t seed2 = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed2 = getRandomSeed(RandomStream::IntraRackHost, hostId);
     this->randIntraRackHost = std::default_random_engine(seed2);
 
-    // sleep to ensure suffiently different next seed
-    std::this_thread::sleep_for(std::chrono::microseconds(1)); 
-
-    uint64_t seed3 = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed3 = getRandomSeed(RandomStream::InterRackHost, hostId);
     this->randInterRackHost = std::default_random_engine(seed3);
 
 }
@@ -71,8 +90,8 @@ void FtMixedTrafficPattern::initTopoInfo(){
     host_id_t max = 0;
     host_id_t rackHostId;
     
-    switch_id_t torId = syndbSim.topo->getTorId(this->parentHostId);
-    const Switch* tor = syndbSim.topo->getSwitchById(torId);
+    switch_id_t torId = syndbSim->topo->getTorId(this->parentHostId);
+    const Switch* tor = syndbSim->topo->getSwitchById(torId);
 
     for(auto it = tor->neighborHostTable.begin(); it != tor->neighborHostTable.end(); it++){
         rackHostId = it->first;
@@ -108,10 +127,8 @@ host_id_t FtMixedTrafficPattern::getRandomIntraRackHost(){
     host_id_t dstHost;
     uint_fast32_t randval;
 
-    host_id_t numHostsPerRack = syndbConfig.fatTreeTopoK / 2;
-
     do {
-        randval = this->randIntraRackHost() % numHostsPerRack;
+        randval = ftModHalfK(this->randIntraRackHost(), syndbConfig.fatTreeTopoK);
         dstHost = this->rackMinId + randval;
     } while (dstHost == this->parentHostId);
 
@@ -143,3 +160,38 @@ host_id_t FtMixedTrafficPattern::applyTrafficPattern(){
         return this->getRandomInterRackHost();
     }
 }
+
+/* The probabilities of getDstType() and of the uniform picks of getRandomIntraRackHost() and getRandomInterRackHost() */
+void FtMixedTrafficPattern::addDstRates(double rate, std::vector<double> &dstRates){
+    double intraRackShare = std::min<double>(syndbConfig.ftMixedPatternPercentIntraRack + 1, 100) / 100.0;
+    host_id_t numRackHosts = this->rackMaxId - this->rackMinId + 1;
+    host_id_t numOtherHosts = syndbConfig.numHosts - numRackHosts;
+
+    if(numRackHosts > 1){
+        double intraRackRate = rate * intraRackShare / (numRackHosts - 1);
+        for(host_id_t dst = this->rackMinId; dst <= this->rackMaxId; dst++){
+            if(dst != this->parentHostId)
+                dstRates[dst] += intraRackRate;
+        }
+    }
+
+    if(numOtherHosts > 0){
+        double interRackRate = rate * (1.0 - intraRackShare) / numOtherHosts;
+        for(host_id_t dst = 0; dst < syndbConfig.numHosts; dst++){
+            if(dst < this->rackMinId || dst > this->rackMaxId)
+                dstRates[dst] += interRackRate;
+        }
+    }
+}
+
+void FtMixedTrafficPattern::saveState(CheckpointWriter &ckpt){
+    ckpt.writeRandomEngine(this->randTrafficType);
+    ckpt.writeRandomEngine(this->randIntraRackHost);
+    ckpt.writeRandomEngine(this->randInterRackHost);
+}
+
+void FtMixedTrafficPattern::loadState(CheckpointReader &ckpt){
+    ckpt.readRandomEngine(this->randTrafficType);
+    ckpt.readRandomEngine(this->randIntraRackHost);
+    ckpt.readRandomEngine(this->randInterRackHost);
+}
@@ -2,40 +2,53 @@
 #define TRAFFICPATTERN_H
 
 #include <random>
+#include <vector>
 #include "utils/types.hpp"
 
+struct CheckpointWriter;
+struct CheckpointReader;
+
 struct TrafficPattern
 {
     host_id_t parentHostId;
 
     TrafficPattern(host_id_t hostId) {this->parentHostId = hostId;}; 
     virtual host_id_t applyTrafficPattern() = 0;
+    /* Hybrid mode: adds rate * P(dst) to dstRates[dst] for every dst host. Only for stationary patterns. */
+    virtual void addDstRates(double rate, std::vector<double> &dstRates);
+    /* Checkpoints: the state that changes with every pkt. Nothing by default. */
+    virtual void saveState(CheckpointWriter &ckpt) {};
+    virtual void loadState(CheckpointReader &ckpt) {};
 };
 
-struct SimpleTopoTrafficPattern : TrafficPattern
+struct SimpleTopoTrafficPattern final : TrafficPattern
 {
     // Using constructor same as the base class.
     using TrafficPattern::TrafficPattern; 
     host_id_t applyTrafficPattern();
+    void addDstRates(double rate, std::vector<double> &dstRates);
 };
 
-struct AlltoAllTrafficPattern : TrafficPattern
+struct AlltoAllTrafficPattern final : TrafficPattern
 {
     host_id_t nextDst;
     
     AlltoAllTrafficPattern(host_id_t hostId);
     host_id_t applyTrafficPattern();
+    void saveState(CheckpointWriter &ckpt);
+    void loadState(CheckpointReader &ckpt);
 };
 
-struct FtUniformTrafficPattern : TrafficPattern
+struct FtUniformTrafficPattern final : TrafficPattern
 {
     host_id_t fixedDstHost;
 
     FtUniformTrafficPattern(host_id_t hostId); 
     host_id_t applyTrafficPattern();
+    void addDstRates(double rate, std::vector<double> &dstRates);
 };
 
-struct FtMixedTrafficPattern : TrafficPattern
+struct FtMixedTrafficPattern final : TrafficPattern
 {
     host_id_t rackMinId, rackMaxId;
 
@@ -45,6 +58,9 @@ struct FtMixedTrafficPattern : TrafficPattern
 
     FtMixedTrafficPattern(host_id_t hostId);
     host_id_t applyTrafficPattern();
+    void addDstRates(double rate, std::vector<double> &dstRates);
+    void saveState(CheckpointWriter &ckpt);
+    void loadState(CheckpointReader &ckpt);
 
     void initTopoInfo();
 
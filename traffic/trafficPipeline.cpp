@@ -0,0 +1,166 @@
+#include <stdexcept>
+#include <fmt/core.h>
+#include "traffic/trafficPipeline.hpp"
+#include "topology/host.hpp"
+#include "simulation/simulation.hpp"
+
+PktDescriptorRing::PktDescriptorRing(size_t capacity, trafficGenProducer* producer){
+    if(capacity == 0 || (capacity & (capacity - 1)) != 0){
+        std::string msg = fmt::format("The capacity of a PktDescriptorRing must be a power of 2. Got {}", capacity);
+        throw std::logic_error(msg);
+    }
+
+    this->slots.resize(capacity);
+    this->mask = capacity - 1;
+    this->producer = producer;
+}
+
+bool PktDescriptorRing::push(const pktDescriptor &desc){
+    uint64_t tail = this->tail.load(std::memory_order_relaxed);
+    if(tail - this->head.load(std::memory_order_acquire) == this->capacity())
+        return false;
+
+    this->slots[tail & this->mask] = desc;
+    this->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool PktDescriptorRing::pop(pktDescriptor &desc){
+    uint64_t head = this->head.load(std::memory_order_relaxed);
+    if(head == this->tail.load(std::memory_order_acquire))
+        return false;
+
+    desc = this->slots[head & this->mask];
+    // seq_cst: pairs with the sleeping flag of the producer (see TrafficGenPipeline::pop())
+    this->head.store(head + 1);
+    return true;
+}
+
+
+void TrafficGenPipeline::start(std::vector<Host*> &hosts, size_t numProducers, size_t ringCapacity){
+    if(numProducers == 0)
+        numProducers = 1;
+
+    for(size_t i = 0; i < numProducers; i++){
+        this->producers.emplace_back();
+    }
+
+    for(auto it = hosts.begin(); it != hosts.end(); it++){
+        Host* host = *it;
+        trafficGenProducer* producer = &this->producers[host->id % numProducers];
+
+        this->rings.push_back(std::unique_ptr<PktDescriptorRing>(new PktDescriptorRing(ringCapacity, producer)));
+        host->descriptorRing = this->rings.back().get();
+        producer->hosts.push_back(host);
+    }
+
+    for(auto it = this->producers.begin(); it != this->producers.end(); it++){
+        it->thread = std::thread(&TrafficGenPipeline::producerLoop, this, &*it, syndbSim);
+    }
+}
+
+/* Same RNG calls, in the same order, as Host::generateNextPkt() makes without the pipeline */
+static inline void generateDescriptor(Host* host, pktDescriptor &desc){
+    packetInfo pktInfo;
+    host->getNextPktInfo(pktInfo);
+
+    desc.size = pktInfo.size;
+    desc.sendDelay = pktInfo.sendDelay;
+    desc.dstHost = host->getNextDstHost();
+}
+
+static inline bool isBelowHalfFull(const PktDescriptorRing &ring){
+    return ring.tail.load() - ring.head.load() <= ring.capacity() / 2;
+}
+
+/* Keeps the rings of the producer full. Sleeps once all of them are more than half full. */
+void TrafficGenPipeline::producerLoop(trafficGenProducer* producer, Simulation* sim){
+    syndbSim = sim;
+    pktDescriptor desc;
+
+    while(!this->stopping){
+        bool progress = false;
+
+        for(auto it = producer->hosts.begin(); it != producer->hosts.end(); it++){
+            Host* host = *it;
+            PktDescriptorRing &ring = *host->descriptorRing;
+
+            while(ring.tail.load(std::memory_order_relaxed) - ring.head.load(std::memory_order_acquire) < ring.capacity()){
+                generateDescriptor(host, desc);
+                ring.push(desc);
+                progress = true;
+            }
+        }
+
+        if(progress)
+            continue;
+
+        std::unique_lock<std::mutex> lock(producer->mtx);
+        producer->sleeping = true;
+
+        // A consumer may have popped before it could see the flag
+        bool refill = false;
+        for(auto it = producer->hosts.begin(); it != producer->hosts.end() && !refill; it++){
+            refill = isBelowHalfFull(*(*it)->descriptorRing);
+        }
+
+        if(refill || this->stopping){
+            producer->sleeping = false;
+            continue;
+        }
+
+        producer->wakeCv.wait(lock, [&]{ return !producer->sleeping || this->stopping; });
+    }
+}
+
+void TrafficGenPipeline::wakeProducer(trafficGenProducer* producer){
+    {
+        std::lock_guard<std::mutex> lock(producer->mtx);
+        producer->sleeping = false;
+    }
+    producer->wakeCv.notify_one();
+}
+
+/* Consumer side: the next descriptor of the ring's host. Waits for the producer if it fell behind. */
+void TrafficGenPipeline::pop(PktDescriptorRing &ring, pktDescriptor &desc){
+
+    if(!ring.pop(desc)){
+        this->numEmptyPops++;
+
+        do{
+            if(ring.producer->sleeping)
+                this->wakeProducer(ring.producer);
+            std::this_thread::yield();
+        } while(!ring.pop(desc));
+    }
+
+    if(ring.producer->sleeping && isBelowHalfFull(ring))
+        this->wakeProducer(ring.producer);
+}
+
+void TrafficGenPipeline::stop(){
+    this->stopping = true;
+
+    for(auto it = this->producers.begin(); it != this->producers.end(); it++){
+        {
+            std::lock_guard<std::mutex> lock(it->mtx);
+        }
+        it->wakeCv.notify_one();
+
+        if(it->thread.joinable())
+            it->thread.join();
+    }
+}
+
+void TrafficGenPipeline::restart(){
+    this->stopping = false;
+
+    for(auto it = this->producers.begin(); it != this->producers.end(); it++){
+        it->sleeping = false;
+        it->thread = std::thread(&TrafficGenPipeline::producerLoop, this, &*it, syndbSim);
+    }
+}
+
+TrafficGenPipeline::~TrafficGenPipeline(){
+    this->stop();
+}
@@ -0,0 +1,81 @@
+#ifndef TRAFFICPIPELINE_H
+#define TRAFFICPIPELINE_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "utils/types.hpp"
+
+struct Host;
+struct Simulation;
+struct trafficGenProducer;
+
+/* The part of a host pkt that only depends on the host's own RNGs */
+struct pktDescriptor
+{
+    pkt_size_t size;
+    host_id_t dstHost; // before the sendDelay: 16B per descriptor
+    time_t sendDelay;
+};
+
+/*
+    PIPELINED_TRAFFIC_GEN: lock-free single-producer single-consumer ring of the next pkt descriptors of one host.
+    The producer is the traffic gen thread owning the host, the consumer the thread simulating the host's partition.
+*/
+struct PktDescriptorRing
+{
+    std::vector<pktDescriptor> slots; // size is a power of 2
+    size_t mask;
+    std::atomic<uint64_t> head{0}; // next slot to pop. Written by the consumer only.
+    std::atomic<uint64_t> tail{0}; // next slot to push. Written by the producer only.
+    trafficGenProducer* producer;
+
+    PktDescriptorRing(size_t capacity, trafficGenProducer* producer);
+
+    inline size_t capacity() const { return this->slots.size(); };
+    bool push(const pktDescriptor &desc); // producer side. false if full.
+    bool pop(pktDescriptor &desc); // consumer side. false if empty.
+};
+
+/* A traffic gen thread and the hosts it generates for (hostId % numProducers) */
+struct trafficGenProducer
+{
+    std::thread thread;
+    std::vector<Host*> hosts;
+    std::mutex mtx;
+    std::condition_variable wakeCv;
+    std::atomic<bool> sleeping{false}; // all rings of the producer are at least half full
+};
+
+/*
+    PIPELINED_TRAFFIC_GEN: producer threads run the traffic generators and traffic patterns of the hosts ahead of
+    simulated time, so Host::generateNextPkt() only pops a descriptor from the host's ring.
+    The timing of a pkt (link idle time, incasts) still is computed by the simulation thread when the pkt is consumed.
+    Incasts override the already consumed nextPkt of a host and never touch its RNGs, so the descriptors queued
+    behind it stay valid and the pkt stream is the same as without the pipeline.
+    Once start() was called, the trafficGen and trafficPattern of a host MUST only be used by its producer.
+*/
+struct TrafficGenPipeline
+{
+    std::deque<trafficGenProducer> producers; // not movable
+    std::vector<std::unique_ptr<PktDescriptorRing>> rings; // one per host. Host::descriptorRing points to its own.
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> numEmptyPops{0}; // stats: the simulation had to wait for a producer
+
+    void start(std::vector<Host*> &hosts, size_t numProducers, size_t ringCapacity);
+    void pop(PktDescriptorRing &ring, pktDescriptor &desc);
+    void stop();
+    void restart(); // after stop(): new threads continue to fill the rings, e.g. in a fork()ed child
+    ~TrafficGenPipeline();
+
+    private:
+    void producerLoop(trafficGenProducer* producer, Simulation* sim);
+    void wakeProducer(trafficGenProducer* producer);
+};
+
+
+#endif
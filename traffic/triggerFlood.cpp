@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/core.h>
+#include "traffic/triggerFlood.hpp"
+#include "simulation/simulation.hpp"
+#include "simulation/checkpoint.hpp"
+#include "utils/utils.hpp"
+
+/* std heaps are max-heaps */
+static bool isLaterCopy(const triggerCopy &a, const triggerCopy &b){
+    if(a.rxTime != b.rxTime)
+        return a.rxTime > b.rxTime;
+    if(a.triggerId != b.triggerId)
+        return a.triggerId > b.triggerId;
+    if(a.srcSwitchId != b.srcSwitchId)
+        return a.srcSwitchId > b.srcSwitchId;
+    return a.dstSwitchId > b.dstSwitchId;
+}
+
+TriggerFlood::TriggerFlood(){
+    #if RING_BUFFER
+    std::string msg = "ANALYTICAL_TRIGGER_FLOOD does not support RING_BUFFER: the snapshots are taken when a switch receives the trigger pkt";
+    throw std::logic_error(msg);
+    #endif
+
+    this->numCopies = 0;
+    this->numPruned = 0;
+
+    #if HOP_DELAY_NOISE
+    for(switch_id_t switchId = 0; switchId < syndbSim->topo->nextSwitchId; switchId++){
+        uint64_t seed = getRandomSeed(RandomStream::TriggerHopDelay, switchId);
+        this->randHopDelay.push_back(std::default_random_engine(seed));
+    }
+    #endif
+}
+
+/* Schedules a copy of the trigger to every neighbor of sw but srcSwitchId, like Switch::schedulePkt() does on the priority queue */
+void TriggerFlood::sendCopies(Switch* sw, trigger_id_t triggerId, switch_id_t srcSwitchId, sim_time_t time){
+
+    for(auto it = sw->neighborSwitchTable.begin(); it != sw->neighborSwitchTable.end(); it++){
+        if(it->first == srcSwitchId)
+            continue; // source pruning
+
+        NetworkLink* link = it->second;
+        sim_time_t hopDelay;
+
+        #if HOP_DELAY_NOISE
+        hopDelay = syndbConfig.minSwitchHopDelayNs + this->randHopDelay[sw->id]() % sw->hop_delay_variation;
+        #else
+        hopDelay = sw->hop_delay;
+        #endif
+
+        linkQueue &queue = link->getQueueTowards(it->first);
+        sim_time_t &qNextIdleTime = queue.nextIdleTimePriority;
+        qNextIdleTime = std::max<sim_time_t>(time + hopDelay, qNextIdleTime) + getSerializationDelay(syndbConfig.triggerPktSize, link->speed);
+        queue.byteCount += syndbConfig.triggerPktSize + 24; // +24 for on-wire PHY bits
+
+        triggerCopy copy;
+        copy.rxTime = qNextIdleTime;
+        copy.triggerId = triggerId;
+        copy.srcSwitchId = sw->id;
+        copy.dstSwitchId = it->first;
+
+        this->copies.push_back(copy);
+        std::push_heap(this->copies.begin(), this->copies.end(), isLaterCopy);
+        this->numCopies++;
+    }
+}
+
+/* Called between two ticks / at a window barrier only: TriggerInfoMap is written directly */
+void TriggerFlood::propagate(sim_time_t endTime){
+
+    while(!this->copies.empty() && this->copies.front().rxTime < endTime){
+        std::pop_heap(this->copies.begin(), this->copies.end(), isLaterCopy);
+        triggerCopy copy = this->copies.back();
+        this->copies.pop_back();
+
+        Switch* sw = syndbSim->topo->getSwitchById(copy.dstSwitchId);
+
+        if(!sw->triggerHistory.insert(copy.triggerId).second){
+            this->numPruned++;
+            continue; // already broadcast forwarded before
+        }
+
+        syndbSim->TriggerInfoMap[copy.triggerId].rxSwitchTimes[sw->id] = copy.rxTime;
+
+        this->sendCopies(sw, copy.triggerId, copy.srcSwitchId, copy.rxTime);
+    }
+}
+
+void TriggerFlood::saveState(CheckpointWriter &ckpt){
+    ckpt.write(this->numCopies);
+    ckpt.write(this->numPruned);
+    ckpt.write<uint64_t>(this->copies.size());
+    for(auto it = this->copies.begin(); it != this->copies.end(); it++){
+        ckpt.write(*it);
+    }
+    for(auto it = this->randHopDelay.begin(); it != this->randHopDelay.end(); it++){
+        ckpt.writeRandomEngine(*it);
+    }
+}
+
+void TriggerFlood::loadState(CheckpointReader &ckpt){
+    ckpt.read(this->numCopies);
+    ckpt.read(this->numPruned);
+    this->copies.resize(ckpt.read<uint64_t>());
+    for(auto it = this->copies.begin(); it != this->copies.end(); it++){
+        ckpt.read(*it);
+    }
+    for(auto it = this->randHopDelay.begin(); it != this->randHopDelay.end(); it++){
+        ckpt.readRandomEngine(*it);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef TRIGGERFLOOD_H
+#define TRIGGERFLOOD_H
+
+#include <vector>
+#include <random>
+#include "utils/types.hpp"
+
+struct Switch;
+struct CheckpointWriter;
+struct CheckpointReader;
+
+/* A flood copy of a trigger, scheduled on the priority queue of the link srcSwitchId -> dstSwitchId */
+struct triggerCopy
+{
+    sim_time_t rxTime; // at dstSwitchId
+    trigger_id_t triggerId; // (triggerId, srcSwitchId, dstSwitchId): the order of the copies received at the same time, as getTriggerPktEventKey()
+    switch_id_t srcSwitchId;
+    switch_id_t dstSwitchId;
+};
+
+/*
+    ANALYTICAL_TRIGGER_FLOOD: the trigger pkts never become events. They only share the priority queues
+    (nextIdleTimePriority) among themselves, so their flood is a shortest-time broadcast that can be computed
+    on its own: a Dijkstra-style pass over the pending copies in (rxTime, triggerId, srcSwitchId, dstSwitchId) order. A switch that sees a trigger
+    for the first time logs it in TriggerInfoMap and schedules copies to all neighbors but the sender.
+
+    The pass runs at the TriggerGen events of the main loops, up to the next trigger (or to the end), so the
+    copies of consecutive triggers contend for the priority queues like the pkts did.
+    HOP_DELAY_NOISE: the hop delays of the copies are drawn from an engine per switch of their own,
+    the switches' randHopDelay is left to the normal pkts.
+*/
+struct TriggerFlood
+{
+    std::vector<triggerCopy> copies; // min-heap on (rxTime, triggerId, srcSwitchId, dstSwitchId)
+    std::vector<std::default_random_engine> randHopDelay; // HOP_DELAY_NOISE: per switch id
+
+    uint64_t numCopies; // scheduled so far
+    uint64_t numPruned; // received by switches that had already seen the trigger
+
+    TriggerFlood(); // after the topo is built
+    void sendCopies(Switch* sw, trigger_id_t triggerId, switch_id_t srcSwitchId, sim_time_t time);
+    void propagate(sim_time_t endTime); // all copies received before endTime
+
+    void saveState(CheckpointWriter &ckpt);
+    void loadState(CheckpointReader &ckpt);
+};
+
+
+#endif
@@ -1,16 +1,18 @@
 #include <random>
 #include <chrono>
 #include <functional>
-#include <algorithm>    // std::random_shuffle
+#include <algorithm>    // std::shuffle
+#include <limits>
 #include "simulation/simulation.hpp"
 #include "traffic/triggerGenerator.hpp"
 #include "utils/logger.hpp"
+#include "utils/utils.hpp"
 #include "simulation/config.hpp"
 #include "topology/fattree_topology.hpp"
 
 
 
-TriggerGenerator::TriggerGenerator(sim_time_t switchToSwitchOWD, uint16_t totalTriggers){
+TriggerGenerator::TriggerGenerator(sim_time_t switchToSwitchOWD, trigger_id_t totalTriggers){
     // assumes the constructor will be called after the topo is built
 
     this->baseIncrement = switchToSwitchOWD;
@@ -25,16 +27,23 @@ TriggerGenerator::TriggerGenerator(sim_time_t switchToSwitchOWD, uint16_t totalT
 
     sim_time_t availableTime = totalTime - this->initialDelay;
 
-    uint16_t maxPossibleTriggers = (availableTime / this->baseIncrement) - 1;
+    uint64_t maxPossibleTriggers = (availableTime / this->baseIncrement) - 1;
 
     if(totalTriggers > maxPossibleTriggers){
         std::string msg = fmt::format("Cannot place {} triggers for total sim time of {}ms. Max triggers possible for this sim time are {}.", totalTriggers, syndbConfig.totalTimeMSecs, maxPossibleTriggers);
         throw std::logic_error(msg);
     }
 
+    // The trigger pkt keys hold the trigger id next to two switch ids (see getTriggerPktEventKey())
+    unsigned int triggerIdBits = 64 - 2 * getIdKeyBits(syndbConfig.numSwitches);
+    if(triggerIdBits < 32 && (totalTriggers >> triggerIdBits) != 0){
+        std::string msg = fmt::format("Cannot number {} triggers with {} switches: at most {}", totalTriggers, syndbConfig.numSwitches, 1ULL << triggerIdBits);
+        throw std::logic_error(msg);
+    }
+
     sim_time_t totalExtraTime = availableTime - ((this->totalTriggers + 1) * this->baseIncrement);
     sim_time_t extraTimePerTrigger = totalExtraTime / this->totalTriggers;
-    uint64_t seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed = getRandomSeed(RandomStream::TriggerExtraTime, syndbSim->branchId);
     std::default_random_engine generator(seed);
     std::uniform_int_distribution<int> extraTimeDist((extraTimePerTrigger * 9 / 10), extraTimePerTrigger);
     this->getRandomExtraTime = std::bind(extraTimeDist, generator);
@@ -43,22 +52,30 @@ TriggerGenerator::TriggerGenerator(sim_time_t switchToSwitchOWD, uint16_t totalT
 
 void TriggerGenerator::generateTrigger(){
 
-    if(this->nextTriggerTime ==  syndbSim.currTime){ // it MUST be equal
-        Switch* currSwitch = syndbSim.topo->getSwitchById(this->nextSwitchId);
+    if(this->nextTriggerTime ==  syndbSim->currTime){ // it MUST be equal
+        Switch* currSwitch = syndbSim->topo->getSwitchById(this->nextSwitchId);
         currSwitch->generateTrigger(); 
 
         this->updateNextTrigger();
+
+        #if ANALYTICAL_TRIGGER_FLOOD
+        // The flood is done before the next trigger is generated. Nothing is received after the end of the simulation.
+        this->flood.propagate(std::min(this->nextTriggerTime, syndbSim->totalTime + 1));
+        #endif
     }
 
 }
 
 void TriggerGenerator::updateNextTrigger(){
-    static auto nextTrigger = this->triggerSchedule.begin();
+    if(this->nextTrigger == this->triggerSchedule.end()){ // no more triggers left
+        this->nextTriggerTime = std::numeric_limits<sim_time_t>::max();
+        return;
+    }
 
-    this->nextTriggerTime = nextTrigger->time;
-    this->nextSwitchId    = nextTrigger->switchId;
+    this->nextTriggerTime = this->nextTrigger->time;
+    this->nextSwitchId    = this->nextTrigger->switchId;
 
-    nextTrigger++;
+    this->nextTrigger++;
 }
 
 /* 
@@ -66,14 +83,14 @@ void TriggerGenerator::updateNextTrigger(){
 */
 TriggerGeneratorSimpleTopo::TriggerGeneratorSimpleTopo():TriggerGenerator::TriggerGenerator(2012, syndbConfig.numTriggersPerSwitchType){  
 
-    sim_time_t halfSimTimeIncrement = syndbSim.timeIncrement / 2;
+    sim_time_t halfSimTimeIncrement = syndbSim->timeIncrement / 2;
     sim_time_t currBaseTime = this->initialDelay + this->baseIncrement;
     sim_time_t nextTime;
     switch_id_t nextSwitch;
 
-    uint64_t seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed = getRandomSeed(RandomStream::TriggerSwitch, syndbSim->branchId);
     std::default_random_engine generator(seed);
-    std::uniform_int_distribution<int> switchSelectDist(0, syndbSim.topo->nextSwitchId-1);
+    std::uniform_int_distribution<int> switchSelectDist(0, syndbSim->topo->nextSwitchId-1);
     auto getRandomSwitchId = std::bind(switchSelectDist, std::ref(generator));
 
     for(int i=0; i < this->totalTriggers; i++){
@@ -82,7 +99,7 @@ TriggerGeneratorSimpleTopo::TriggerGeneratorSimpleTopo():TriggerGenerator::Trigg
         nextSwitch = getRandomSwitchId();
         nextTime = currBaseTime + this->getRandomExtraTime();
         // round nextTime to nearest simulator increment
-        nextTime = ((nextTime + halfSimTimeIncrement) / syndbSim.timeIncrement) * syndbSim.timeIncrement;
+        nextTime = ((nextTime + halfSimTimeIncrement) / syndbSim->timeIncrement) * syndbSim->timeIncrement;
 
         newScheduleInfo.time = nextTime;
         newScheduleInfo.switchId = nextSwitch;
@@ -94,13 +111,14 @@ TriggerGeneratorSimpleTopo::TriggerGeneratorSimpleTopo():TriggerGenerator::Trigg
         currBaseTime = nextTime + this->baseIncrement;
     }
 
+    this->nextTrigger = this->triggerSchedule.begin();
     this->updateNextTrigger();
 }
 
 TriggerGeneratorLineTopo::TriggerGeneratorLineTopo():TriggerGenerator::TriggerGenerator(8876, syndbConfig.numTriggersPerSwitchType){
     // 8876: 4 x 2219. 2219 is one-hop delay for 1500B pkt on a 10G link
 
-    sim_time_t halfSimTimeIncrement = syndbSim.timeIncrement / 2;
+    sim_time_t halfSimTimeIncrement = syndbSim->timeIncrement / 2;
     sim_time_t currBaseTime = this->initialDelay + this->baseIncrement;
     sim_time_t nextTime, randomExtraTime; 
     switch_id_t nextSwitch;
@@ -113,7 +131,7 @@ TriggerGeneratorLineTopo::TriggerGeneratorLineTopo():TriggerGenerator::TriggerGe
         randomExtraTime = this->getRandomExtraTime();
         nextTime = currBaseTime + randomExtraTime;
         // round nextTime to nearest simulator increment
-        nextTime = ((nextTime + halfSimTimeIncrement) / syndbSim.timeIncrement) * syndbSim.timeIncrement;
+        nextTime = ((nextTime + halfSimTimeIncrement) / syndbSim->timeIncrement) * syndbSim->timeIncrement;
 
         newScheduleInfo.time = nextTime;
         newScheduleInfo.switchId = nextSwitch;
@@ -125,6 +143,7 @@ TriggerGeneratorLineTopo::TriggerGeneratorLineTopo():TriggerGenerator::TriggerGe
         currBaseTime = nextTime + this->baseIncrement;
     }
 
+    this->nextTrigger = this->triggerSchedule.begin();
     this->updateNextTrigger();
 
 }
@@ -146,7 +165,7 @@ void TriggerGenerator::printTriggerSchedule(){
 */
 TriggerGeneratorFatTreeTopo::TriggerGeneratorFatTreeTopo():TriggerGenerator::TriggerGenerator(4024, 3 * syndbConfig.numTriggersPerSwitchType){  
 
-    std::shared_ptr<FattreeTopology> fatTreeTopo = std::dynamic_pointer_cast<FattreeTopology>(syndbSim.topo);
+    std::shared_ptr<FattreeTopology> fatTreeTopo = std::dynamic_pointer_cast<FattreeTopology>(syndbSim->topo);
 
     std::vector<switch_id_t> coreSwitches(fatTreeTopo->switchTypeIDMap[SwitchType::FtCore].begin(),fatTreeTopo->switchTypeIDMap[SwitchType::FtCore].end()); 
     std::vector<switch_id_t> aggrSwitches(fatTreeTopo->switchTypeIDMap[SwitchType::FtAggr].begin(),fatTreeTopo->switchTypeIDMap[SwitchType::FtAggr].end()); 
@@ -155,12 +174,12 @@ TriggerGeneratorFatTreeTopo::TriggerGeneratorFatTreeTopo():TriggerGenerator::Tri
     // debug_print_yellow("Initialized vectors of switchID");
     // debug_print("Total switches: {} core, {} aggr, {} tor", coreSwitches.size(), aggrSwitches.size(), torSwitches.size());
 
-    sim_time_t halfSimTimeIncrement = syndbSim.timeIncrement / 2;
+    sim_time_t halfSimTimeIncrement = syndbSim->timeIncrement / 2;
     sim_time_t currBaseTime = this->initialDelay + this->baseIncrement;
     sim_time_t nextTime, randomExtraTime;
     switch_id_t nextSwitch;
 
-    uint64_t seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t seed = getRandomSeed(RandomStream::TriggerSwitch, syndbSim->branchId);
     std::default_random_engine generator(seed);
     std::uniform_int_distribution<int> torSelectDist(0, torSwitches.size()-1);
     std::uniform_int_distribution<int> aggrSelectDist(0, aggrSwitches.size()-1);
@@ -181,7 +200,7 @@ TriggerGeneratorFatTreeTopo::TriggerGeneratorFatTreeTopo():TriggerGenerator::Tri
     for(int i=0; i < syndbConfig.numTriggersPerSwitchType; i++)
         nextSwitchIds.push_back(coreSwitches[getRandomCoreSwitchIdx()]);
 
-    std::random_shuffle(nextSwitchIds.begin(), nextSwitchIds.end());
+    std::shuffle(nextSwitchIds.begin(), nextSwitchIds.end(), generator);
     
     for(int i=0; i < nextSwitchIds.size(); i++){
         
@@ -191,7 +210,7 @@ TriggerGeneratorFatTreeTopo::TriggerGeneratorFatTreeTopo():TriggerGenerator::Tri
         randomExtraTime = this->getRandomExtraTime();
         nextTime = currBaseTime + randomExtraTime;
         // round nextTime to nearest simulator increment
-        nextTime = ((nextTime + halfSimTimeIncrement) / syndbSim.timeIncrement) * syndbSim.timeIncrement;
+        nextTime = ((nextTime + halfSimTimeIncrement) / syndbSim->timeIncrement) * syndbSim->timeIncrement;
 
         newScheduleInfo.time = nextTime;
         newScheduleInfo.switchId = nextSwitch;
@@ -203,6 +222,7 @@ TriggerGeneratorFatTreeTopo::TriggerGeneratorFatTreeTopo():TriggerGenerator::Tri
         currBaseTime = nextTime + this->baseIncrement;
     }
 
+    this->nextTrigger = this->triggerSchedule.begin();
     this->updateNextTrigger();
 
 }
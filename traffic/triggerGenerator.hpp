@@ -4,6 +4,7 @@
 #include <functional>
 #include "utils/types.hpp"
 #include "simulation/config.hpp"
+#include "traffic/triggerFlood.hpp"
 
 struct triggerInfo {
     sim_time_t triggerOrigTime;
@@ -21,14 +22,19 @@ struct TriggerGenerator
     std::list<triggerScheduleInfo> triggerSchedule;    
     const sim_time_t initialDelay = syndbConfig.triggerInitialDelay; // 10us - for both topologies
     sim_time_t baseIncrement; // set to topology's switchToSwitchOWD
-    uint16_t totalTriggers;
+    trigger_id_t totalTriggers;
     sim_time_t totalExtraTime;
     std::function<int()> getRandomExtraTime;
     
     sim_time_t nextTriggerTime;
     switch_id_t nextSwitchId;
+    std::list<triggerScheduleInfo>::iterator nextTrigger; // schedule entry after the lined-up one
+
+    #if ANALYTICAL_TRIGGER_FLOOD
+    TriggerFlood flood; // the trigger pkts in flight
+    #endif
   
-    TriggerGenerator(sim_time_t switchToSwitchOWD, uint16_t totalTriggers);
+    TriggerGenerator(sim_time_t switchToSwitchOWD, trigger_id_t totalTriggers);
     void generateTrigger();
     void updateNextTrigger();
     void printTriggerSchedule();
@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+/*
+    A fixed number of objects in one allocation, constructed in place by create(). The slots are independent:
+    threads may create different ones at the same time. The objects that were created are destroyed with the arena.
+    shared_ptrs to the objects alias the shared_ptr of the arena (see FattreeTopology), so that they need no allocation of their own.
+*/
+template<typename T>
+struct ObjectArena
+{
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot_t;
+
+    std::unique_ptr<slot_t[]> slots;
+    std::vector<uint8_t> created; // bytes, not bits: written by several threads
+    size_t capacity;
+
+    inline ObjectArena(size_t capacity) : slots(new slot_t[capacity]), created(capacity, 0){
+        this->capacity = capacity;
+    };
+
+    ObjectArena(const ObjectArena&) = delete;
+    ObjectArena& operator=(const ObjectArena&) = delete;
+
+    template<typename... Args>
+    inline T* create(size_t idx, Args&&... args){
+        T* obj = new (&this->slots[idx]) T(std::forward<Args>(args)...);
+        this->created[idx] = 1;
+        return obj;
+    };
+
+    inline T* get(size_t idx){
+        return reinterpret_cast<T*>(&this->slots[idx]);
+    };
+
+    ~ObjectArena(){
+        for(size_t i = 0; i < this->capacity; i++){
+            if(this->created[i])
+                this->get(i)->~T();
+        }
+    };
+};
+
+
+#endif
@@ -32,7 +32,8 @@ void ndebug_print(const std::string &format, const Args&... args){
     std::string msg = fmt::format(format, args...);
 
     #if LOGGING
-        syndbSim.pktDumper->logSimSummary(msg);
+    if(syndbSim != NULL)
+        syndbSim->pktDumper->logSimSummary(msg);
     #endif
 
     fmt::print(msg);
@@ -45,7 +46,8 @@ void ndebug_print_yellow(const std::string &format, const Args&... args){
     std::string msg = fmt::format(format, args...);
 
     #if LOGGING
-        syndbSim.pktDumper->logSimSummary(msg);
+    if(syndbSim != NULL)
+        syndbSim->pktDumper->logSimSummary(msg);
     #endif
     
     fmt::print(fg(fmt::color::yellow), msg);
@@ -1,6 +1,11 @@
 #include <iostream>
 #include <ctime>
 #include <typeinfo>
+#include <thread>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
 
 #include "utils/pktdumper.hpp"
 #include "utils/logger.hpp"
@@ -10,44 +15,198 @@
 
 
 
-void PktDumper::openFiles(switch_id_t numberOfSwitches, host_id_t numberOfHosts) {
-    // create date-time string to use in the prefix string
-    std::time_t currentTime = std::time(nullptr);
-    std::string dateTimeString = fmt::format("{:%Y-%m-%d}_{:%H.%M.%S}", fmt::localtime(currentTime), fmt::localtime(currentTime));
+void PktDumper::openFiles(switch_id_t numberOfSwitches, host_id_t numberOfHosts, const std::string &prefix) {
+    if(prefix.empty()){
+        if(!syndbConfig.dumpPrefix.empty()){
+            this->prefixStringForFileName = syndbConfig.dumpPrefix;
+        }
+        else{
+            // create date-time string to use in the prefix string
+            std::time_t currentTime = std::time(nullptr);
+            std::string dateTimeString = fmt::format("{:%Y-%m-%d}_{:%H.%M.%S}", fmt::localtime(currentTime), fmt::localtime(currentTime));
+            this->prefixStringForFileName = "dump_" + dateTimeString + "_";
+        }
+        if(syndbSim->replicaId > 0)
+            this->prefixStringForFileName += fmt::format("replica{}_", syndbSim->replicaId);
+        if(syndbSim->hybridReference)
+            this->prefixStringForFileName += "full_";
+        if(syndbSim->timeWindowId > 0)
+            this->prefixStringForFileName += fmt::format("window{}_", syndbSim->timeWindowId);
+    }
+    else{
+        this->prefixStringForFileName = prefix;
+    }
 
     // clear stpdlog default pattern
     debug_print("Clearing default spdlog dump pattern.");
     spdlog::set_pattern("%v");
-    spdlog::init_thread_pool(QUEUE_SIZE, 1);
-
-    
-    this->prefixStringForFileName = "dump_" + dateTimeString + "_";
+    // Ensemble mode: the logging thread is started by the main thread, before the replicas open their files
+    if(spdlog::thread_pool() == nullptr)
+        spdlog::init_thread_pool(QUEUE_SIZE, 1);
 
+    // Logger names are unique per process: they are prefixed like the file names
     std::string simSummaryFileName = "./data/" + prefixStringForFileName + "summary.txt";
-    this->simSummaryFilePointer = spdlog::basic_logger_mt("summary", simSummaryFileName);
+    this->simSummaryFilePointer = spdlog::basic_logger_mt(prefixStringForFileName + "summary", simSummaryFileName);
 
     // open all file pointers in write/output mode
     std::string triggerFileName = "./data/" + prefixStringForFileName + "trigger.txt";
-    this->triggerFilePointer = spdlog::basic_logger_mt<spdlog::async_factory>("trigger", triggerFileName);
+    this->triggerFilePointer = spdlog::basic_logger_mt<spdlog::async_factory>(prefixStringForFileName + "trigger", triggerFileName);
 
     std::string incastFileName = "./data/" + prefixStringForFileName + "incast.txt";
-    this->incastFilePointer = spdlog::basic_logger_mt<spdlog::async_factory>("incast", incastFileName);
+    this->incastFilePointer = spdlog::basic_logger_mt<spdlog::async_factory>(prefixStringForFileName + "incast", incastFileName);
 
     std::string sourceDestinationFile = "./data/" + prefixStringForFileName + "sourceDestination.txt";
-    this->sourceDestinationFilePointer = spdlog::basic_logger_mt<spdlog::async_factory>("sourceDestination", sourceDestinationFile);
+    this->sourceDestinationFilePointer = spdlog::basic_logger_mt<spdlog::async_factory>(prefixStringForFileName + "sourceDestination", sourceDestinationFile);
 
     debug_print("Number of Switches: {}", numberOfSwitches);
     for (int i = 0; i < numberOfSwitches; i++) {
         std::string fileName = "./data/"+ prefixStringForFileName + "switch_" + std::to_string(i) + ".txt";
-        auto file = spdlog::basic_logger_mt<spdlog::async_factory>("switch_" + std::to_string(i), fileName);
+        auto file = spdlog::basic_logger_mt<spdlog::async_factory>(prefixStringForFileName + "switch_" + std::to_string(i), fileName);
         this->switchFilePointers.push_back(std::move(file));
     }
+    this->switchFileLines.assign(numberOfSwitches, 0);
 
     debug_print("Number of Hosts: {}", numberOfHosts);
 
     ndebug_print("PktDump file prefix: {}", this->prefixStringForFileName);
 }
 
+/* Cuts a dump file back to its first numLines lines */
+static void truncateToLines(const std::string &fileName, uint64_t numLines){
+    std::ifstream file(fileName, std::ios::binary);
+    if(!file.is_open()){
+        std::string msg = fmt::format("Cannot open dump file {} of the checkpointed run", fileName);
+        throw std::logic_error(msg);
+    }
+
+    uint64_t offset = 0, lines = 0;
+    std::vector<char> buffer(1 << 20);
+
+    while(lines < numLines && file){
+        file.read(buffer.data(), buffer.size());
+        std::streamsize numRead = file.gcount();
+
+        for(std::streamsize i = 0; i < numRead && lines < numLines; i++){
+            offset++;
+            if(buffer[i] == '\n')
+                lines++;
+        }
+    }
+
+    if(lines < numLines){
+        std::string msg = fmt::format("Dump file {} has {} lines, but had {} at the checkpoint", fileName, lines, numLines);
+        throw std::logic_error(msg);
+    }
+    file.close();
+
+    if(truncate(fileName.c_str(), offset) != 0){
+        std::string msg = fmt::format("Failed to truncate dump file {}", fileName);
+        throw std::logic_error(msg);
+    }
+}
+
+/*
+    Restored run: the files were opened with the prefix of the checkpointed run, in append mode, and nothing was written to them yet.
+    Drops what the checkpointed run wrote after the checkpoint. The summary file is kept as it is.
+*/
+void PktDumper::truncateFiles(){
+    truncateToLines("./data/" + this->prefixStringForFileName + "trigger.txt", this->triggerFileLines);
+    truncateToLines("./data/" + this->prefixStringForFileName + "incast.txt", this->incastFileLines);
+    truncateToLines("./data/" + this->prefixStringForFileName + "sourceDestination.txt", this->sourceDestinationFileLines);
+    for (size_t i = 0; i < this->switchFileLines.size(); i++) {
+        truncateToLines("./data/" + this->prefixStringForFileName + "switch_" + std::to_string(i) + ".txt", this->switchFileLines[i]);
+    }
+}
+
+void PktDumper::flushFiles(){
+    this->simSummaryFilePointer->flush();
+    this->triggerFilePointer->flush();
+    this->incastFilePointer->flush();
+    this->sourceDestinationFilePointer->flush();
+    for (auto it = this->switchFilePointers.begin(); it != this->switchFilePointers.end(); it++) {
+        (*it)->flush();
+    }
+
+    // The flushes are queued behind the lines on the async logging thread
+    while(spdlog::thread_pool()->queue_size() > 0)
+        std::this_thread::yield();
+}
+
+/* Names of the dump files, without the "./data/" + prefix part */
+std::vector<std::string> PktDumper::getFileNames(){
+    std::vector<std::string> fileNames = {"summary.txt", "trigger.txt", "incast.txt", "sourceDestination.txt"};
+    for (size_t i = 0; i < this->switchFileLines.size(); i++) {
+        fileNames.push_back("switch_" + std::to_string(i) + ".txt");
+    }
+    return fileNames;
+}
+
+void PktDumper::closeFiles(){
+    this->flushFiles();
+
+    // A process fork()ed after this copies that much: the parent may already write on when the copy is made
+    std::vector<std::string> fileNames = this->getFileNames();
+    this->closedFileSizes.clear();
+    for(auto it = fileNames.begin(); it != fileNames.end(); it++){
+        struct stat fileStat;
+        std::string fileName = "./data/" + this->prefixStringForFileName + *it;
+        if(stat(fileName.c_str(), &fileStat) != 0){
+            std::string msg = fmt::format("Cannot stat dump file {}", fileName);
+            throw std::logic_error(msg);
+        }
+        this->closedFileSizes.push_back(fileStat.st_size);
+    }
+
+    this->triggerFilePointer.reset();
+    this->incastFilePointer.reset();
+    this->sourceDestinationFilePointer.reset();
+    this->simSummaryFilePointer.reset();
+    this->switchFilePointers.clear();
+
+    // Joins the logging thread and drops the loggers from the registry
+    spdlog::shutdown();
+}
+
+/* Copies the first size bytes of a dump file */
+static void copyDumpFile(const std::string &fromName, const std::string &toName, uint64_t size){
+    std::ifstream from(fromName, std::ios::binary);
+    std::ofstream to(toName, std::ios::binary | std::ios::trunc);
+    if(!from.is_open() || !to.is_open()){
+        std::string msg = fmt::format("Failed to copy dump file {} to {}", fromName, toName);
+        throw std::logic_error(msg);
+    }
+
+    std::vector<char> buffer(1 << 20);
+    while(size > 0){
+        from.read(buffer.data(), std::min<uint64_t>(size, buffer.size()));
+        std::streamsize numRead = from.gcount();
+        if(numRead <= 0)
+            break;
+        to.write(buffer.data(), numRead);
+        size -= numRead;
+    }
+
+    if(size > 0 || !to){
+        std::string msg = fmt::format("Failed to copy dump file {} to {}", fromName, toName);
+        throw std::logic_error(msg);
+    }
+}
+
+/* The files are opened in append mode, so the line counts carry on */
+void PktDumper::reopenFiles(const std::string &prefix){
+    std::vector<uint64_t> switchFileLines = this->switchFileLines;
+
+    if(prefix != this->prefixStringForFileName){
+        std::vector<std::string> fileNames = this->getFileNames();
+        for(size_t i = 0; i < fileNames.size(); i++){
+            copyDumpFile("./data/" + this->prefixStringForFileName + fileNames[i], "./data/" + prefix + fileNames[i], this->closedFileSizes[i]);
+        }
+    }
+
+    this->openFiles(switchFileLines.size(), 0, prefix);
+    this->switchFileLines = switchFileLines;
+}
+
 
 PktDumper::~PktDumper() {
     // close all file pointers
@@ -67,11 +226,13 @@ void PktDumper::dumpPacket(const normalpkt_p pkt){
     debug_print("Start Time: {}", pkt->startTime);
     debug_print("End Time: {}", pkt->endTime);
     this->sourceDestinationFilePointer->info("{}\t{}\t{}", pkt->id, pkt->srcHost, pkt->dstHost);
+    this->sourceDestinationFileLines++;
 
     debug_print_yellow("-------   SWITCHES   ---------");
     std::list<switchINTInfo>::iterator switchTimeStampsIterator;
     for (switchTimeStampsIterator = pkt->switchINTInfoList.begin(); switchTimeStampsIterator != pkt->switchINTInfoList.end(); switchTimeStampsIterator++) {
         this->switchFilePointers[switchTimeStampsIterator->swId]->info("{}\t{}", switchTimeStampsIterator->rxTime, pkt->id);
+        this->switchFileLines[switchTimeStampsIterator->swId]++;
     }
 
 }
@@ -87,10 +248,12 @@ void PktDumper::dumpTriggerInfo(const trigger_id_t &triggerId, triggerInfo &tinf
     }
 
     this->triggerFilePointer->info("{}", stringForTriggerFile);
+    this->triggerFileLines++;
 }
 
 void PktDumper::dumpIncastInfo(const incastScheduleInfo &incastInfo){
     this->incastFilePointer->info("{}\t{}", incastInfo.time, incastInfo.targetHostId);
+    this->incastFileLines++;
 }
 
 void PktDumper::logSimSummary(const std::string &msg){
@@ -28,10 +28,20 @@
     std::shared_ptr<spdlog::logger> triggerFilePointer, sourceDestinationFilePointer, incastFilePointer, simSummaryFilePointer;
     std::vector<std::shared_ptr<spdlog::logger>> switchFilePointers;
 
+    // Lines written to each file. A checkpoint records them, so a restored run can drop what was written after it.
+    uint64_t triggerFileLines = 0, sourceDestinationFileLines = 0, incastFileLines = 0;
+    std::vector<uint64_t> switchFileLines;
+    std::vector<uint64_t> closedFileSizes; // bytes in each file of getFileNames() at closeFiles()
+
     ~PktDumper();
     PktDumper() = default;
     
-    void openFiles(switch_id_t numberOfSwitches, host_id_t numberOfHosts);
+    void openFiles(switch_id_t numberOfSwitches, host_id_t numberOfHosts, const std::string &prefix = ""); // prefix: of a checkpointed run, to append to its files
+    void truncateFiles(); // restored run: back to the line counts of the checkpoint
+    void flushFiles(); // waits until all logged lines are written to the files
+    std::vector<std::string> getFileNames();
+    void closeFiles(); // before fork(): flushes and stops the async logging thread
+    void reopenFiles(const std::string &prefix); // after closeFiles(). A new prefix gets a copy of the files written so far.
     void dumpPacket(const normalpkt_p pkt);
     void dumpTriggerInfo(const trigger_id_t &triggerId, triggerInfo &tinfo, const SwitchType &switchType);
     void dumpIncastInfo(const incastScheduleInfo &incastInfo);
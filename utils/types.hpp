@@ -12,10 +12,10 @@ typedef uint16_t pkt_size_t;
 typedef uint64_t pkt_id_t;
 
 /* Host related types */
-typedef uint16_t host_id_t;
+typedef uint32_t host_id_t;
 
 /* Switch related types */
-typedef uint16_t switch_id_t;
+typedef uint32_t switch_id_t;
 
 /* Link Related Types */
 typedef uint8_t link_speed_gbps_t;
@@ -25,14 +25,19 @@ typedef uint64_t byte_count_t;
 /* TrafficGen Related Types */
 typedef uint8_t load_t;
 
+/* Parallel engine Related Types */
+typedef uint16_t partition_id_t;
+
 /* SyNDB Related Types */
-typedef uint16_t trigger_id_t;
+typedef uint32_t trigger_id_t;
 typedef int32_t ringbuffer_index_t;
 
 /* Fat Tree Related Types */
-typedef uint8_t pod_id_t;
-typedef uint8_t ft_scale_t;
-typedef uint8_t racklocal_host_id_t;
+typedef uint8_t pod_id_t; // < k
+typedef uint8_t ft_scale_t; // k <= 254: up to 4M hosts
+typedef uint8_t racklocal_host_id_t; // < k/2
+typedef uint8_t ft_port_t; // egress port of a switch, < k
+typedef uint32_t ft_path_t; // the egress ports of up to 5 hops, see topology/ft_paths.hpp
 
 
 typedef union {
@@ -42,7 +47,7 @@ typedef union {
 
 enum class syndb_status_t {success, failure};
 
-enum class TopologyType {Simple, FatTree, Line}; 
+enum class TopologyType {Simple, FatTree, Line, File}; 
 enum class TrafficPatternType {SimpleTopo, AlltoAll, FtUniform, FtMixed};
 enum class TrafficGenType {Continuous, Distribution};
 enum class TrafficDstType {IntraRack, InterRack};
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <fmt/core.h>
+#include "utils/utils.hpp"
+#include "simulation/simulation.hpp"
+
+uint64_t getRandomSeed(RandomStream stream, uint64_t entityId){
+    uint64_t randomSeed = syndbSim->randomSeed;
+
+    if(randomSeed == 0){
+        // Mixed with the stream and entity like the others: seeds taken within the same clock tick still differ
+        randomSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    }
+    else{
+        // Time-parallel mode: the windows share the trigger/incast schedules, but not the traffic and the hop delays
+        bool scheduleStream = stream == RandomStream::TriggerExtraTime || stream == RandomStream::TriggerSwitch
+                                || stream == RandomStream::IncastTargets || stream == RandomStream::IncastSources;
+        if(syndbSim->timeWindowId > 1 && !scheduleStream)
+            randomSeed += 0xd1b54a32d192ed03ULL * (syndbSim->timeWindowId - 1);
+    }
+
+    // splitmix64 finalizer over (randomSeed, stream, entityId)
+    uint64_t z = randomSeed + 0x9e3779b97f4a7c15ULL * (((uint64_t)stream << 32) + entityId + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+unsigned int parallelFor(uint64_t numItems, unsigned int numThreads, const std::function<void(uint64_t)> &fn){
+    if(numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::max<uint64_t>(1, std::min<uint64_t>(numThreads, numItems));
+
+    if(numThreads == 1){
+        for(uint64_t i = 0; i < numItems; i++)
+            fn(i);
+        return 1;
+    }
+
+    Simulation* sim = syndbSim;
+    std::vector<std::exception_ptr> errors(numThreads);
+    std::vector<std::thread> threads;
+
+    for(unsigned int w = 0; w < numThreads; w++){
+        threads.push_back(std::thread([sim, w, numItems, numThreads, &fn, &errors]{
+            syndbSim = sim;
+            try{
+                for(uint64_t i = w; i < numItems; i += numThreads)
+                    fn(i);
+            }
+            catch(...){
+                errors[w] = std::current_exception();
+            }
+        }));
+    }
+    for(auto it = threads.begin(); it != threads.end(); it++)
+        it->join();
+
+    for(auto it = errors.begin(); it != errors.end(); it++){
+        if(*it)
+            std::rethrow_exception(*it);
+    }
+    return numThreads;
+}
+
+PhaseTimer::PhaseTimer(){
+    this->start = std::chrono::steady_clock::now();
+    this->last = this->start;
+}
+
+void PhaseTimer::endPhase(const std::string &name){
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    this->phases.push_back(std::make_pair(name, std::chrono::duration<double, std::milli>(now - this->last).count()));
+    this->last = now;
+}
+
+std::string PhaseTimer::format() const {
+    std::string str;
+    for(auto it = this->phases.begin(); it != this->phases.end(); it++)
+        str += fmt::format("{} {:.0f}ms | ", it->first, it->second);
+    return str + fmt::format("total {:.0f}ms", std::chrono::duration<double, std::milli>(this->last - this->start).count());
+}
@@ -1,12 +1,58 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
 #include "utils/types.hpp"
+#include "simulation/config.hpp"
 
 inline sim_time_t getSerializationDelay(pkt_size_t pktSize, link_speed_gbps_t linkSpeed){
     pkt_size_t size_on_wire = pktSize + 24;
     return ((size_on_wire * 8) / linkSpeed);
 }
 
+/* Independent streams of random numbers. Each user of a random engine gets its own. */
+enum class RandomStream {SwitchHopDelay, PktSize, PktDelay, TrafficType, IntraRackHost, InterRackHost, TriggerExtraTime, TriggerSwitch, IncastTargets, IncastSources, TriggerHopDelay};
+
+/* 
+    Seed for the random engine of a stream on an entity (host/switch id, what-if branch id for the schedules, or 0).
+    With a random seed of 0, seeds come from the clock (mixed with stream and entity). Otherwise they are derived from the random seed
+    of the simulation (syndbConfig.randomSeed, or that of the ensemble replica) only, which makes runs repeatable
+    regardless of the engine and the thread timings.
+*/
+uint64_t getRandomSeed(RandomStream stream, uint64_t entityId = 0);
+
+/*
+    Width of an id field in the packed 64-bit sort keys: NormalPkt::orderKey (genTime, srcHost) and the trigger pkt keys
+    (triggerId, srcSwitch, dstSwitch). 16 bits as long as the ids fit, like with the former 16-bit ids, so the keys
+    and the order of the events stay the same. Only topologies with more than 64K hosts/switches get wider fields.
+*/
+inline unsigned int getIdKeyBits(uint64_t numIds){
+    unsigned int bits = 16;
+    while(bits < 32 && ((numIds - 1) >> bits) != 0)
+        bits++;
+    return bits;
+}
+
+/*
+    Runs fn(i) for all i in [0, numItems) on numThreads threads (0: one per core), item i on thread i % numThreads.
+    The threads run on the Simulation of the caller. An exception of a thread is rethrown once all are done.
+    Returns the number of threads used.
+*/
+unsigned int parallelFor(uint64_t numItems, unsigned int numThreads, const std::function<void(uint64_t)> &fn);
+
+/* Wall clock time of consecutive phases, e.g. of the startup. Each endPhase() ends the phase that began at the previous one. */
+struct PhaseTimer
+{
+    std::chrono::steady_clock::time_point start, last;
+    std::vector<std::pair<std::string, double>> phases; // name, ms
+
+    PhaseTimer();
+    void endPhase(const std::string &name);
+    std::string format() const; // "name 12ms | name 3ms | total 15ms"
+};
+
 
 #endif